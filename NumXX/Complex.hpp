@@ -458,6 +458,21 @@ template <typename T>
 using underlying_type_t = typename underlying_type<T>::type;
 
 
+// Promotes integral types (and complex integral types) to double, leaving floating types as they are
+template <typename T>
+struct floating_type {
+    using type = std::conditional_t<std::is_floating_point_v<T>, T, double>;
+};
+
+template <typename T>
+struct floating_type<complex<T>> {
+    using type = complex<typename floating_type<T>::type>;
+};
+
+template <typename T>
+using floating_type_t = typename floating_type<T>::type;
+
+
 constexpr complex<double> operator""_j(const long double value) {
     return {0,static_cast<double>(value)};
 }
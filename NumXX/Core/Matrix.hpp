@@ -180,12 +180,12 @@ public:
         if (!are_multipliable(*this, other)) {
             throw error::ShapeError(this->_shape, other.get_shape(), "multiply");
         }
-        auto out_data = util::matmul<dtype, T>(
+        Matrix<U> out(Shape::get_product_shape(this->_shape, other.get_shape()));
+        util::matmul(
             this->_data_ptr.get(), this->_shape,
-            other.get_data(), other.get_shape()
+            other.get_data(), other.get_shape(), out.get_data()
         );
-        auto out_shape = Shape::get_product_shape(this->_shape, other.get_shape());
-        return Matrix<U>(std::move(out_data), out_shape);
+        return out;
     }
 
     template <typename T>
@@ -202,12 +202,12 @@ public:
         // Check if it's a valid 2D NArray that can be treated as a matrix
         if(are_multipliable(*this, other)) {
             // Treat the NArray as a matrix for multiplication
-            auto out_data = util::matmul<dtype, T>(
+            Matrix<U> out(Shape::get_product_shape(this->_shape, other.get_shape()));
+            util::matmul(
                 this->get_data(), this->get_shape(),
-                other.get_data(), other.get_shape()
+                other.get_data(), other.get_shape(), out.get_data()
             );
-            auto out_shape = Shape::get_product_shape(this->_shape, other.get_shape());
-            return Matrix<U>(std::move(out_data), out_shape);
+            return out;
         }
         
         throw error::ShapeError(this->_shape, other.get_shape(), "multiply");
@@ -217,18 +217,19 @@ public:
 
     /* ====== Helper Functions ====== */
 
-    // Checks if two matrices can be multiplied
+    // Checks if two matrices can be multiplied (stacks of matrices cannot form a Matrix)
     template <typename T, typename U>
     static bool are_multipliable(const NArray<T>& lmat, const NArray<U>& rmat) {
-        return static_cast<bool>(Shape::get_matmul_type(lmat.get_shape(), rmat.get_shape()));
+        const MatmulType type = Shape::get_matmul_type(lmat.get_shape(), rmat.get_shape());
+        return type != MatmulType::Invalid && type != MatmulType::Batched;
     }
 
 
     // Does what the name says
     Matrix transpose() {
         auto out_shape = this->_shape.transpose();
-        auto out_data_ptr = this->get_data_copy_as_shared_ptr();
-        util::transpose(out_data_ptr.get(), this->_shape);
+        std::shared_ptr<dtype> out_data_ptr(new dtype[this->_shape.get_total_size()], std::default_delete<dtype[]>());
+        util::transpose(out_data_ptr.get(), this->_data_ptr.get(), this->_shape);
         return Matrix(out_data_ptr, out_shape);
     }
 
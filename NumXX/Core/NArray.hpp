@@ -894,6 +894,15 @@ public:
     [[nodiscard]] NArray T() const { return transpose(); }
 
 
+    // Transposes the matrix in place, without allocating a new buffer (views of the data see the change)
+    NArray& transpose_inplace() {
+        auto out_shape = _shape.transpose();
+        util::transpose(_data_ptr.get(), _shape);
+        _shape = std::move(out_shape);
+        return *this;
+    }
+
+
     // Returns a new flat vector
     [[nodiscard]] NArray flatten() const {
         if (_shape.get_Ndim() == 1) return NArray(*this);
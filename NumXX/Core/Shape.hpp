@@ -14,7 +14,8 @@ enum class MatmulType {
     Dot,
     RowMat,
     MatCol,
-    MatMat
+    MatMat,
+    Batched
 }; // enum class MatmulType
 
 
@@ -153,20 +154,53 @@ struct Shape {
             return Shape(lshape[0]);
         case MatmulType::MatMat:
             return Shape({lshape[0], rshape[1]});
+        case MatmulType::Batched: {
+            std::vector<size_t> dims;
+            broadcast_batch_dims(lshape, rshape, &dims);
+            if (lshape.get_Ndim() > 1) dims.push_back(lshape[-2]);
+            if (rshape.get_Ndim() > 1) dims.push_back(rshape[-1]);
+            return Shape(std::move(dims));
+        }
         default:
             throw error::ShapeError("Invalid shapes for matrix multiplication.");
         }
     }
 
 
+    /* Broadcasts the batch dimensions (all but the last two) of the operands of a batched matrix product,
+     * writing the result into `out` if given. A 1D operand has none. Returns false if they are incompatible:
+     * aligned from the right, every pair of dimensions must be equal or contain a 1. */
+    static bool broadcast_batch_dims(const Shape& a, const Shape& b, std::vector<size_t>* out = nullptr) {
+        const size_t na = (a.get_Ndim() > 2) ? a.get_Ndim() - 2 : 0;
+        const size_t nb = (b.get_Ndim() > 2) ? b.get_Ndim() - 2 : 0;
+        const size_t n = std::max(na, nb);
+
+        std::vector<size_t> dims(n);
+        for (size_t i = 0; i < n; i++) {
+            const size_t da = (i + na >= n) ? a.dimensions[i + na - n] : 1;
+            const size_t db = (i + nb >= n) ? b.dimensions[i + nb - n] : 1;
+            if (da != db && da != 1 && db != 1) return false;
+            dims[i] = (da == 1) ? db : da;
+        }
+        if (out) *out = std::move(dims);
+        return true;
+    }
+
+
     // Returns an enum that holds the type of matrix multiplication taking place
     static MatmulType get_matmul_type(const Shape& a, const Shape& b) {
         const size_t ndim1 = a.get_Ndim();
         const size_t ndim2 = b.get_Ndim();
 
-        if (ndim1 > 2 || ndim2 > 2)
+        if (ndim1 == 0 || ndim2 == 0)
             return MatmulType::Invalid;
 
+        if (ndim1 > 2 || ndim2 > 2) {
+            const size_t b_rows = (ndim2 == 1) ? b.dimensions[0] : b[-2];
+            return (a[-1] == b_rows && broadcast_batch_dims(a, b))
+                ? MatmulType::Batched : MatmulType::Invalid;
+        }
+
         if (ndim1 == 1 && ndim2 == 1)
             return (a.dimensions[0] == b.dimensions[0])
                 ? MatmulType::Dot : MatmulType::Invalid;
@@ -0,0 +1,130 @@
+/* Einsum.hpp */
+#pragma once
+
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Core/NArray.hpp"
+#include "Utils/EinsumUtils.hpp"
+
+
+namespace numxx {
+
+namespace util {
+
+// Wraps the result of a contraction in an NArray, as a one-element array if it has no axes left
+template <typename T>
+NArray<T> get_contraction_result(LabelledTensor<T>&& tensor) {
+    if (tensor.dims.empty()) return NArray<T>(tensor.data[0]);
+    if (tensor.owned.empty()) tensor.owned.assign(tensor.data, tensor.data + tensor.get_size());
+    return NArray<T>(std::move(tensor.owned), Shape(std::move(tensor.dims)));
+}
+
+
+/* Evaluates an einsum on operands given by pointer, so that both einsum overloads read the callers' arrays
+ * without copying them */
+template <typename T>
+NArray<T> einsum_operands(const std::string& subscripts, const std::vector<const NArray<T>*>& operands) {
+    if (operands.empty()) throw error::ValueError("einsum needs at least one operand.");
+    auto [operand_labels, output] = parse_einsum(subscripts, operands.size());
+
+    std::vector<LabelledTensor<T>> tensors;
+    tensors.reserve(operands.size());
+    for (size_t i = 0; i < operands.size(); i++) {
+        const Shape& shape = operands[i]->get_shape();
+        if (operand_labels[i].size() != shape.get_Ndim())
+            throw error::ValueError("einsum subscripts for operand " + std::to_string(i) + " name "
+                                    + std::to_string(operand_labels[i].size()) + " axes, but its shape is "
+                                    + toString(shape) + ".");
+        tensors.emplace_back(operands[i]->get_data(), std::move(operand_labels[i]), shape.dimensions);
+    }
+    return get_contraction_result(contract_tensors(std::move(tensors), output));
+}
+
+} // namespace util
+
+
+/* Evaluates the Einstein summation described by `subscripts` on a list of arrays, as NumPy's einsum:
+ * "ij,jk->ik" is a matrix product, "bij,bjk->bik" a batched one, "ii->" a trace and "ij->ji" a transpose.
+ * The operands are contracted pairwise, in the order that needs the fewest multiply-adds, and every pairwise
+ * contraction runs as a batched gemm on (permuted copies of) the operands. */
+template <typename T>
+NArray<T> einsum(const std::string& subscripts, const std::vector<NArray<T>>& operands) {
+    std::vector<const NArray<T>*> pointers;
+    pointers.reserve(operands.size());
+    for (const NArray<T>& operand : operands) pointers.push_back(&operand);
+    return util::einsum_operands(subscripts, pointers);
+}
+
+// einsum on operands passed directly, as einsum("bij,bjk->bik", a, b); the arrays are not copied
+template <typename T, typename... Arrays>
+NArray<T> einsum(const std::string& subscripts, const NArray<T>& first, const Arrays&... rest) {
+    static_assert((std::is_convertible_v<const Arrays&, const NArray<T>&> && ...),
+                  "einsum operands must all have the same element type.");
+    return util::einsum_operands<T>(subscripts, {&first, static_cast<const NArray<T>*>(&rest)...});
+}
+
+
+/* Sums the products of a and b over the axes `a_axes` of a and `b_axes` of b, paired in order, as NumPy's
+ * tensordot. The result has the remaining axes of a followed by the remaining axes of b. */
+template <typename T>
+NArray<T> tensordot(
+    const NArray<T>& a, const NArray<T>& b, const std::vector<size_t>& a_axes, const std::vector<size_t>& b_axes
+) {
+    const Shape &a_shape = a.get_shape(), &b_shape = b.get_shape();
+    const size_t a_ndim = a_shape.get_Ndim(), b_ndim = b_shape.get_Ndim();
+    if (a_axes.size() != b_axes.size())
+        throw error::ValueError("tensordot needs as many axes of the first array as of the second.");
+
+    // Label the axes of a 0 to a_ndim - 1, give the contracted axes of b the labels of their partners in a,
+    // and the other axes of b new labels
+    std::vector<int> a_labels(a_ndim), b_labels(b_ndim, -1);
+    for (size_t i = 0; i < a_ndim; i++) a_labels[i] = static_cast<int>(i);
+    std::vector<bool> a_contracted(a_ndim, false);
+    for (size_t i = 0; i < a_axes.size(); i++) {
+        if (a_axes[i] >= a_ndim || b_axes[i] >= b_ndim)
+            throw error::ValueError("tensordot axis is out of range.");
+        if (a_contracted[a_axes[i]] || b_labels[b_axes[i]] != -1)
+            throw error::ValueError("tensordot axes must not repeat.");
+        if (a_shape.dimensions[a_axes[i]] != b_shape.dimensions[b_axes[i]])
+            throw error::ShapeError(a_shape, b_shape, "tensordot");
+        a_contracted[a_axes[i]] = true;
+        b_labels[b_axes[i]] = static_cast<int>(a_axes[i]);
+    }
+
+    std::vector<int> output;
+    for (size_t i = 0; i < a_ndim; i++)
+        if (!a_contracted[i]) output.push_back(static_cast<int>(i));
+    int next = static_cast<int>(a_ndim);
+    for (int& label : b_labels) {
+        if (label == -1) {
+            label = next++;
+            output.push_back(label);
+        }
+    }
+
+    std::vector<util::LabelledTensor<T>> tensors;
+    tensors.emplace_back(a.get_data(), std::move(a_labels), a_shape.dimensions);
+    tensors.emplace_back(b.get_data(), std::move(b_labels), b_shape.dimensions);
+    return util::get_contraction_result(util::contract_tensors(std::move(tensors), output));
+}
+
+
+// Sums the products of a and b over the last `axes` axes of a and the first `axes` axes of b
+template <typename T>
+NArray<T> tensordot(const NArray<T>& a, const NArray<T>& b, const size_t axes = 2) {
+    const size_t a_ndim = a.get_shape().get_Ndim();
+    if (axes > a_ndim || axes > b.get_shape().get_Ndim())
+        throw error::ValueError("tensordot cannot contract more axes than an array has.");
+
+    std::vector<size_t> a_axes(axes), b_axes(axes);
+    for (size_t i = 0; i < axes; i++) {
+        a_axes[i] = a_ndim - axes + i;
+        b_axes[i] = i;
+    }
+    return tensordot(a, b, a_axes, b_axes);
+}
+
+} // namespace numxx
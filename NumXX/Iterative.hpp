@@ -0,0 +1,512 @@
+/* Iterative.hpp */
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Core/NArray.hpp"
+#include "Sparse.hpp"
+#include "Utils/IterativeUtils.hpp"
+
+
+namespace numxx::linalg {
+
+    // The outcome of an iterative solve
+    template <typename T>
+    struct IterativeResult {
+        NArray<T> x;                        // The approximate solution
+        size_t iterations = 0;              // Iterations taken (matrix-vector products, for gmres)
+        underlying_type_t<T> residual{};    // Final relative residual norm, ||b - A * x|| / ||b||
+        bool converged = false;             // Whether the residual fell to the tolerance
+    };
+
+
+    // No preconditioning, the default of the iterative solvers. The solvers then skip the preconditioner step
+    struct IdentityPreconditioner {};
+
+
+    /* Jacobi (diagonal) preconditioner: z = D^-1 * r, with D the diagonal of A. Cheap to build and apply, and
+     * effective when A is diagonally dominant or its rows are badly scaled. */
+    template <typename T>
+    class JacobiPreconditioner {
+        std::vector<T> _inv_diag;
+
+        void invert() {
+            for (T& d : _inv_diag) {
+                if (d == T(0)) throw error::LinAlgError("A Jacobi preconditioner needs a nonzero diagonal.");
+                d = T(1) / d;
+            }
+        }
+
+    public:
+        // From the diagonal of a dense square matrix
+        explicit JacobiPreconditioner(const NArray<T>& mat) {
+            const Shape& shape = mat.get_shape();
+            if (shape.get_Ndim() != 2 || !shape.is_square())
+                throw error::ShapeError(util::toString(shape) + " is not a square matrix. Cannot build a Jacobi preconditioner.");
+            const size_t n = shape[0];
+            _inv_diag.resize(n);
+            for (size_t i = 0; i < n; i++) _inv_diag[i] = mat.get_data()[i * n + i];
+            invert();
+        }
+
+        // From the stored diagonal of a square sparse matrix
+        explicit JacobiPreconditioner(const sparse::CSR<T>& mat) {
+            const size_t n = mat.get_shape()[0];
+            if (mat.get_shape()[1] != n)
+                throw error::ShapeError(util::toString(mat.get_shape()) + " is not square. Cannot build a Jacobi preconditioner.");
+            _inv_diag.assign(n, T(0));
+            const auto &indptr = mat.get_indptr(), &indices = mat.get_indices();
+            const auto& values = mat.get_values();
+            for (size_t i = 0; i < n; i++)
+                for (size_t p = indptr[i]; p < indptr[i + 1]; p++)
+                    if (indices[p] == i) _inv_diag[i] += values[p];
+            invert();
+        }
+
+        // z = D^-1 * r
+        void operator()(const T* r, T* z) const {
+            util::parallel_for(_inv_diag.size(), util::iterative_grain, [&] (const size_t begin, const size_t end, size_t) {
+                for (size_t i = begin; i < end; i++) z[i] = _inv_diag[i] * r[i];
+            });
+        }
+    };
+
+
+    /* Incomplete LU preconditioner with no fill-in, ILU(0), for a square sparse matrix: A ~ L * U, where L
+     * (unit lower) and U (upper) keep the sparsity pattern of A, so they take no more memory than A. Applying it
+     * is one forward and one backward substitution over the stored elements. Every diagonal element must be
+     * stored, and the factorisation fails on a zero pivot. */
+    template <typename T>
+    class ILU0Preconditioner {
+        std::vector<size_t> _indptr, _indices, _diag;
+        std::vector<T> _values;
+
+    public:
+        explicit ILU0Preconditioner(const sparse::CSR<T>& mat)
+            : _indptr(mat.get_indptr()), _indices(mat.get_indices()), _values(mat.get_values())
+        {
+            const size_t n = mat.get_shape()[0];
+            if (mat.get_shape()[1] != n)
+                throw error::ShapeError(util::toString(mat.get_shape()) + " is not square. Cannot build an ILU(0) preconditioner.");
+
+            // Sort every row by column and find its diagonal element
+            _diag.resize(n);
+            std::vector<std::pair<size_t, T>> row;
+            for (size_t i = 0; i < n; i++) {
+                const size_t begin = _indptr[i], end = _indptr[i + 1];
+                if (!std::is_sorted(_indices.begin() + begin, _indices.begin() + end)) {
+                    row.clear();
+                    for (size_t p = begin; p < end; p++) row.emplace_back(_indices[p], _values[p]);
+                    std::sort(row.begin(), row.end(), [] (const auto& a, const auto& b) { return a.first < b.first; });
+                    for (size_t p = begin; p < end; p++) std::tie(_indices[p], _values[p]) = row[p - begin];
+                }
+                const auto it = std::lower_bound(_indices.begin() + begin, _indices.begin() + end, i);
+                if (it == _indices.begin() + end || *it != i)
+                    throw error::LinAlgError("ILU(0) needs every diagonal element to be stored.");
+                _diag[i] = static_cast<size_t>(it - _indices.begin());
+            }
+
+            // Row by row (the IKJ order): eliminate the stored elements left of the diagonal, updating only the
+            // positions already in the pattern, which `position` maps from column to storage
+            constexpr size_t none = std::numeric_limits<size_t>::max();
+            std::vector<size_t> position(n, none);
+            for (size_t i = 0; i < n; i++) {
+                for (size_t p = _indptr[i]; p < _indptr[i + 1]; p++) position[_indices[p]] = p;
+                for (size_t p = _indptr[i]; p < _diag[i]; p++) {
+                    const size_t k = _indices[p];
+                    _values[p] /= _values[_diag[k]];
+                    const T l_ik = _values[p];
+                    for (size_t q = _diag[k] + 1; q < _indptr[k + 1]; q++) {
+                        const size_t target = position[_indices[q]];
+                        if (target != none) _values[target] -= l_ik * _values[q];
+                    }
+                }
+                for (size_t p = _indptr[i]; p < _indptr[i + 1]; p++) position[_indices[p]] = none;
+                if (_values[_diag[i]] == T(0)) throw error::LinAlgError("ILU(0) hit a zero pivot.");
+            }
+        }
+
+        // z = U^-1 * L^-1 * r
+        void operator()(const T* r, T* z) const {
+            const size_t n = _diag.size();
+            for (size_t i = 0; i < n; i++) {
+                T s = r[i];
+                for (size_t p = _indptr[i]; p < _diag[i]; p++) s -= _values[p] * z[_indices[p]];
+                z[i] = s;
+            }
+            for (size_t i = n; i-- > 0;) {
+                T s = z[i];
+                for (size_t p = _diag[i] + 1; p < _indptr[i + 1]; p++) s -= _values[p] * z[_indices[p]];
+                z[i] = s / _values[_diag[i]];
+            }
+        }
+    };
+
+} // namespace numxx::linalg
+
+
+namespace numxx::util {
+
+    // Returns y = A * x for a dense n x n matrix, as a callable on raw vectors
+    template <typename T>
+    auto get_linear_operator(const NArray<T>& mat, const size_t n) {
+        if (!mat.get_shape().is_square() || mat.get_shape().get_Ndim() != 2 || mat.get_shape()[0] != n)
+            throw error::ShapeError("A matrix of shape " + toString(mat.get_shape()) + " does not match a system with "
+                + toString(n) + " equations.");
+        return [a = mat.get_data(), n] (const T* x, T* y) { gemv(n, n, T(1), a, n, x, T(0), y, 1); };
+    }
+
+    // Returns y = A * x for a sparse n x n matrix in compressed rows
+    template <typename T>
+    auto get_linear_operator(const sparse::CSR<T>& mat, const size_t n) {
+        if (mat.get_shape() != Shape({n, n}))
+            throw error::ShapeError("A matrix of shape " + toString(mat.get_shape()) + " does not match a system with "
+                + toString(n) + " equations.");
+        return [&mat] (const T* x, T* y) { mat.spmv(x, y); };
+    }
+
+    // Returns y = A * x for a sparse n x n matrix in compressed columns, converted once to compressed rows
+    // (whose product needs no per-call buffers and splits across threads without partial sums)
+    template <typename T>
+    auto get_linear_operator(const sparse::CSC<T>& mat, const size_t n) {
+        if (mat.get_shape() != Shape({n, n}))
+            throw error::ShapeError("A matrix of shape " + toString(mat.get_shape()) + " does not match a system with "
+                + toString(n) + " equations.");
+        return [csr = mat.to_csr()] (const T* x, T* y) { csr.spmv(x, y); };
+    }
+
+    // A user-supplied operator: any callable op(x, y) that writes y = A * x for vectors of length n
+    template <typename T, typename Operator,
+              typename = std::enable_if_t<std::is_invocable_v<const Operator&, const T*, T*> &&
+                                          !std::is_base_of_v<NArray<T>, Operator>>>
+    auto get_linear_operator(const Operator& op, size_t) {
+        return [&op] (const T* x, T* y) { op(x, y); };
+    }
+
+
+    // Throws unless b is a vector and x0 is either empty or a vector of the same length, returning the length
+    template <typename T>
+    size_t check_iterative_system(const NArray<T>& b, const NArray<T>& x0, const std::string& solver) {
+        if (b.get_shape().get_Ndim() != 1)
+            throw error::ShapeError(solver + " expects a vector right-hand side, but got the shape "
+                + toString(b.get_shape()) + ".");
+        if (x0.get_shape().get_Ndim() != 0 && x0.get_shape() != b.get_shape())
+            throw error::ShapeError(b.get_shape(), x0.get_shape(), "start " + solver + " from");
+        return b.get_shape()[0];
+    }
+
+
+    // Returns the starting guess of an iterative solver: a copy of x0, or zeros if it is empty
+    template <typename T>
+    NArray<T> get_initial_guess(const NArray<T>& x0, const size_t n) {
+        if (x0.get_shape().get_Ndim() == 0) return NArray<T>(Shape({n}), T(0));
+        NArray<T> x(Shape({n}));
+        std::copy(x0.get_data(), x0.get_data() + n, x.get_data());
+        return x;
+    }
+
+
+    // Writes r = b - A * x, with A applied by `op`
+    template <typename T, typename Op>
+    void compute_residual(const Op& op, const size_t n, const T* b, const T* x, T* r) {
+        op(x, r);
+        parallel_for(n, iterative_grain, [&] (const size_t begin, const size_t end, size_t) {
+            for (size_t i = begin; i < end; i++) r[i] = b[i] - r[i];
+        });
+    }
+
+
+    // Whether a preconditioner type does something, so that the solvers need a separate preconditioned vector
+    template <typename Precond>
+    inline constexpr bool is_preconditioned_v = !std::is_same_v<Precond, linalg::IdentityPreconditioner>;
+
+
+    // Applies the preconditioner M to r, writing z (for the identity, z is r and nothing is done)
+    template <typename Precond, typename T>
+    void apply_preconditioner(const Precond& M, const T* r, T* z) {
+        if constexpr (is_preconditioned_v<Precond>) M(r, z);
+        else { (void)M; (void)r; (void)z; }
+    }
+
+} // namespace numxx::util
+
+
+namespace numxx::linalg {
+
+    /* Solves A * x = b for a Hermitian positive definite A by the (preconditioned) conjugate gradient method.
+     * A is a dense square NArray, a sparse CSR or CSC matrix, or any callable op(x, y) writing y = A * x for
+     * raw vectors, so the matrix need never be formed. M is a preconditioner callable M(r, z) writing
+     * z ~ A^-1 * r, which must also be Hermitian positive definite. The solve stops once
+     * ||b - A * x|| <= tol * ||b|| or after max_iter iterations (10 n by default), starting from x0 (zeros
+     * by default). All work vectors are allocated before the first iteration. */
+    template <typename Operator, typename T, typename Precond = IdentityPreconditioner>
+    IterativeResult<T> cg(
+        const Operator& A, const NArray<T>& b, const Precond& M = Precond(),
+        const double tol = 1e-5, size_t max_iter = 0, const NArray<T>& x0 = NArray<T>()
+    ) {
+        static_assert(std::is_floating_point_v<underlying_type_t<T>>, "cg needs floating-point or complex arrays.");
+        using Real = underlying_type_t<T>;
+        const size_t n = util::check_iterative_system(b, x0, "cg");
+        const auto op = util::get_linear_operator<T>(A, n);
+        if (max_iter == 0) max_iter = 10 * n;
+
+        IterativeResult<T> result{util::get_initial_guess(x0, n)};
+        T* x = result.x.get_data();
+        const T* bd = b.get_data();
+        const Real b_norm = util::norm2(n, bd);
+        const Real threshold = static_cast<Real>(tol) * b_norm;
+
+        std::vector<T> r(n), p(n), q(n), z_store(util::is_preconditioned_v<Precond> ? n : 0);
+        T* z = util::is_preconditioned_v<Precond> ? z_store.data() : r.data();
+
+        util::compute_residual(op, n, bd, x, r.data());
+        Real r_norm = util::norm2(n, r.data());
+        util::apply_preconditioner(M, r.data(), z);
+        T rz = util::dotc(n, r.data(), z);
+        std::copy(z, z + n, p.begin());
+
+        while (r_norm > threshold && result.iterations < max_iter) {
+            op(p.data(), q.data());
+            const T pq = util::dotc(n, p.data(), q.data());
+            if (pq == T(0)) break;
+            const T alpha = rz / pq;
+            util::parallel_for(n, util::iterative_grain, [&] (const size_t begin, const size_t end, size_t) {
+                for (size_t i = begin; i < end; i++) {
+                    x[i] += alpha * p[i];
+                    r[i] -= alpha * q[i];
+                }
+            });
+            r_norm = util::norm2(n, r.data());
+            result.iterations++;
+            if (r_norm <= threshold) break;
+
+            util::apply_preconditioner(M, r.data(), z);
+            const T rz_next = util::dotc(n, r.data(), z);
+            const T beta = rz_next / rz;
+            rz = rz_next;
+            util::parallel_for(n, util::iterative_grain, [&] (const size_t begin, const size_t end, size_t) {
+                for (size_t i = begin; i < end; i++) p[i] = z[i] + beta * p[i];
+            });
+        }
+
+        // Report the true residual, which rounding lets drift from the one the recurrences update
+        util::compute_residual(op, n, bd, x, r.data());
+        r_norm = util::norm2(n, r.data());
+        result.residual = (b_norm == Real(0)) ? r_norm : r_norm / b_norm;
+        result.converged = r_norm <= threshold;
+        return result;
+    }
+
+
+    /* Solves A * x = b for a general square A by the (right-preconditioned) BiCGSTAB method of van der Vorst,
+     * which needs two products with A per iteration and short recurrences, so its memory does not grow with
+     * the iteration count. A, M, tol, max_iter and x0 are as for cg. An iteration stops early on a breakdown
+     * (a zero inner product), leaving converged false. */
+    template <typename Operator, typename T, typename Precond = IdentityPreconditioner>
+    IterativeResult<T> bicgstab(
+        const Operator& A, const NArray<T>& b, const Precond& M = Precond(),
+        const double tol = 1e-5, size_t max_iter = 0, const NArray<T>& x0 = NArray<T>()
+    ) {
+        static_assert(std::is_floating_point_v<underlying_type_t<T>>, "bicgstab needs floating-point or complex arrays.");
+        using Real = underlying_type_t<T>;
+        constexpr bool preconditioned = util::is_preconditioned_v<Precond>;
+        const size_t n = util::check_iterative_system(b, x0, "bicgstab");
+        const auto op = util::get_linear_operator<T>(A, n);
+        if (max_iter == 0) max_iter = 10 * n;
+
+        IterativeResult<T> result{util::get_initial_guess(x0, n)};
+        T* x = result.x.get_data();
+        const T* bd = b.get_data();
+        const Real b_norm = util::norm2(n, bd);
+        const Real threshold = static_cast<Real>(tol) * b_norm;
+
+        // r holds the residual and, within an iteration, the intermediate residual s
+        std::vector<T> r(n), r_hat(n), p(n, T(0)), v(n, T(0)), t(n);
+        std::vector<T> p_hat_store(preconditioned ? n : 0), s_hat_store(preconditioned ? n : 0);
+        T* p_hat = preconditioned ? p_hat_store.data() : p.data();
+        T* s_hat = preconditioned ? s_hat_store.data() : r.data();
+
+        util::compute_residual(op, n, bd, x, r.data());
+        std::copy(r.begin(), r.end(), r_hat.begin());
+        Real r_norm = util::norm2(n, r.data());
+        T rho(1), alpha(1), omega(1);
+
+        while (r_norm > threshold && result.iterations < max_iter) {
+            const T rho_next = util::dotc(n, r_hat.data(), r.data());
+            if (rho_next == T(0)) break;
+            const T beta = (rho_next / rho) * (alpha / omega);
+            rho = rho_next;
+            util::parallel_for(n, util::iterative_grain, [&] (const size_t begin, const size_t end, size_t) {
+                for (size_t i = begin; i < end; i++) p[i] = r[i] + beta * (p[i] - omega * v[i]);
+            });
+
+            util::apply_preconditioner(M, p.data(), p_hat);
+            op(p_hat, v.data());
+            const T r_hat_v = util::dotc(n, r_hat.data(), v.data());
+            if (r_hat_v == T(0)) break;
+            alpha = rho / r_hat_v;
+            util::parallel_for(n, util::iterative_grain, [&] (const size_t begin, const size_t end, size_t) {
+                for (size_t i = begin; i < end; i++) r[i] -= alpha * v[i];
+            });
+
+            result.iterations++;
+            const Real s_norm = util::norm2(n, r.data());
+            if (s_norm <= threshold) {
+                util::parallel_for(n, util::iterative_grain, [&] (const size_t begin, const size_t end, size_t) {
+                    for (size_t i = begin; i < end; i++) x[i] += alpha * p_hat[i];
+                });
+                r_norm = s_norm;
+                break;
+            }
+
+            util::apply_preconditioner(M, r.data(), s_hat);
+            op(s_hat, t.data());
+            const T tt = util::dotc(n, t.data(), t.data());
+            omega = (tt == T(0)) ? T(0) : util::dotc(n, t.data(), r.data()) / tt;
+            util::parallel_for(n, util::iterative_grain, [&] (const size_t begin, const size_t end, size_t) {
+                for (size_t i = begin; i < end; i++) {
+                    x[i] += alpha * p_hat[i] + omega * s_hat[i];
+                    r[i] -= omega * t[i];
+                }
+            });
+            r_norm = util::norm2(n, r.data());
+            if (omega == T(0)) break;
+        }
+
+        // Report the true residual, which rounding lets drift from the one the recurrences update
+        util::compute_residual(op, n, bd, x, r.data());
+        r_norm = util::norm2(n, r.data());
+        result.residual = (b_norm == Real(0)) ? r_norm : r_norm / b_norm;
+        result.converged = r_norm <= threshold;
+        return result;
+    }
+
+
+    /* Solves A * x = b for a general square A by the restarted GMRES(m) method with right preconditioning.
+     * Each cycle builds an orthonormal basis of up to m = `restart` Krylov vectors by modified Gram-Schmidt,
+     * keeps the small Hessenberg least-squares problem triangular with Givens rotations (so the residual norm
+     * is known at every step without forming x), and then updates x and restarts from the true residual,
+     * stopping once that meets the tolerance.
+     * The basis takes (m + 1) * n elements. max_iter counts products with A (10 n by default); A, M, tol and
+     * x0 are as for cg. */
+    template <typename Operator, typename T, typename Precond = IdentityPreconditioner>
+    IterativeResult<T> gmres(
+        const Operator& A, const NArray<T>& b, const Precond& M = Precond(),
+        const double tol = 1e-5, size_t max_iter = 0, const NArray<T>& x0 = NArray<T>(), const size_t restart = 30
+    ) {
+        static_assert(std::is_floating_point_v<underlying_type_t<T>>, "gmres needs floating-point or complex arrays.");
+        using Real = underlying_type_t<T>;
+        constexpr bool preconditioned = util::is_preconditioned_v<Precond>;
+        const size_t n = util::check_iterative_system(b, x0, "gmres");
+        const auto op = util::get_linear_operator<T>(A, n);
+        if (max_iter == 0) max_iter = 10 * n;
+        const size_t m = std::max<size_t>(1, std::min(restart, n));
+
+        IterativeResult<T> result{util::get_initial_guess(x0, n)};
+        T* x = result.x.get_data();
+        const T* bd = b.get_data();
+        const Real b_norm = util::norm2(n, bd);
+        const Real threshold = static_cast<Real>(tol) * b_norm;
+
+        std::vector<T> basis((m + 1) * n), hessenberg((m + 1) * m), g(m + 1), y(m), u(n), z(preconditioned ? n : 0);
+        std::vector<Real> cs(m);
+        std::vector<T> sn(m);
+        auto H = [&] (const size_t i, const size_t j) -> T& { return hessenberg[i * m + j]; };
+
+        Real r_norm = 0;
+        while (true) {
+            T* v0 = basis.data();
+            util::compute_residual(op, n, bd, x, v0);
+            r_norm = util::norm2(n, v0);
+            if (r_norm <= threshold || result.iterations >= max_iter) break;
+
+            const T inv_beta = T(Real(1) / r_norm);
+            util::parallel_for(n, util::iterative_grain, [&] (const size_t begin, const size_t end, size_t) {
+                for (size_t i = begin; i < end; i++) v0[i] *= inv_beta;
+            });
+            std::fill(g.begin(), g.end(), T(0));
+            g[0] = T(r_norm);
+
+            size_t k = 0;
+            while (k < m && result.iterations < max_iter) {
+                const size_t j = k;
+                T* vj = basis.data() + j * n;
+                T* w = basis.data() + (j + 1) * n;
+                if constexpr (preconditioned) {
+                    M(vj, z.data());
+                    op(z.data(), w);
+                } else {
+                    op(vj, w);
+                }
+
+                for (size_t i = 0; i <= j; i++) {
+                    const T* vi = basis.data() + i * n;
+                    const T h = util::dotc(n, vi, w);
+                    H(i, j) = h;
+                    util::parallel_for(n, util::iterative_grain, [&] (const size_t begin, const size_t end, size_t) {
+                        for (size_t e = begin; e < end; e++) w[e] -= h * vi[e];
+                    });
+                }
+                const Real h_next = util::norm2(n, w);
+                H(j + 1, j) = T(h_next);
+                if (h_next != Real(0)) {
+                    const T inv_h = T(Real(1) / h_next);
+                    util::parallel_for(n, util::iterative_grain, [&] (const size_t begin, const size_t end, size_t) {
+                        for (size_t e = begin; e < end; e++) w[e] *= inv_h;
+                    });
+                }
+
+                // Apply the earlier rotations to the new column, then zero its subdiagonal element
+                for (size_t i = 0; i < j; i++) {
+                    const T a = H(i, j), c = H(i + 1, j);
+                    H(i, j) = T(cs[i]) * a + sn[i] * c;
+                    H(i + 1, j) = T(cs[i]) * c - numxx::conj(sn[i]) * a;
+                }
+                const auto [c, s] = util::get_givens_rotation(H(j, j), H(j + 1, j));
+                cs[j] = c;
+                sn[j] = s;
+                H(j, j) = T(c) * H(j, j) + s * H(j + 1, j);
+                H(j + 1, j) = T(0);
+                g[j + 1] = T(Real(0)) - numxx::conj(s) * g[j];
+                g[j] = T(c) * g[j];
+
+                result.iterations++;
+                k++;
+                // |g[j + 1]| is the residual norm x would have after this step; h_next = 0 means it is exact
+                if (static_cast<Real>(numxx::abs(g[j + 1])) <= threshold || h_next == Real(0)) break;
+            }
+
+            // x += M^-1 * V * y, where H * y = g is the triangular least-squares problem of the cycle
+            for (size_t i = k; i-- > 0;) {
+                T s = g[i];
+                for (size_t t = i + 1; t < k; t++) s -= H(i, t) * y[t];
+                y[i] = s / H(i, i);
+            }
+            util::parallel_for(n, util::iterative_grain, [&] (const size_t begin, const size_t end, size_t) {
+                for (size_t e = begin; e < end; e++) {
+                    T s(0);
+                    for (size_t i = 0; i < k; i++) s += y[i] * basis[i * n + e];
+                    u[e] = s;
+                }
+            });
+            if constexpr (preconditioned) {
+                M(u.data(), z.data());
+                std::copy(z.begin(), z.end(), u.begin());
+            }
+            util::parallel_for(n, util::iterative_grain, [&] (const size_t begin, const size_t end, size_t) {
+                for (size_t e = begin; e < end; e++) x[e] += u[e];
+            });
+        }
+
+        result.residual = (b_norm == Real(0)) ? r_norm : r_norm / b_norm;
+        result.converged = r_norm <= threshold;
+        return result;
+    }
+
+} // namespace numxx::linalg
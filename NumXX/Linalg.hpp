@@ -1,34 +1,467 @@
 /* Linalg.hpp */
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <tuple>
+#include <utility>
+#include <vector>
+
 #include "Core/NArray.hpp"
+#include "Utils/EigenUtils.hpp"
 #include "Utils/LinalgUtils.hpp"
+#include "Utils/MatrixFuncUtils.hpp"
 
 
 namespace numxx::linalg {
 
+    // Returns the determinant of a square matrix, from its LU factorisation
+    // Integral matrices are factored (and their determinant returned) in double precision
     template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
-    T det(const NArray<T>& mat) {
-        if (!mat.get_shape().is_square()) {
-            throw error::ShapeError(util::toString(mat.get_shape()) +
-                " is not square. Cannot take the determinant of non-square matrix.");
+    floating_type_t<T> det(const NArray<T>& mat) {
+        using R = floating_type_t<T>;
+        const size_t n = util::check_square_matrix(mat, "determinant");
+
+        auto lu = util::get_floating_copy<R>(mat);
+        std::vector<size_t> piv(n);
+        util::lu_factor(lu.data(), n, piv.data());
+
+        R res(1);
+        for (size_t i = 0; i < n; i++) {
+            res *= lu[i * n + i];
+            if (piv[i] != i) res = R(0) - res;
         }
+        return res;
+    }
+
 
-        // Extra protection in case a scalar is used
-        if (mat.get_total_size() == 1) return mat(0);
+    /* Returns the sign and the natural log of the absolute value of the determinant of a square matrix, which
+     * does not overflow or underflow when the determinant itself would. For complex matrices the sign is a
+     * complex number of magnitude one. A singular matrix gives a sign of 0 and a log of -inf. */
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    std::pair<floating_type_t<T>, underlying_type_t<floating_type_t<T>>> slogdet(const NArray<T>& mat) {
+        using R = floating_type_t<T>;
+        using Real = underlying_type_t<R>;
+        const size_t n = util::check_square_matrix(mat, "determinant");
 
-        // Base case is a 2x2 matrix
-        if (mat.get_total_size() == 4) {
-            return (mat(0) * mat(3)) - (mat(1) * mat(2));
+        auto lu = util::get_floating_copy<R>(mat);
+        std::vector<size_t> piv(n);
+        util::lu_factor(lu.data(), n, piv.data());
+
+        R sign(1);
+        Real logabs(0);
+        for (size_t i = 0; i < n; i++) {
+            const R d = lu[i * n + i];
+            if (d == R(0)) return {R(0), -std::numeric_limits<Real>::infinity()};
+
+            const auto magnitude = static_cast<Real>(numxx::abs(d));
+            sign *= d / magnitude;
+            logabs += std::log(magnitude);
+            if (piv[i] != i) sign = R(0) - sign;
         }
+        return {sign, logabs};
+    }
+
+
+    /* Solves A * X = B for a square matrix A and a vector or matrix B (one right-hand side per column), through
+     * the blocked LU factorisation of A with partial pivoting. The result has the shape of B.
+     * Throws LinAlgError if A is singular. */
+    template <typename T, typename U, typename = std::enable_if_t<is_complex_or_arithmetic_v<T> && is_complex_or_arithmetic_v<U>>>
+    auto solve(const NArray<T>& a, const NArray<U>& b)
+        -> NArray<floating_type_t<decltype(std::declval<T>() * std::declval<U>())>>
+    {
+        using R = floating_type_t<decltype(std::declval<T>() * std::declval<U>())>;
+        const size_t n = util::check_square_matrix(a, "LU factorisation");
+        const size_t nrhs = util::check_right_hand_side(b, n);
+
+        auto lu = util::get_floating_copy<R>(a);
+        std::vector<size_t> piv(n);
+        util::lu_factor(lu.data(), n, piv.data());
+        util::check_nonsingular(lu.data(), n, n);
 
-        auto r0 = mat[0];
-        T res = 0;
-        for (size_t i = 0; i < r0.get_total_size(); i++) {
-            if (i%2 == 0) res += r0(i) * det(util::get_minor_matrix(mat, 0, i));
-            else res += -r0(i) * det(util::get_minor_matrix(mat, 0, i));
+        NArray<R> x(util::get_floating_copy<R>(b), b.get_shape());
+        util::lu_solve(lu.data(), n, piv.data(), x.get_data(), nrhs);
+        return x;
+    }
+
+
+    // Returns the inverse of a square matrix, by solving A * X = I through its LU factorisation
+    // Throws LinAlgError if the matrix is singular
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<floating_type_t<T>> inv(const NArray<T>& mat) {
+        using R = floating_type_t<T>;
+        const size_t n = util::check_square_matrix(mat, "inverse");
+
+        auto lu = util::get_floating_copy<R>(mat);
+        std::vector<size_t> piv(n);
+        util::lu_factor(lu.data(), n, piv.data());
+        util::check_nonsingular(lu.data(), n, n);
+
+        NArray<R> out(mat.get_shape(), R(0));
+        for (size_t i = 0; i < n; i++) out.get_data()[i * n + i] = R(1);
+        util::lu_solve(lu.data(), n, piv.data(), out.get_data(), n);
+        return out;
+    }
+
+
+    /* Returns the least-squares solution X that minimises ||A * X - B|| (column by column) for an m x n matrix A
+     * of full rank, together with the squared residual norm of every column of B (empty unless m > n).
+     * Overdetermined systems are solved through the Householder QR factorisation of A; underdetermined ones get
+     * the minimum-norm solution through the QR factorisation of A^H. Throws LinAlgError if A is rank deficient. */
+    template <typename T, typename U, typename = std::enable_if_t<is_complex_or_arithmetic_v<T> && is_complex_or_arithmetic_v<U>>>
+    auto lstsq(const NArray<T>& a, const NArray<U>& b)
+        -> std::pair<
+            NArray<floating_type_t<decltype(std::declval<T>() * std::declval<U>())>>,
+            NArray<underlying_type_t<floating_type_t<decltype(std::declval<T>() * std::declval<U>())>>>
+        >
+    {
+        using R = floating_type_t<decltype(std::declval<T>() * std::declval<U>())>;
+        using Real = underlying_type_t<R>;
+
+        const Shape& shape = a.get_shape();
+        if (shape.get_Ndim() != 2)
+            throw error::ShapeError("lstsq expects a 2D matrix, but got the shape " + util::toString(shape) + ".");
+        const size_t m = shape[0], n = shape[1];
+        const size_t nrhs = util::check_right_hand_side(b, m);
+        const size_t k = std::min(m, n);
+
+        // QR factorisation of A (m >= n) or of A^H (m < n), stored as `rows` x k
+        const size_t rows = std::max(m, n);
+        auto qr = util::get_tall_floating_copy<R>(a);
+        std::vector<R> tau(k);
+        util::householder_qr(qr.data(), rows, k, tau.data());
+
+        Real max_diag(0);
+        for (size_t i = 0; i < k; i++) max_diag = std::max(max_diag, static_cast<Real>(numxx::abs(qr[i * k + i])));
+        const Real tol = static_cast<Real>(rows) * std::numeric_limits<Real>::epsilon() * max_diag;
+        for (size_t i = 0; i < k; i++) {
+            if (static_cast<Real>(numxx::abs(qr[i * k + i])) <= tol)
+                throw error::LinAlgError("lstsq requires a matrix of full rank.");
         }
-        return res;
+
+        const auto rhs = util::get_floating_copy<R>(b);
+        std::vector<R> x(rows * nrhs, R(0));
+        std::vector<Real> residuals;
+
+        if (m >= n) {
+            // X = R^-1 * (Q^H * B)[:n], and the rows of Q^H * B past n hold the residuals
+            std::copy(rhs.begin(), rhs.end(), x.begin());
+            util::apply_qh(qr.data(), m, n, n, tau.data(), x.data(), nrhs);
+            if (m > n) {
+                residuals.assign(nrhs, Real(0));
+                for (size_t i = n; i < m; i++)
+                    for (size_t c = 0; c < nrhs; c++) residuals[c] += util::abs_squared(x[i * nrhs + c]);
+            }
+            util::trsm_upper(qr.data(), n, n, x.data(), nrhs);
+            x.resize(n * nrhs);
+        } else {
+            // A = R^H * Q^H, so X = Q * (R^-H * B, padded with zeros)
+            for (size_t i = 0; i < m; i++) {
+                R* row = x.data() + i * nrhs;
+                for (size_t c = 0; c < nrhs; c++) row[c] = rhs[i * nrhs + c];
+                for (size_t t = 0; t < i; t++) {
+                    const R r = numxx::conj(qr[t * m + i]);
+                    const R* src = x.data() + t * nrhs;
+                    for (size_t c = 0; c < nrhs; c++) row[c] -= r * src[c];
+                }
+                const R inv_diag = R(1) / numxx::conj(qr[i * m + i]);
+                for (size_t c = 0; c < nrhs; c++) row[c] *= inv_diag;
+            }
+            util::apply_q(qr.data(), n, m, m, tau.data(), x.data(), nrhs);
+        }
+
+        Shape out_shape = (b.get_shape().get_Ndim() == 2) ? Shape({n, nrhs}) : Shape({n});
+        return {NArray<R>(std::move(x), std::move(out_shape)), NArray<Real>(std::move(residuals))};
+    }
+
+
+    // The shapes of the factors returned by qr, for an m x n matrix with k = min(m, n)
+    enum class QRMode {
+        Reduced,    // Q is m x k and R is k x n
+        Complete    // Q is m x m and R is m x n
+    };
+
+
+    /* Returns the QR factorisation A = Q * R of an m x n matrix, where Q has orthonormal columns (unitary, if
+     * complex) and R is upper triangular. It is computed with blocked Householder reflections, most of whose
+     * work goes through gemm, and Q is formed by applying the reflectors to the identity. */
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    std::pair<NArray<floating_type_t<T>>, NArray<floating_type_t<T>>> qr(
+        const NArray<T>& mat, const QRMode mode = QRMode::Reduced
+    ) {
+        using R = floating_type_t<T>;
+        const Shape& shape = mat.get_shape();
+        if (shape.get_Ndim() != 2)
+            throw error::ShapeError("qr expects a 2D matrix, but got the shape " + util::toString(shape) + ".");
+        const size_t m = shape[0], n = shape[1];
+
+        auto factored = util::get_floating_copy<R>(mat);
+        std::vector<R> tau(std::min(m, n));
+        util::householder_qr(factored.data(), m, n, tau.data());
+        return util::get_qr_factors(factored, tau, m, n, mode == QRMode::Complete);
+    }
+
+
+    /* Returns the QR factorisation with column pivoting A[:, P] = Q * R of an m x n matrix, as (Q, R, P).
+     * The magnitudes on the diagonal of R are non-increasing, so the number of them above a tolerance is the
+     * numerical rank of A. */
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    std::tuple<NArray<floating_type_t<T>>, NArray<floating_type_t<T>>, NArray<size_t>> qr_pivoted(
+        const NArray<T>& mat, const QRMode mode = QRMode::Reduced
+    ) {
+        using R = floating_type_t<T>;
+        const Shape& shape = mat.get_shape();
+        if (shape.get_Ndim() != 2)
+            throw error::ShapeError("qr expects a 2D matrix, but got the shape " + util::toString(shape) + ".");
+        const size_t m = shape[0], n = shape[1];
+
+        auto factored = util::get_floating_copy<R>(mat);
+        std::vector<R> tau(std::min(m, n));
+        NArray<size_t> perm(Shape({n}));
+        util::householder_qr_pivoted(factored.data(), m, n, tau.data(), perm.get_data());
+        auto [q, r] = util::get_qr_factors(factored, tau, m, n, mode == QRMode::Complete);
+        return {std::move(q), std::move(r), std::move(perm)};
+    }
+
+
+    /* Returns the lower triangular Cholesky factor L of a Hermitian (symmetric, if real) positive definite
+     * matrix, with A = L * L^H. Only the lower triangle of the matrix is read.
+     * Throws LinAlgError if the matrix is not positive definite. */
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<floating_type_t<T>> cholesky(const NArray<T>& mat) {
+        using R = floating_type_t<T>;
+        const size_t n = util::check_square_matrix(mat, "Cholesky factorisation");
+
+        NArray<R> out(util::get_floating_copy<R>(mat), mat.get_shape());
+        if (!util::cholesky_factor(out.get_data(), n))
+            throw error::LinAlgError("Matrix is not positive definite.");
+        return out;
+    }
+
+
+    // Solves A * X = B given the Cholesky factor L of A (as returned by cholesky), for a vector or matrix B
+    template <typename T, typename U, typename = std::enable_if_t<is_complex_or_arithmetic_v<T> && is_complex_or_arithmetic_v<U>>>
+    auto cho_solve(const NArray<T>& factor, const NArray<U>& b)
+        -> NArray<floating_type_t<decltype(std::declval<T>() * std::declval<U>())>>
+    {
+        using R = floating_type_t<decltype(std::declval<T>() * std::declval<U>())>;
+        const size_t n = util::check_square_matrix(factor, "Cholesky solve");
+        const size_t nrhs = util::check_right_hand_side(b, n);
+
+        const auto l = util::get_floating_copy<R>(factor);
+        util::check_nonsingular(l.data(), n, n);
+        NArray<R> x(util::get_floating_copy<R>(b), b.get_shape());
+        util::cholesky_solve(l.data(), n, x.get_data(), nrhs);
+        return x;
+    }
+
+
+    // Returns the inverse of a Hermitian positive definite matrix through its Cholesky factorisation, which
+    // takes half the work of LU. Throws LinAlgError if the matrix is not positive definite
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<floating_type_t<T>> inv_spd(const NArray<T>& mat) {
+        using R = floating_type_t<T>;
+        const size_t n = util::check_square_matrix(mat, "inverse");
+
+        auto l = util::get_floating_copy<R>(mat);
+        if (!util::cholesky_factor(l.data(), n))
+            throw error::LinAlgError("Matrix is not positive definite.");
+
+        NArray<R> out(mat.get_shape(), R(0));
+        for (size_t i = 0; i < n; i++) out.get_data()[i * n + i] = R(1);
+        util::cholesky_solve(l.data(), n, out.get_data(), n);
+        return out;
+    }
+
+
+    /* Returns the eigenvalues, in ascending order, and the eigenvectors (the columns of the second matrix) of a
+     * Hermitian (symmetric, if real) matrix, so that A * V = V * diag(w). Only the lower triangle is read.
+     * The matrix is reduced to real tridiagonal form by blocked Householder reflections, whose updates go through
+     * gemm, the tridiagonal matrix is diagonalised by the implicit QL method, and the reflectors then carry its
+     * eigenvectors back to those of A, again through gemm. Throws LinAlgError if the iteration does not converge. */
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    std::pair<NArray<underlying_type_t<floating_type_t<T>>>, NArray<floating_type_t<T>>> eigh(const NArray<T>& mat) {
+        using R = floating_type_t<T>;
+        using Real = underlying_type_t<R>;
+        const size_t n = util::check_square_matrix(mat, "eigendecomposition");
+
+        auto a = util::get_floating_copy<R>(mat);
+        NArray<Real> w(Shape({n}));
+        NArray<R> v(mat.get_shape());
+        if (!util::hermitian_eigen(a.data(), n, w.get_data(), v.get_data()))
+            throw error::LinAlgError("Eigenvalues did not converge.");
+        return {std::move(w), std::move(v)};
+    }
+
+
+    // Returns the eigenvalues of a Hermitian (symmetric, if real) matrix in ascending order, reading only its lower
+    // triangle. Skipping the eigenvectors leaves the QL iteration O(n^2), so the reduction dominates
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<underlying_type_t<floating_type_t<T>>> eigvalsh(const NArray<T>& mat) {
+        using R = floating_type_t<T>;
+        using Real = underlying_type_t<R>;
+        const size_t n = util::check_square_matrix(mat, "eigenvalues");
+
+        auto a = util::get_floating_copy<R>(mat);
+        NArray<Real> w(Shape({n}));
+        if (!util::hermitian_eigen(a.data(), n, w.get_data(), static_cast<R*>(nullptr)))
+            throw error::LinAlgError("Eigenvalues did not converge.");
+        return w;
+    }
+
+
+    /* Returns the singular value decomposition A = U * diag(S) * Vh of an m x n matrix as (U, S, Vh), with the
+     * singular values S in descending order. With full_matrices, U is m x m and Vh is n x n; otherwise U is m x k
+     * and Vh is k x n, with k = min(m, n) (the thin SVD).
+     * The matrix (or its conjugate transpose, if it is wide) is first factored by the blocked Householder QR, the
+     * k x k triangular factor is reduced to bidiagonal form and diagonalised by implicit-shift QR sweeps (Golub and
+     * Kahan), and the reflectors carry the singular vectors back through gemm. Throws LinAlgError if the sweeps do
+     * not converge. */
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    std::tuple<NArray<floating_type_t<T>>, NArray<underlying_type_t<floating_type_t<T>>>, NArray<floating_type_t<T>>> svd(
+        const NArray<T>& mat, const bool full_matrices = true
+    ) {
+        using R = floating_type_t<T>;
+        using Real = underlying_type_t<R>;
+        const Shape& shape = mat.get_shape();
+        if (shape.get_Ndim() != 2)
+            throw error::ShapeError("svd expects a 2D matrix, but got the shape " + util::toString(shape) + ".");
+        const size_t m = shape[0], n = shape[1];
+        const size_t k = std::min(m, n), rows = std::max(m, n);
+        const size_t u_cols = full_matrices ? rows : k;
+
+        // Decompose A (m >= n) or A^H (m < n), whose factors swap roles: A^H = U' S V'^H gives A = V' S U'^H
+        auto a = util::get_tall_floating_copy<R>(mat);
+
+        NArray<Real> s(Shape({k}));
+        std::vector<R> u(rows * u_cols), vh(k * k);
+        if (!util::svd_tall(a.data(), rows, k, s.get_data(), u.data(), u_cols, vh.data()))
+            throw error::LinAlgError("SVD did not converge.");
+
+        if (m >= n)
+            return {NArray<R>(std::move(u), Shape({m, u_cols})), std::move(s), NArray<R>(std::move(vh), Shape({n, n}))};
+
+        NArray<R> u_out(Shape({m, m})), vh_out(Shape({u_cols, n}));
+        for (size_t i = 0; i < m; i++)
+            for (size_t j = 0; j < m; j++) u_out.get_data()[i * m + j] = numxx::conj(vh[j * m + i]);
+        for (size_t i = 0; i < u_cols; i++)
+            for (size_t j = 0; j < n; j++) vh_out.get_data()[i * n + j] = numxx::conj(u[j * u_cols + i]);
+        return {std::move(u_out), std::move(s), std::move(vh_out)};
+    }
+
+
+    // Returns the singular values of a matrix in descending order. Without U and V the QR sweeps are O(k^2), so
+    // the QR and bidiagonal reductions dominate
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<underlying_type_t<floating_type_t<T>>> svdvals(const NArray<T>& mat) {
+        using R = floating_type_t<T>;
+        using Real = underlying_type_t<R>;
+        const Shape& shape = mat.get_shape();
+        if (shape.get_Ndim() != 2)
+            throw error::ShapeError("svdvals expects a 2D matrix, but got the shape " + util::toString(shape) + ".");
+        const size_t m = shape[0], n = shape[1];
+        const size_t k = std::min(m, n), rows = std::max(m, n);
+
+        auto a = util::get_tall_floating_copy<R>(mat);
+
+        NArray<Real> s(Shape({k}));
+        if (!util::svd_tall(a.data(), rows, k, s.get_data(), static_cast<R*>(nullptr), 0, static_cast<R*>(nullptr)))
+            throw error::LinAlgError("SVD did not converge.");
+        return s;
+    }
+
+
+    /* Returns A^p for a square matrix A and an integer p, by binary exponentiation: A is squared once per bit
+     * of |p| and multiplied into the result for every set bit, each product going through gemm into one of
+     * three buffers allocated up front. p = 0 gives the identity, and a negative p the |p|-th power of the
+     * inverse, which needs floating-point or complex elements (and throws LinAlgError if A is singular). */
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<T> matrix_power(const NArray<T>& mat, const long long p) {
+        const size_t n = util::check_square_matrix(mat, "power");
+        const size_t nn = n * n;
+
+        NArray<T> out(mat.get_shape(), T(0));
+        if (p == 0) {
+            for (size_t i = 0; i < n; i++) out.get_data()[i * n + i] = T(1);
+            return out;
+        }
+
+        std::vector<T> buffers(2 * nn);
+        T* base = buffers.data();
+        if (p > 0) {
+            std::copy(mat.get_data(), mat.get_data() + nn, base);
+        } else if constexpr (std::is_floating_point_v<underlying_type_t<T>>) {
+            const NArray<T> inverse = inv(mat);
+            std::copy(inverse.get_data(), inverse.get_data() + nn, base);
+        } else {
+            throw error::ValueError("Negative matrix powers need a floating-point or complex matrix.");
+        }
+
+        const unsigned long long power = (p > 0)
+            ? static_cast<unsigned long long>(p)
+            : static_cast<unsigned long long>(-(p + 1)) + 1;
+        const T* result = util::matrix_power_buffers(n, power, base, out.get_data(), buffers.data() + nn);
+        if (result != out.get_data()) std::copy(result, result + nn, out.get_data());
+        return out;
+    }
+
+
+    /* Returns the matrix exponential exp(A) of a square matrix by scaling and squaring (Higham, 2005). The
+     * lowest Padé degree (3, 5, 7, 9 or 13) whose error bound holds for ||A||_1 is picked; if none does, A is
+     * first scaled by 2^-s so that degree 13 applies. The approximant r(A) = (V - U)^-1 * (V + U) takes a few
+     * products through gemm and one LU solve, and r(A) is then squared s times, alternating between two
+     * buffers. All workspace is allocated once per call.
+     * Integral matrices are computed in double precision. Throws LinAlgError if V - U is singular. */
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<floating_type_t<T>> expm(const NArray<T>& mat) {
+        using R = floating_type_t<T>;
+        using Real = underlying_type_t<R>;
+        const size_t n = util::check_square_matrix(mat, "exponential");
+        const size_t nn = n * n;
+
+        // A (scaled), its even powers, U, V and one more buffer for sums and squaring
+        std::vector<R> work(8 * nn);
+        R *a = work.data(), *powers = a + nn, *u = powers + 4 * nn, *v = u + nn, *spare = v + nn;
+        for (size_t i = 0; i < nn; i++) a[i] = util::to_floating<R>(mat.get_data()[i]);
+
+        constexpr size_t n_degrees = util::pade_degree_count_v<Real>;
+        const Real norm = util::matrix_norm1(n, a);
+        size_t degree = util::pade_degrees[n_degrees - 1];
+        int squarings = 0;
+        for (size_t d = 0; d < n_degrees; d++) {
+            if (norm <= util::get_pade_theta<Real>(d)) {
+                degree = util::pade_degrees[d];
+                break;
+            }
+        }
+        if (norm > util::get_pade_theta<Real>(n_degrees - 1)) {
+            squarings = std::max(0, static_cast<int>(std::ceil(std::log2(norm / util::get_pade_theta<Real>(n_degrees - 1)))));
+            const R scale(std::ldexp(Real(1), -squarings));
+            for (size_t i = 0; i < nn; i++) a[i] *= scale;
+        }
+
+        util::get_pade_terms(n, degree, a, powers, u, v, spare);
+
+        // Solve (V - U) * X = V + U, with V - U formed in `a` (no longer needed) and X in the output
+        NArray<R> out(mat.get_shape());
+        R* x = out.get_data();
+        for (size_t i = 0; i < nn; i++) {
+            a[i] = v[i] - u[i];
+            x[i] = v[i] + u[i];
+        }
+        std::vector<size_t> piv(n);
+        util::lu_factor(a, n, piv.data());
+        util::check_nonsingular(a, n, n);
+        util::lu_solve(a, n, piv.data(), x, n);
+
+        R *current = x, *next = spare;
+        for (int i = 0; i < squarings; i++) {
+            util::gemm(n, n, n, R(1), current, n, current, n, R(0), next, n);
+            std::swap(current, next);
+        }
+        if (current != x) std::copy(current, current + nn, x);
+        return out;
     }
 
 } // namespace numxx::linalg
\ No newline at end of file
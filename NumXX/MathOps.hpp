@@ -15,4 +15,13 @@ bool isinf(T num) {
     }
 }
 
+template <typename T>
+bool isnan(T num) {
+    if constexpr (std::is_floating_point_v<T>) {
+        return std::isnan(num);
+    } else {
+        return false;
+    }
+}
+
 } // namespace numxx
\ No newline at end of file
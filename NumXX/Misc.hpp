@@ -1,7 +1,13 @@
 /* Misc.hpp */
 #pragma once
 
+#include <functional>
+
 #include "Core/NArray.hpp"
+#include "Utils/ReduceUtils.hpp"
+#include "Utils/ExtremaUtils.hpp"
+#include "Utils/ScanUtils.hpp"
+#include "Utils/DiffUtils.hpp"
 
 namespace numxx {
 
@@ -17,124 +23,426 @@ namespace numxx {
     }
 
 
+    // Reduces `arr` along `axes` using the binary operation `op`
+    // `op` must be associative and commutative since the elements are folded in memory order
+    template <typename T, typename Op>
+    NArray<T> reduce(const NArray<T>& arr, const std::vector<int>& axes, Op op, const bool keepdims = false) {
+        return util::reduce_array(arr, util::get_axes_mask(arr.get_shape(), axes), op, keepdims);
+    }
+
+    // Same as above, but every output starts from `initial` (which also allows empty reductions)
+    template <typename T, typename Op>
+    NArray<T> reduce(
+        const NArray<T>& arr, const std::vector<int>& axes, Op op, const bool keepdims, const T& initial
+    ) {
+        return util::reduce_array(arr, util::get_axes_mask(arr.get_shape(), axes), op, keepdims, &initial);
+    }
+
+
     // Flattens the array and returns the sum
     template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
     T sum(const NArray<T>& arr) {
-        T sum = T();
-        for (const auto& elem : arr) sum += elem;
-        return sum;
+        if (arr.get_total_size() == 0) return T();
+        return util::fold_contiguous(arr.get_data(), arr.get_total_size(), std::plus<T>());
+    }
+
+    // Returns the sum of an array along the given axes
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<T> sum(const NArray<T>& arr, const std::vector<int>& axes, const bool keepdims = false) {
+        return reduce(arr, axes, std::plus<T>(), keepdims, T());
     }
 
     // Returns the sum of an array given an axis
     template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
-    NArray<T> sum(const NArray<T>& arr, int axis)
-    {
-        const Shape& shape = arr.get_shape();
-        const size_t ndim = shape.get_Ndim();
+    NArray<T> sum(const NArray<T>& arr, const int axis, const bool keepdims = false) {
+        return sum(arr, std::vector<int>{axis}, keepdims);
+    }
 
-        if (axis < 0) axis += ndim;
 
-        size_t strides[ndim];
-        Shape::compute_strides(shape, strides, ndim);
+    // Flattens the array and returns the product
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    T prod(const NArray<T>& arr) {
+        if (arr.get_total_size() == 0) return T(1);
+        return util::fold_contiguous(arr.get_data(), arr.get_total_size(), std::multiplies<T>());
+    }
+
+    // Returns the product of an array along the given axes
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<T> prod(const NArray<T>& arr, const std::vector<int>& axes, const bool keepdims = false) {
+        return reduce(arr, axes, std::multiplies<T>(), keepdims, T(1));
+    }
 
-        const size_t axis_size = shape[axis];
-        int outer = 1;
-        for (int i = 0; i < axis; ++i)
-            outer *= shape[i];
+    // Returns the product of an array given an axis
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<T> prod(const NArray<T>& arr, const int axis, const bool keepdims = false) {
+        return prod(arr, std::vector<int>{axis}, keepdims);
+    }
 
-        const int inner = strides[axis];
 
-        const size_t out_size = outer * inner;
-        NArray<T> out(Shape{out_size}, T());
+    // Flattens the array and returns the smallest element
+    // NaNs propagate, and complex numbers are compared by magnitude (like complex::operator<)
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    T min(const NArray<T>& arr) {
+        if (arr.get_total_size() == 0)
+            throw error::ValueError("Cannot take the minimum of an empty array.");
+        return util::extremum<false, false>(arr.get_data(), arr.get_total_size());
+    }
 
-        for (int m = 0; m < outer; ++m) {
-            for (int n = 0; n < axis_size; ++n) {
-                for (int k = 0; k < inner; ++k) {
-                    out(m * inner + k) +=
-                        arr(m * axis_size * inner + n * inner + k);
-                }
-            }
-        }
-        auto out_shape = shape.dimensions;
-        out_shape.erase(out_shape.begin() + axis);
-        return out.reshape(std::move(out_shape));
+    // Returns the smallest elements along the given axes
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<T> min(const NArray<T>& arr, const std::vector<int>& axes, const bool keepdims = false) {
+        return util::extremum_along<false, false>(arr, util::get_axes_mask(arr.get_shape(), axes), keepdims);
+    }
+
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<T> min(const NArray<T>& arr, const int axis, const bool keepdims = false) {
+        return min(arr, std::vector<int>{axis}, keepdims);
+    }
+
+
+    // Flattens the array and returns the largest element
+    // NaNs propagate, and complex numbers are compared by magnitude (like complex::operator<)
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    T max(const NArray<T>& arr) {
+        if (arr.get_total_size() == 0)
+            throw error::ValueError("Cannot take the maximum of an empty array.");
+        return util::extremum<true, false>(arr.get_data(), arr.get_total_size());
+    }
+
+    // Returns the largest elements along the given axes
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<T> max(const NArray<T>& arr, const std::vector<int>& axes, const bool keepdims = false) {
+        return util::extremum_along<true, false>(arr, util::get_axes_mask(arr.get_shape(), axes), keepdims);
+    }
+
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<T> max(const NArray<T>& arr, const int axis, const bool keepdims = false) {
+        return max(arr, std::vector<int>{axis}, keepdims);
+    }
+
+
+    // Flattens the array and returns the smallest element, ignoring NaNs (NaN if there is nothing else)
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    T nanmin(const NArray<T>& arr) {
+        if (arr.get_total_size() == 0)
+            throw error::ValueError("Cannot take the minimum of an empty array.");
+        return util::extremum<false, true>(arr.get_data(), arr.get_total_size());
+    }
+
+    // Returns the smallest elements along the given axes, ignoring NaNs
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<T> nanmin(const NArray<T>& arr, const std::vector<int>& axes, const bool keepdims = false) {
+        return util::extremum_along<false, true>(arr, util::get_axes_mask(arr.get_shape(), axes), keepdims);
+    }
+
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<T> nanmin(const NArray<T>& arr, const int axis, const bool keepdims = false) {
+        return nanmin(arr, std::vector<int>{axis}, keepdims);
+    }
+
+
+    // Flattens the array and returns the largest element, ignoring NaNs (NaN if there is nothing else)
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    T nanmax(const NArray<T>& arr) {
+        if (arr.get_total_size() == 0)
+            throw error::ValueError("Cannot take the maximum of an empty array.");
+        return util::extremum<true, true>(arr.get_data(), arr.get_total_size());
+    }
+
+    // Returns the largest elements along the given axes, ignoring NaNs
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<T> nanmax(const NArray<T>& arr, const std::vector<int>& axes, const bool keepdims = false) {
+        return util::extremum_along<true, true>(arr, util::get_axes_mask(arr.get_shape(), axes), keepdims);
+    }
+
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<T> nanmax(const NArray<T>& arr, const int axis, const bool keepdims = false) {
+        return nanmax(arr, std::vector<int>{axis}, keepdims);
+    }
+
+
+    // Returns the flat index of the (first) smallest element, or of the first NaN
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    size_t argmin(const NArray<T>& arr) {
+        if (arr.get_total_size() == 0)
+            throw error::ValueError("Cannot take the argmin of an empty array.");
+        return util::arg_extremum<false, false>(arr.get_data(), arr.get_total_size());
+    }
+
+    // Returns the indices of the smallest elements along an axis
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<size_t> argmin(const NArray<T>& arr, const int axis, const bool keepdims = false) {
+        return util::arg_extremum_along<false, false>(arr, axis, keepdims);
+    }
+
+
+    // Returns the flat index of the (first) largest element, or of the first NaN
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    size_t argmax(const NArray<T>& arr) {
+        if (arr.get_total_size() == 0)
+            throw error::ValueError("Cannot take the argmax of an empty array.");
+        return util::arg_extremum<true, false>(arr.get_data(), arr.get_total_size());
+    }
+
+    // Returns the indices of the largest elements along an axis
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<size_t> argmax(const NArray<T>& arr, const int axis, const bool keepdims = false) {
+        return util::arg_extremum_along<true, false>(arr, axis, keepdims);
+    }
+
+
+    // Returns the flat index of the smallest element, ignoring NaNs
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    size_t nanargmin(const NArray<T>& arr) {
+        const size_t i = util::arg_extremum<false, true>(arr.get_data(), arr.get_total_size());
+        if (i == arr.get_total_size()) throw error::ValueError("All-NaN slice encountered.");
+        return i;
+    }
+
+    // Returns the indices of the smallest elements along an axis, ignoring NaNs
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<size_t> nanargmin(const NArray<T>& arr, const int axis, const bool keepdims = false) {
+        return util::arg_extremum_along<false, true>(arr, axis, keepdims);
+    }
+
+
+    // Returns the flat index of the largest element, ignoring NaNs
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    size_t nanargmax(const NArray<T>& arr) {
+        const size_t i = util::arg_extremum<true, true>(arr.get_data(), arr.get_total_size());
+        if (i == arr.get_total_size()) throw error::ValueError("All-NaN slice encountered.");
+        return i;
+    }
+
+    // Returns the indices of the largest elements along an axis, ignoring NaNs
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<size_t> nanargmax(const NArray<T>& arr, const int axis, const bool keepdims = false) {
+        return util::arg_extremum_along<true, true>(arr, axis, keepdims);
+    }
+
+
+    // Flattens the array and returns the smallest and the largest element, found together in one pass
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    std::pair<T, T> minmax(const NArray<T>& arr) {
+        if (arr.get_total_size() == 0)
+            throw error::ValueError("Cannot take the minimum and maximum of an empty array.");
+        return util::minmax_extrema(arr.get_data(), arr.get_total_size());
+    }
+
+    // Returns the smallest and the largest elements along the given axes
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    std::pair<NArray<T>, NArray<T>> minmax(const NArray<T>& arr, const std::vector<int>& axes, const bool keepdims = false) {
+        return util::minmax_along(arr, util::get_axes_mask(arr.get_shape(), axes), keepdims);
+    }
+
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    std::pair<NArray<T>, NArray<T>> minmax(const NArray<T>& arr, const int axis, const bool keepdims = false) {
+        return minmax(arr, std::vector<int>{axis}, keepdims);
+    }
+
+
+    // Flattens the array and returns the range of values (maximum - minimum)
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    T ptp(const NArray<T>& arr) {
+        const auto [lo, hi] = minmax(arr);
+        return hi - lo;
+    }
+
+    // Returns the range of values (maximum - minimum) along the given axes
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<T> ptp(const NArray<T>& arr, const std::vector<int>& axes, const bool keepdims = false) {
+        auto [lo, hi] = minmax(arr, axes, keepdims);
+        for (size_t i = 0; i < hi.get_total_size(); i++)
+            hi.get_data()[i] = hi.get_data()[i] - lo.get_data()[i];
+        return std::move(hi);
+    }
+
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<T> ptp(const NArray<T>& arr, const int axis, const bool keepdims = false) {
+        return ptp(arr, std::vector<int>{axis}, keepdims);
     }
 
 
     // Flattens the array and returns the mean
     template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
     T mean(const NArray<T>& arr) {
-        T sum = T(), size = arr.get_total_size();
-        for (const T& elem : arr) {
-            sum += elem;
-        }
-        return sum/size;
+        return sum(arr)/static_cast<T>(arr.get_total_size());
+    }
+
+    // Returns the mean of an array along the given axes
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    auto mean(const NArray<T>& arr, const std::vector<int>& axes, const bool keepdims = false) {
+        const auto mask = util::get_axes_mask(arr.get_shape(), axes);
+        const auto count = static_cast<double>(util::get_reduction_size(arr.get_shape(), mask));
+        return sum(arr, axes, keepdims)/count;
     }
 
     // Returns the mean of an array along an axis
     template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
-    NArray<double> mean(const NArray<T>& arr, int axis) {
-        return sum(arr, axis)/static_cast<double>(arr.get_shape()[axis]);
+    auto mean(const NArray<T>& arr, const int axis, const bool keepdims = false) {
+        return mean(arr, std::vector<int>{axis}, keepdims);
     }
 
 
+    // Returns true if any element of the flattened array is non-zero
     template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
-    NArray<T> diff(const NArray<T>& arr, const uint16_t n = 1, int axis = -1) {
-        if (n == 0) return arr;
+    bool any(const NArray<T>& arr) {
+        for (const auto& elem : arr)
+            if (elem != T()) return true;
+        return false;
+    }
+
+    // Tests whether any element along the given axes is non-zero
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<bool> any(const NArray<T>& arr, const std::vector<int>& axes, const bool keepdims = false) {
+        return util::reduce_predicate(arr, util::get_axes_mask(arr.get_shape(), axes), keepdims, false);
+    }
+
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<bool> any(const NArray<T>& arr, const int axis, const bool keepdims = false) {
+        return any(arr, std::vector<int>{axis}, keepdims);
+    }
+
+
+    // Returns true if every element of the flattened array is non-zero
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    bool all(const NArray<T>& arr) {
+        for (const auto& elem : arr)
+            if (elem == T()) return false;
+        return true;
+    }
+
+    // Tests whether all elements along the given axes are non-zero
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<bool> all(const NArray<T>& arr, const std::vector<int>& axes, const bool keepdims = false) {
+        return util::reduce_predicate(arr, util::get_axes_mask(arr.get_shape(), axes), keepdims, true);
+    }
+
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<bool> all(const NArray<T>& arr, const int axis, const bool keepdims = false) {
+        return all(arr, std::vector<int>{axis}, keepdims);
+    }
+
 
+    // Returns the inclusive scan of the flattened array with an associative binary operation `op`
+    template <typename T, typename Op>
+    NArray<T> scan(const NArray<T>& arr, Op op) {
+        NArray<T> out(Shape{arr.get_total_size()});
+        util::parallel_scan(arr.get_data(), out.get_data(), arr.get_total_size(), op);
+        return out;
+    }
+
+    // Returns the inclusive scan along an axis with an associative binary operation `op`
+    template <typename T, typename Op>
+    NArray<T> scan(const NArray<T>& arr, Op op, const int axis) {
         const Shape& shape = arr.get_shape();
-        const size_t ndim = shape.get_Ndim();
+        const size_t ax = util::normalize_axis(axis, shape.get_Ndim());
+
+        const auto [outer, inner] = util::get_outer_inner(shape, ax);
+
+        NArray<T> out(shape);
+        if (outer == 1 && inner == 1)
+            util::parallel_scan(arr.get_data(), out.get_data(), shape[ax], op);
+        else
+            util::scan_axis(arr.get_data(), out.get_data(), outer, shape[ax], inner, op);
+        return out;
+    }
+
+
+    // Returns the cumulative sum of the flattened array
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<T> cumsum(const NArray<T>& arr) {
+        return scan(arr, std::plus<T>());
+    }
+
+    // Returns the cumulative sum along an axis
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<T> cumsum(const NArray<T>& arr, const int axis) {
+        return scan(arr, std::plus<T>(), axis);
+    }
+
+
+    // Returns the cumulative product of the flattened array
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<T> cumprod(const NArray<T>& arr) {
+        return scan(arr, std::multiplies<T>());
+    }
+
+    // Returns the cumulative product along an axis
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<T> cumprod(const NArray<T>& arr, const int axis) {
+        return scan(arr, std::multiplies<T>(), axis);
+    }
 
-        // Adjust axis
-        if (axis < 0) axis += ndim;
+
+    // Returns the n-th discrete difference along an axis
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<T> diff(const NArray<T>& arr, const uint16_t n = 1, const int axis = -1) {
+        if (n == 0) return arr;
+
+        const Shape& shape = arr.get_shape();
+        const size_t ax = util::normalize_axis(axis, shape.get_Ndim());
 
         // If the diff is to be computed a number of times > the number of elements on said axis, return an empty array
-        if (shape[axis] <= n) {
+        if (shape[ax] <= n) {
             std::cerr << "Warning: Returned an empty array. n >= Shape[axis]." << std::endl;
             return NArray<T>();
         }
 
-        Shape out_shape = shape;
-        out_shape(axis) -= n;
+        const auto [outer, inner] = util::get_outer_inner(shape, ax);
 
-        size_t in_strides[ndim];
-        size_t out_strides[ndim];
-        Shape::compute_strides(shape, in_strides, ndim);
-        Shape::compute_strides(out_shape, out_strides, ndim);
+        Shape out_shape = shape;
+        out_shape(ax) -= n;
 
         NArray<T> out(out_shape);
-        const size_t axis_stride = in_strides[axis];
-
-        // For each output element
-        for (size_t out_idx = 0; out_idx < out_shape.get_total_size(); out_idx++) {
-            // Convert flat output index to multi-dimensional coords
-            size_t coords[ndim];
-            size_t temp = out_idx;
-            for (size_t d = 0; d < ndim; d++) {
-                coords[d] = temp / out_strides[d];
-                temp %= out_strides[d];
-            }
-
-            // Convert coordinates to input flat index
-            size_t in_idx = 0;
-            for (size_t d = 0; d < ndim; d++) {
-                in_idx += coords[d] * in_strides[d];
-            }
-
-            // Compute n-th order difference using binomial coefficients
-            T result = 0;
-            int sign = 1;
-            for (uint16_t k = 0; k <= n; k++) {
-                // Binomial coefficient: C(n, k)
-                int coeff = 1;
-                for (uint16_t j = 0; j < k; j++) {
-                    coeff = coeff * (n - j) / (j + 1);
-                }
-                result += sign * coeff * arr(in_idx + (n - k) * axis_stride);
-                sign = -sign;
-            }
-            out(out_idx) = result;
+        util::diff_axis(arr.get_data(), out.get_data(), outer, shape[ax], inner, n);
+        return out;
+    }
+
+
+    /* Returns the gradient along an axis, with samples `spacing` apart.
+     * Interior points use second-order central differences, and the edges use one-sided differences
+     * of order `edge_order` (1 or 2). */
+    template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+    NArray<floating_type_t<T>> gradient(
+        const NArray<T>& arr, const int axis, const double spacing = 1.0, const int edge_order = 1
+    ) {
+        using R = floating_type_t<T>;
+
+        const Shape& shape = arr.get_shape();
+        const size_t ax = util::normalize_axis(axis, shape.get_Ndim());
+
+        if (edge_order != 1 && edge_order != 2)
+            throw error::ValueError("edge_order must be 1 or 2, got " + util::toString(edge_order) + ".");
+        if (shape[ax] < static_cast<size_t>(edge_order) + 1) {
+            throw error::ValueError("Shape of the array along the gradient axis must be at least "
+                + util::toString(edge_order + 1) + ".");
         }
+
+        const auto [outer, inner] = util::get_outer_inner(shape, ax);
+
+        NArray<R> out(shape);
+        util::gradient_axis(arr.get_data(), out.get_data(), outer, shape[ax], inner,
+            static_cast<R>(spacing), edge_order);
         return out;
     }
+
+    // Returns the gradient along each of the given axes
+    template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+    std::vector<NArray<floating_type_t<T>>> gradient(
+        const NArray<T>& arr, const std::vector<int>& axes, const double spacing = 1.0, const int edge_order = 1
+    ) {
+        std::vector<NArray<floating_type_t<T>>> out;
+        out.reserve(axes.size());
+        for (const int axis : axes) out.push_back(gradient(arr, axis, spacing, edge_order));
+        return out;
+    }
+
+    // Returns the gradient along every axis
+    template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+    std::vector<NArray<floating_type_t<T>>> gradient(const NArray<T>& arr) {
+        std::vector<int> axes(arr.get_shape().get_Ndim());
+        for (size_t d = 0; d < axes.size(); d++) axes[d] = static_cast<int>(d);
+        return gradient(arr, axes);
+    }
 } // namespace numxx
\ No newline at end of file
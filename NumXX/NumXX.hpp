@@ -10,4 +10,10 @@
 #include "FFT.hpp"
 #include "FileHandling.hpp"
 #include "Linalg.hpp"
+#include "Einsum.hpp"
+#include "Sparse.hpp"
+#include "Iterative.hpp"
 #include "Misc.hpp"
+#include "Statistics.hpp"
+#include "Sorting.hpp"
+#include "SetOps.hpp"
@@ -0,0 +1,121 @@
+/* SetOps.hpp */
+#pragma once
+
+#include <vector>
+
+#include "Core/NArray.hpp"
+#include "Utils/SetUtils.hpp"
+
+
+namespace numxx {
+
+    // Distinct values of an array together with where they occur
+    template <typename T>
+    struct UniqueResult {
+        NArray<T> values;                 // the distinct values, sorted
+        NArray<size_t> indices;           // flat index of the first occurrence of every value
+        NArray<size_t> inverse_indices;   // index into `values` of every element, in the shape of the input
+        NArray<size_t> counts;            // number of occurrences of every value
+    };
+
+
+    // Returns the sorted distinct values of the flattened array
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<T> unique(const NArray<T>& arr) {
+        return NArray<T>(util::get_sorted_unique(arr.get_data(), arr.get_total_size()));
+    }
+
+
+    /* Returns the sorted distinct values of the flattened array, the index of their first occurrences, the
+     * inverse indices that rebuild the array from the values, and the counts of every value.
+     * A single stable argsort (a radix sort for real numbers) groups equal elements, then one pass over the
+     * groups fills every output. All NaNs count as one value. */
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    UniqueResult<T> unique_all(const NArray<T>& arr) {
+        const size_t n = arr.get_total_size();
+        const T* data = arr.get_data();
+
+        std::vector<size_t> order(n);
+        util::set_argsort(data, order.data(), n);
+
+        std::vector<T> values;
+        std::vector<size_t> first, counts;
+        NArray<size_t> inverse(arr.get_shape());
+        size_t* inv = inverse.get_data();
+
+        for (size_t i = 0; i < n; i++) {
+            const size_t idx = order[i];
+            if (i == 0 || !util::set_equal(data[order[i - 1]], data[idx])) {
+                values.push_back(data[idx]);
+                first.push_back(idx);
+                counts.push_back(0);
+            }
+            counts.back()++;
+            inv[idx] = values.size() - 1;
+        }
+
+        return {
+            NArray<T>(std::move(values)), NArray<size_t>(std::move(first)),
+            std::move(inverse), NArray<size_t>(std::move(counts))
+        };
+    }
+
+    // Returns the sorted distinct values of the flattened array and the number of times each occurs
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    std::pair<NArray<T>, NArray<size_t>> unique_counts(const NArray<T>& arr) {
+        auto result = unique_all(arr);
+        return {std::move(result.values), std::move(result.counts)};
+    }
+
+    // Returns the sorted distinct values of the flattened array and the indices into them that rebuild the array
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    std::pair<NArray<T>, NArray<size_t>> unique_inverse(const NArray<T>& arr) {
+        auto result = unique_all(arr);
+        return {std::move(result.values), std::move(result.inverse_indices)};
+    }
+
+
+    // Returns whether every element of `element` occurs in `test_elements` (or does not, if `invert` is set)
+    // The result has the shape of `element`
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<bool> isin(const NArray<T>& element, const NArray<T>& test_elements, const bool invert = false) {
+        NArray<bool> out(element.get_shape());
+        util::isin_contiguous(element.get_data(), element.get_total_size(),
+            test_elements.get_data(), test_elements.get_total_size(), out.get_data(), invert);
+        return out;
+    }
+
+    // Returns whether every element of the flattened `a` occurs in `b` (or does not, if `invert` is set)
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<bool> in1d(const NArray<T>& a, const NArray<T>& b, const bool invert = false) {
+        NArray<bool> out(Shape{a.get_total_size()});
+        util::isin_contiguous(a.get_data(), a.get_total_size(), b.get_data(), b.get_total_size(), out.get_data(), invert);
+        return out;
+    }
+
+
+    // Returns the sorted distinct values found in both arrays
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<T> intersect1d(const NArray<T>& a, const NArray<T>& b, const bool assume_unique = false) {
+        return NArray<T>(util::select_members(
+            a.get_data(), a.get_total_size(), b.get_data(), b.get_total_size(), assume_unique, false
+        ));
+    }
+
+    // Returns the sorted distinct values of `a` that are not in `b`
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<T> setdiff1d(const NArray<T>& a, const NArray<T>& b, const bool assume_unique = false) {
+        return NArray<T>(util::select_members(
+            a.get_data(), a.get_total_size(), b.get_data(), b.get_total_size(), assume_unique, true
+        ));
+    }
+
+    // Returns the sorted distinct values found in either array
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<T> union1d(const NArray<T>& a, const NArray<T>& b) {
+        std::vector<T> both(a.get_data(), a.get_data() + a.get_total_size());
+        both.insert(both.end(), b.get_data(), b.get_data() + b.get_total_size());
+        return NArray<T>(util::get_sorted_unique(both.data(), both.size()));
+    }
+
+} // namespace numxx
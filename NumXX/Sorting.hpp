@@ -0,0 +1,147 @@
+/* Sorting.hpp */
+#pragma once
+
+#include "Core/NArray.hpp"
+#include "Utils/ReduceUtils.hpp"
+#include "Utils/SortUtils.hpp"
+#include "Utils/SelectUtils.hpp"
+
+
+namespace numxx {
+
+    /* Returns a copy of the array sorted along an axis.
+     * Integer and floating point arrays use a parallel LSD radix sort (which is always stable), other types
+     * use a parallel merge sort, stable if `stable` is set. NaNs are sorted to the end. */
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<T> sort(const NArray<T>& arr, const int axis = -1, const bool stable = false) {
+        const Shape& shape = arr.get_shape();
+        NArray<T> out(shape);
+        if (shape.get_Ndim() == 0) return out;
+
+        const size_t ax = util::normalize_axis(axis, shape.get_Ndim());
+        const auto [outer, inner] = util::get_outer_inner(shape, ax);
+        util::sort_axis(arr.get_data(), out.get_data(), outer, shape[ax], inner, stable);
+        return out;
+    }
+
+
+    // Returns the indices that sort the array along an axis (equal elements keep their order if `stable` is set)
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<size_t> argsort(const NArray<T>& arr, const int axis = -1, const bool stable = false) {
+        const Shape& shape = arr.get_shape();
+        NArray<size_t> out(shape);
+        if (shape.get_Ndim() == 0) return out;
+
+        const size_t ax = util::normalize_axis(axis, shape.get_Ndim());
+        const auto [outer, inner] = util::get_outer_inner(shape, ax);
+        util::argsort_axis(arr.get_data(), out.get_data(), outer, shape[ax], inner, stable);
+        return out;
+    }
+
+
+    /* Returns a copy of the array partitioned along an axis around the positions in `kth`: every such position
+     * holds the element a sorted copy would have there, with no greater element before it and no smaller one
+     * after it. The order within the parts is unspecified. */
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<T> partition(const NArray<T>& arr, const std::vector<size_t>& kth, const int axis = -1) {
+        const Shape& shape = arr.get_shape();
+        const size_t ax = util::normalize_axis(axis, shape.get_Ndim());
+        const auto positions = util::get_kth_positions(kth, shape[ax]);
+        const auto [outer, inner] = util::get_outer_inner(shape, ax);
+
+        NArray<T> out(shape);
+        util::partition_axis(arr.get_data(), out.get_data(), outer, shape[ax], inner, positions);
+        return out;
+    }
+
+    // Returns a copy of the array partitioned along an axis around position `kth`
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<T> partition(const NArray<T>& arr, const size_t kth, const int axis = -1) {
+        return partition(arr, std::vector<size_t>{kth}, axis);
+    }
+
+
+    // Returns the indices that partition the array along an axis around the positions in `kth`
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<size_t> argpartition(const NArray<T>& arr, const std::vector<size_t>& kth, const int axis = -1) {
+        const Shape& shape = arr.get_shape();
+        const size_t ax = util::normalize_axis(axis, shape.get_Ndim());
+        const auto positions = util::get_kth_positions(kth, shape[ax]);
+        const auto [outer, inner] = util::get_outer_inner(shape, ax);
+
+        NArray<size_t> out(shape);
+        util::argpartition_axis(arr.get_data(), out.get_data(), outer, shape[ax], inner, positions);
+        return out;
+    }
+
+    // Returns the indices that partition the array along an axis around position `kth`
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<size_t> argpartition(const NArray<T>& arr, const size_t kth, const int axis = -1) {
+        return argpartition(arr, std::vector<size_t>{kth}, axis);
+    }
+
+
+    /* Returns the k largest (or smallest) elements along an axis and their indices, best first.
+     * NaNs count as larger than any number, and equal elements are ordered by index. */
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    std::pair<NArray<T>, NArray<size_t>> topk(
+        const NArray<T>& arr, const size_t k, const int axis = -1, const bool largest = true
+    ) {
+        const Shape& shape = arr.get_shape();
+        const size_t ax = util::normalize_axis(axis, shape.get_Ndim());
+        if (k > shape[ax]) {
+            throw error::ValueError("k(=" + util::toString(k) + ") is larger than the axis length "
+                + util::toString(shape[ax]) + ".");
+        }
+        const auto [outer, inner] = util::get_outer_inner(shape, ax);
+
+        Shape out_shape = shape;
+        out_shape(ax) = k;
+        NArray<T> values(out_shape);
+        NArray<size_t> indices(std::move(out_shape));
+        util::topk_axis(arr.get_data(), values.get_data(), indices.get_data(), outer, shape[ax], inner, k, largest);
+        return {std::move(values), std::move(indices)};
+    }
+
+
+    /* Returns the indices at which `values` would be inserted into the flattened, sorted array `sorted` to keep it
+     * sorted: before equal elements, or after them if `right` is set. NaNs are taken to sort last.
+     * Many searches against an array much larger than the cache use a prefetching Eytzinger layout of it; otherwise
+     * every search is a branchless binary search. The searches run in parallel. */
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    NArray<size_t> searchsorted(const NArray<T>& sorted, const NArray<T>& values, const bool right = false) {
+        const T* a = sorted.get_data();
+        const T* v = values.get_data();
+        const size_t n = sorted.get_total_size();
+        const size_t m = values.get_total_size();
+        const auto less = [] (const T& x, const T& y) { return util::sort_less(x, y); };
+
+        NArray<size_t> out(values.get_shape());
+        size_t* res = out.get_data();
+
+        if (n > (1 << 22) && m >= n / 4) {
+            const util::EytzingerLayout<T> tree(a, n);
+            util::parallel_for(m, 1 << 12, [&] (const size_t begin, const size_t end, size_t) {
+                for (size_t i = begin; i < end; i++)
+                    res[i] = right ? tree.template search<true>(v[i], less) : tree.template search<false>(v[i], less);
+            });
+        } else {
+            util::parallel_for(m, 1 << 12, [&] (const size_t begin, const size_t end, size_t) {
+                for (size_t i = begin; i < end; i++) {
+                    res[i] = right ? util::branchless_search<true>(a, n, v[i], less)
+                                   : util::branchless_search<false>(a, n, v[i], less);
+                }
+            });
+        }
+        return out;
+    }
+
+    // Returns the index at which `value` would be inserted into the flattened, sorted array `sorted`
+    template <typename T, typename = std::enable_if_t<is_complex_or_arithmetic_v<T>>>
+    size_t searchsorted(const NArray<T>& sorted, const T& value, const bool right = false) {
+        const auto less = [] (const T& x, const T& y) { return util::sort_less(x, y); };
+        return right ? util::branchless_search<true>(sorted.get_data(), sorted.get_total_size(), value, less)
+                     : util::branchless_search<false>(sorted.get_data(), sorted.get_total_size(), value, less);
+    }
+
+} // namespace numxx
@@ -0,0 +1,456 @@
+/* Sparse.hpp */
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "Core/NArray.hpp"
+#include "Utils/SparseUtils.hpp"
+
+
+namespace numxx::sparse {
+
+template <typename dtype> class CSR;
+template <typename dtype> class CSC;
+
+
+/* Sparse matrix in coordinate format: parallel arrays of row indices, column indices and values, in any order.
+ * It is the format to assemble a matrix in, one element at a time; duplicate entries are allowed and are summed
+ * when converting to another format. Products go through CSR or CSC. */
+template <typename dtype = double>
+class COO {
+protected:
+    /* ====== Member Variables ====== */
+
+    size_t _rows = 0, _cols = 0;
+    std::vector<size_t> _row_indices, _col_indices;
+    std::vector<dtype> _values;
+
+
+public:
+    /* ====== Constructors ====== */
+
+    // Default constructor
+    COO() = default;
+
+
+    // Empty rows x cols matrix
+    COO(const size_t rows, const size_t cols) : _rows(rows), _cols(cols) {}
+
+
+    // Matrix from the coordinates and values of its stored elements
+    COO(const size_t rows, const size_t cols,
+        std::vector<size_t> row_indices, std::vector<size_t> col_indices, std::vector<dtype> values
+    ) : _rows(rows), _cols(cols),
+        _row_indices(std::move(row_indices)), _col_indices(std::move(col_indices)), _values(std::move(values))
+    {
+        if (_row_indices.size() != _values.size() || _col_indices.size() != _values.size())
+            throw error::ValueError("Row indices, column indices and values must have the same length.");
+        for (size_t p = 0; p < _values.size(); p++) {
+            if (_row_indices[p] >= _rows || _col_indices[p] >= _cols)
+                throw error::ValueError("Sparse matrix index is out of range.");
+        }
+    }
+
+
+    // Stores the nonzero elements of a 2D NArray
+    explicit COO(const NArray<dtype>& dense) {
+        const Shape& shape = dense.get_shape();
+        if (shape.get_Ndim() != 2)
+            throw error::ShapeError("Sparse matrices need a 2D array, but got the shape " + util::toString(shape) + ".");
+        _rows = shape[0];
+        _cols = shape[1];
+        const dtype* data = dense.get_data();
+        for (size_t i = 0; i < _rows; i++) {
+            for (size_t j = 0; j < _cols; j++) {
+                if (data[i * _cols + j] == dtype(0)) continue;
+                _row_indices.push_back(i);
+                _col_indices.push_back(j);
+                _values.push_back(data[i * _cols + j]);
+            }
+        }
+    }
+
+
+    /* ====== Helper functions ====== */
+
+    [[nodiscard]] Shape get_shape() const { return Shape({_rows, _cols}); }
+    [[nodiscard]] size_t get_nnz() const { return _values.size(); }
+    [[nodiscard]] const std::vector<size_t>& get_row_indices() const { return _row_indices; }
+    [[nodiscard]] const std::vector<size_t>& get_col_indices() const { return _col_indices; }
+    [[nodiscard]] const std::vector<dtype>& get_values() const { return _values; }
+
+
+    // Appends the element (i, j) with the given value; it adds to any element already stored there
+    void insert(const size_t i, const size_t j, const dtype& value) {
+        if (i >= _rows || j >= _cols) throw error::ValueError("Sparse matrix index is out of range.");
+        _row_indices.push_back(i);
+        _col_indices.push_back(j);
+        _values.push_back(value);
+    }
+
+
+    /* ====== Conversions ====== */
+
+    [[nodiscard]] NArray<dtype> to_dense() const {
+        NArray<dtype> out(Shape({_rows, _cols}), dtype(0));
+        dtype* data = out.get_data();
+        for (size_t p = 0; p < _values.size(); p++) data[_row_indices[p] * _cols + _col_indices[p]] += _values[p];
+        return out;
+    }
+
+    [[nodiscard]] CSR<dtype> to_csr() const;
+    [[nodiscard]] CSC<dtype> to_csc() const;
+
+
+    /* ====== Operations ====== */
+
+    // Returns the transpose, which swaps the index arrays
+    [[nodiscard]] COO transpose() const {
+        return COO(_cols, _rows, _col_indices, _row_indices, _values);
+    }
+
+    COO& operator*=(const dtype& scalar) {
+        for (auto& v : _values) v *= scalar;
+        return *this;
+    }
+
+    [[nodiscard]] COO operator*(const dtype& scalar) const {
+        COO out(*this);
+        return out *= scalar;
+    }
+};
+
+
+/* Sparse matrix in compressed sparse row format: the column indices and values of the stored elements, row
+ * after row, with indptr[i] the position of the first element of row i (and indptr[rows] the count).
+ * Memory is proportional to the number of stored elements plus the number of rows. The products are split
+ * across threads by ranges of rows holding equal numbers of stored elements. */
+template <typename dtype = double>
+class CSR {
+protected:
+    /* ====== Member Variables ====== */
+
+    size_t _rows = 0, _cols = 0;
+    std::vector<size_t> _indptr{0}, _indices;
+    std::vector<dtype> _values;
+
+
+public:
+    /* ====== Constructors ====== */
+
+    // Default constructor
+    CSR() = default;
+
+
+    // Empty rows x cols matrix
+    CSR(const size_t rows, const size_t cols) : _rows(rows), _cols(cols), _indptr(rows + 1, 0) {}
+
+
+    // Matrix from its compressed arrays, which are checked for consistency
+    CSR(const size_t rows, const size_t cols,
+        std::vector<size_t> indptr, std::vector<size_t> indices, std::vector<dtype> values
+    ) : _rows(rows), _cols(cols), _indptr(std::move(indptr)), _indices(std::move(indices)), _values(std::move(values))
+    {
+        util::check_compressed(_rows, _cols, _indptr, _indices, _values);
+    }
+
+
+    // Stores the nonzero elements of a 2D NArray
+    explicit CSR(const NArray<dtype>& dense) {
+        const Shape& shape = dense.get_shape();
+        if (shape.get_Ndim() != 2)
+            throw error::ShapeError("Sparse matrices need a 2D array, but got the shape " + util::toString(shape) + ".");
+        _rows = shape[0];
+        _cols = shape[1];
+        _indptr.assign(_rows + 1, 0);
+        const dtype* data = dense.get_data();
+        for (size_t i = 0; i < _rows; i++) {
+            for (size_t j = 0; j < _cols; j++) {
+                if (data[i * _cols + j] == dtype(0)) continue;
+                _indices.push_back(j);
+                _values.push_back(data[i * _cols + j]);
+            }
+            _indptr[i + 1] = _values.size();
+        }
+    }
+
+
+    /* ====== Helper functions ====== */
+
+    [[nodiscard]] Shape get_shape() const { return Shape({_rows, _cols}); }
+    [[nodiscard]] size_t get_nnz() const { return _values.size(); }
+    [[nodiscard]] const std::vector<size_t>& get_indptr() const { return _indptr; }
+    [[nodiscard]] const std::vector<size_t>& get_indices() const { return _indices; }
+    [[nodiscard]] const std::vector<dtype>& get_values() const { return _values; }
+
+
+    /* ====== Conversions ====== */
+
+    [[nodiscard]] NArray<dtype> to_dense() const {
+        NArray<dtype> out(Shape({_rows, _cols}), dtype(0));
+        dtype* data = out.get_data();
+        for (size_t i = 0; i < _rows; i++)
+            for (size_t p = _indptr[i]; p < _indptr[i + 1]; p++) data[i * _cols + _indices[p]] += _values[p];
+        return out;
+    }
+
+    [[nodiscard]] COO<dtype> to_coo() const {
+        std::vector<size_t> rows(_values.size());
+        for (size_t i = 0; i < _rows; i++)
+            std::fill(rows.begin() + _indptr[i], rows.begin() + _indptr[i + 1], i);
+        return COO<dtype>(_rows, _cols, std::move(rows), _indices, _values);
+    }
+
+    [[nodiscard]] CSC<dtype> to_csc() const;
+
+
+    /* ====== Operations ====== */
+
+    // Returns the transpose, which has the same arrays read as compressed columns
+    [[nodiscard]] CSC<dtype> transpose() const;
+
+
+    // y = A * x, for raw arrays of cols and rows elements. This allocates nothing, for use inside iterative solvers
+    void spmv(const dtype* x, dtype* y) const {
+        util::csr_spmv(_indptr, _indices, _values, x, y);
+    }
+
+
+    // C = A * B, for the row-major dense matrices B (cols x k) and C (rows x k)
+    void spmm(const dtype* b, const size_t k, dtype* c) const {
+        util::csr_spmm(_indptr, _indices, _values, b, k, c);
+    }
+
+
+    // Multiplies the matrix by a dense vector (SpMV) or a dense matrix (SpMM)
+    [[nodiscard]] NArray<dtype> dot(const NArray<dtype>& other) const {
+        const Shape& shape = other.get_shape();
+        if (shape.get_Ndim() == 0 || shape.get_Ndim() > 2 || shape[0] != _cols)
+            throw error::ShapeError(get_shape(), shape, "multiply");
+
+        if (shape.get_Ndim() == 1) {
+            NArray<dtype> out(Shape({_rows}));
+            spmv(other.get_data(), out.get_data());
+            return out;
+        }
+        NArray<dtype> out(Shape({_rows, shape[1]}));
+        spmm(other.get_data(), shape[1], out.get_data());
+        return out;
+    }
+
+
+    CSR& operator*=(const dtype& scalar) {
+        for (auto& v : _values) v *= scalar;
+        return *this;
+    }
+
+    [[nodiscard]] CSR operator*(const dtype& scalar) const {
+        CSR out(*this);
+        return out *= scalar;
+    }
+
+
+    // Multiplies row i by factors[i], i.e. computes diag(factors) * A in place
+    CSR& scale_rows(const NArray<dtype>& factors) {
+        if (factors.get_total_size() != _rows)
+            throw error::ShapeError("Expected " + std::to_string(_rows) + " row factors.");
+        const dtype* f = factors.get_data();
+        for (size_t i = 0; i < _rows; i++)
+            for (size_t p = _indptr[i]; p < _indptr[i + 1]; p++) _values[p] *= f[i];
+        return *this;
+    }
+
+
+    // Multiplies column j by factors[j], i.e. computes A * diag(factors) in place
+    CSR& scale_columns(const NArray<dtype>& factors) {
+        if (factors.get_total_size() != _cols)
+            throw error::ShapeError("Expected " + std::to_string(_cols) + " column factors.");
+        const dtype* f = factors.get_data();
+        for (size_t p = 0; p < _values.size(); p++) _values[p] *= f[_indices[p]];
+        return *this;
+    }
+};
+
+
+/* Sparse matrix in compressed sparse column format: the row indices and values of the stored elements, column
+ * after column, with indptr[j] the position of the first element of column j (and indptr[cols] the count).
+ * It is the transpose of CSR's layout, suited to column access and to products with A^T. */
+template <typename dtype = double>
+class CSC {
+protected:
+    /* ====== Member Variables ====== */
+
+    size_t _rows = 0, _cols = 0;
+    std::vector<size_t> _indptr{0}, _indices;
+    std::vector<dtype> _values;
+
+
+public:
+    /* ====== Constructors ====== */
+
+    // Default constructor
+    CSC() = default;
+
+
+    // Empty rows x cols matrix
+    CSC(const size_t rows, const size_t cols) : _rows(rows), _cols(cols), _indptr(cols + 1, 0) {}
+
+
+    // Matrix from its compressed arrays, which are checked for consistency
+    CSC(const size_t rows, const size_t cols,
+        std::vector<size_t> indptr, std::vector<size_t> indices, std::vector<dtype> values
+    ) : _rows(rows), _cols(cols), _indptr(std::move(indptr)), _indices(std::move(indices)), _values(std::move(values))
+    {
+        util::check_compressed(_cols, _rows, _indptr, _indices, _values);
+    }
+
+
+    // Stores the nonzero elements of a 2D NArray
+    explicit CSC(const NArray<dtype>& dense) {
+        const Shape& shape = dense.get_shape();
+        if (shape.get_Ndim() != 2)
+            throw error::ShapeError("Sparse matrices need a 2D array, but got the shape " + util::toString(shape) + ".");
+        _rows = shape[0];
+        _cols = shape[1];
+        _indptr.assign(_cols + 1, 0);
+        const dtype* data = dense.get_data();
+        for (size_t j = 0; j < _cols; j++) {
+            for (size_t i = 0; i < _rows; i++) {
+                if (data[i * _cols + j] == dtype(0)) continue;
+                _indices.push_back(i);
+                _values.push_back(data[i * _cols + j]);
+            }
+            _indptr[j + 1] = _values.size();
+        }
+    }
+
+
+    /* ====== Helper functions ====== */
+
+    [[nodiscard]] Shape get_shape() const { return Shape({_rows, _cols}); }
+    [[nodiscard]] size_t get_nnz() const { return _values.size(); }
+    [[nodiscard]] const std::vector<size_t>& get_indptr() const { return _indptr; }
+    [[nodiscard]] const std::vector<size_t>& get_indices() const { return _indices; }
+    [[nodiscard]] const std::vector<dtype>& get_values() const { return _values; }
+
+
+    /* ====== Conversions ====== */
+
+    [[nodiscard]] NArray<dtype> to_dense() const {
+        NArray<dtype> out(Shape({_rows, _cols}), dtype(0));
+        dtype* data = out.get_data();
+        for (size_t j = 0; j < _cols; j++)
+            for (size_t p = _indptr[j]; p < _indptr[j + 1]; p++) data[_indices[p] * _cols + j] += _values[p];
+        return out;
+    }
+
+    [[nodiscard]] COO<dtype> to_coo() const {
+        std::vector<size_t> cols(_values.size());
+        for (size_t j = 0; j < _cols; j++)
+            std::fill(cols.begin() + _indptr[j], cols.begin() + _indptr[j + 1], j);
+        return COO<dtype>(_rows, _cols, _indices, std::move(cols), _values);
+    }
+
+    [[nodiscard]] CSR<dtype> to_csr() const {
+        std::vector<size_t> indptr, indices;
+        std::vector<dtype> values;
+        util::transpose_compressed(_rows, _indptr, _indices, _values, indptr, indices, values);
+        return CSR<dtype>(_rows, _cols, std::move(indptr), std::move(indices), std::move(values));
+    }
+
+
+    /* ====== Operations ====== */
+
+    // Returns the transpose, which has the same arrays read as compressed rows
+    [[nodiscard]] CSR<dtype> transpose() const {
+        return CSR<dtype>(_cols, _rows, _indptr, _indices, _values);
+    }
+
+
+    // y = A * x, for raw arrays of cols and rows elements
+    void spmv(const dtype* x, dtype* y) const {
+        util::csc_spmv(_rows, _indptr, _indices, _values, x, y);
+    }
+
+
+    // Multiplies the matrix by a dense vector (SpMV) or a dense matrix (SpMM, through the CSR form)
+    [[nodiscard]] NArray<dtype> dot(const NArray<dtype>& other) const {
+        const Shape& shape = other.get_shape();
+        if (shape.get_Ndim() == 0 || shape.get_Ndim() > 2 || shape[0] != _cols)
+            throw error::ShapeError(get_shape(), shape, "multiply");
+
+        if (shape.get_Ndim() == 1) {
+            NArray<dtype> out(Shape({_rows}));
+            spmv(other.get_data(), out.get_data());
+            return out;
+        }
+        return to_csr().dot(other);
+    }
+
+
+    CSC& operator*=(const dtype& scalar) {
+        for (auto& v : _values) v *= scalar;
+        return *this;
+    }
+
+    [[nodiscard]] CSC operator*(const dtype& scalar) const {
+        CSC out(*this);
+        return out *= scalar;
+    }
+
+
+    // Multiplies row i by factors[i], i.e. computes diag(factors) * A in place
+    CSC& scale_rows(const NArray<dtype>& factors) {
+        if (factors.get_total_size() != _rows)
+            throw error::ShapeError("Expected " + std::to_string(_rows) + " row factors.");
+        const dtype* f = factors.get_data();
+        for (size_t p = 0; p < _values.size(); p++) _values[p] *= f[_indices[p]];
+        return *this;
+    }
+
+
+    // Multiplies column j by factors[j], i.e. computes A * diag(factors) in place
+    CSC& scale_columns(const NArray<dtype>& factors) {
+        if (factors.get_total_size() != _cols)
+            throw error::ShapeError("Expected " + std::to_string(_cols) + " column factors.");
+        const dtype* f = factors.get_data();
+        for (size_t j = 0; j < _cols; j++)
+            for (size_t p = _indptr[j]; p < _indptr[j + 1]; p++) _values[p] *= f[j];
+        return *this;
+    }
+};
+
+
+/* ====== Conversions needing the full class definitions ====== */
+
+template <typename dtype>
+CSR<dtype> COO<dtype>::to_csr() const {
+    std::vector<size_t> indptr, indices;
+    std::vector<dtype> values;
+    util::compress_triplets(_rows, _cols, _row_indices, _col_indices, _values, indptr, indices, values);
+    return CSR<dtype>(_rows, _cols, std::move(indptr), std::move(indices), std::move(values));
+}
+
+template <typename dtype>
+CSC<dtype> COO<dtype>::to_csc() const {
+    std::vector<size_t> indptr, indices;
+    std::vector<dtype> values;
+    util::compress_triplets(_cols, _rows, _col_indices, _row_indices, _values, indptr, indices, values);
+    return CSC<dtype>(_rows, _cols, std::move(indptr), std::move(indices), std::move(values));
+}
+
+template <typename dtype>
+CSC<dtype> CSR<dtype>::to_csc() const {
+    std::vector<size_t> indptr, indices;
+    std::vector<dtype> values;
+    util::transpose_compressed(_cols, _indptr, _indices, _values, indptr, indices, values);
+    return CSC<dtype>(_rows, _cols, std::move(indptr), std::move(indices), std::move(values));
+}
+
+template <typename dtype>
+CSC<dtype> CSR<dtype>::transpose() const {
+    return CSC<dtype>(_cols, _rows, _indptr, _indices, _values);
+}
+
+} // namespace numxx::sparse
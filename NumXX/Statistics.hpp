@@ -0,0 +1,478 @@
+/* Statistics.hpp */
+#pragma once
+
+#include <cmath>
+#include <iterator>
+#include <limits>
+
+#include "Core/NArray.hpp"
+#include "Utils/Parallel.hpp"
+#include "Utils/ReduceUtils.hpp"
+#include "Utils/StatsUtils.hpp"
+#include "Utils/SelectUtils.hpp"
+#include "Utils/HistogramUtils.hpp"
+#include "Utils/ExtremaUtils.hpp"
+
+
+namespace numxx {
+
+    /* Accumulates the count, mean and variance of samples that arrive in chunks, in a single pass.
+     * The first axis of a chunk indexes samples and the remaining axes are features, so a chunk with
+     * shape (n, f) adds n samples of f features; a 1D chunk adds samples of a single feature.
+     * Accumulators filled separately (e.g. on different threads) can be combined with merge(). */
+    template <typename T = double>
+    class RunningStats {
+        static_assert(std::is_floating_point_v<T>, "RunningStats requires a floating point type.");
+
+        size_t _count = 0;
+        Shape _shape;
+        std::vector<T> _mean;
+        std::vector<T> _m2;
+
+    public:
+        /* ====== Constructors ====== */
+
+        RunningStats() = default;
+
+
+        /* ====== Accumulation ====== */
+
+        // Adds every sample in `chunk` to the statistics
+        template <typename U, typename = std::enable_if_t<std::is_arithmetic_v<U>>>
+        RunningStats& update(const NArray<U>& chunk) {
+            const Shape& shape = chunk.get_shape();
+            Shape feature_shape = (shape.get_Ndim() <= 1)
+                ? Shape{1}
+                : Shape(shape.dimensions.begin() + 1, shape.dimensions.end());
+
+            if (_mean.empty()) {
+                _shape = std::move(feature_shape);
+                _mean.assign(_shape.get_total_size(), T(0));
+                _m2.assign(_shape.get_total_size(), T(0));
+            } else if (feature_shape != _shape) {
+                throw error::ShapeError("Cannot add a chunk with feature shape " + util::toString(feature_shape)
+                    + " to statistics with feature shape " + util::toString(_shape) + ".");
+            }
+
+            const size_t width = _mean.size();
+            if (width == 0 || chunk.get_total_size() == 0) return *this;
+
+            const size_t rows = chunk.get_total_size() / width;
+            const U* data = chunk.get_data();
+
+            if (width == 1) {
+                util::Moments<T> total{_count, _mean[0], _m2[0]};
+                total.merge(util::parallel_moments<T>(data, rows));
+                _mean[0] = total.mean;
+                _m2[0] = total.m2;
+                _count = total.count;
+                return *this;
+            }
+
+            // Every thread runs Welford over its own block of rows, then the blocks are merged in order
+            const size_t grain = std::max<size_t>(1, (1 << 16) / width);
+            const size_t n_chunks = util::get_num_chunks(rows, grain);
+            std::vector<std::vector<T>> means(n_chunks, std::vector<T>(width, T(0)));
+            std::vector<std::vector<T>> m2s(n_chunks, std::vector<T>(width, T(0)));
+
+            util::parallel_for(rows, grain, [&] (const size_t begin, const size_t end, const size_t c) {
+                for (size_t r = begin; r < end; r++) {
+                    util::welford_row(data + r * width, width, r - begin + 1, means[c].data(), m2s[c].data());
+                }
+            });
+
+            for (size_t c = 0; c < n_chunks; c++) {
+                const size_t n = util::get_chunk_begin(rows, n_chunks, c + 1) - util::get_chunk_begin(rows, n_chunks, c);
+                util::merge_moments(_count, _mean.data(), _m2.data(), n, means[c].data(), m2s[c].data(), width);
+                _count += n;
+            }
+            return *this;
+        }
+
+
+        // Combines the statistics of another accumulator into this one
+        RunningStats& merge(const RunningStats& other) {
+            if (other._count == 0) return *this;
+            if (_count == 0) return *this = other;
+
+            if (other._shape != _shape) {
+                throw error::ShapeError("Cannot merge statistics with feature shapes " + util::toString(_shape)
+                    + " and " + util::toString(other._shape) + ".");
+            }
+            util::merge_moments(_count, _mean.data(), _m2.data(),
+                other._count, other._mean.data(), other._m2.data(), _mean.size());
+            _count += other._count;
+            return *this;
+        }
+
+
+        // Clears all accumulated samples
+        void reset() {
+            _count = 0;
+            _shape = Shape();
+            _mean.clear();
+            _m2.clear();
+        }
+
+
+        /* ====== Results ====== */
+
+        // Returns the number of samples seen per feature
+        [[nodiscard]] size_t count() const { return _count; }
+
+        // Returns the shape of a single sample
+        [[nodiscard]] const Shape& get_shape() const { return _shape; }
+
+        // Returns the mean of every feature
+        [[nodiscard]] NArray<T> mean() const {
+            return NArray<T>(_mean, _shape);
+        }
+
+        // Returns the variance of every feature, dividing by (count - ddof)
+        [[nodiscard]] NArray<T> var(const size_t ddof = 0) const {
+            const T denominator = (_count > ddof)
+                ? static_cast<T>(_count - ddof)
+                : std::numeric_limits<T>::quiet_NaN();
+
+            NArray<T> out(_shape);
+            for (size_t j = 0; j < _m2.size(); j++)
+                out.get_data()[j] = _m2[j] / denominator;
+            return out;
+        }
+
+        // Returns the standard deviation of every feature
+        [[nodiscard]] NArray<T> std(const size_t ddof = 0) const {
+            NArray<T> out = var(ddof);
+            for (auto& elem : out) elem = std::sqrt(elem);
+            return out;
+        }
+    };
+
+
+    /* Passed in place of an axis to reduce over the flattened array, as in var(arr, all_axes, ddof).
+     * A bare integer in that position is always an axis. */
+    struct AllAxes {};
+    inline constexpr AllAxes all_axes{};
+
+
+    // Returns the variance of the flattened array, dividing by (N - ddof)
+    template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+    floating_type_t<T> var(const NArray<T>& arr, AllAxes = all_axes, const size_t ddof = 0) {
+        using R = floating_type_t<T>;
+        using A = util::accumulator_t<R>;
+        if (arr.get_total_size() <= ddof) return std::numeric_limits<R>::quiet_NaN();
+
+        const auto moments = util::parallel_moments<A>(arr.get_data(), arr.get_total_size());
+        return static_cast<R>(moments.m2 / static_cast<A>(moments.count - ddof));
+    }
+
+    // Returns the variance along the given axes, dividing by (N - ddof)
+    template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+    NArray<floating_type_t<T>> var(
+        const NArray<T>& arr, const std::vector<int>& axes,
+        const size_t ddof = 0, const bool keepdims = false
+    ) {
+        using R = floating_type_t<T>;
+        using A = util::accumulator_t<R>;
+
+        const Shape& shape = arr.get_shape();
+        const auto mask = util::get_axes_mask(shape, axes);
+        const size_t count = util::get_reduction_size(shape, mask);
+
+        const Shape out_shape = util::get_reduced_shape(shape, mask, keepdims);
+        std::vector<A> mean(out_shape.get_total_size(), A(0));
+        std::vector<A> m2(out_shape.get_total_size(), A(0));
+        const T* in = arr.get_data();
+
+        util::for_each_reduce_run(shape, mask,
+            [&] (size_t in_off, size_t out_off, size_t red_off, size_t len, bool inner_reduced) {
+                if (inner_reduced) {
+                    util::Moments<A> total{red_off, mean[out_off], m2[out_off]};
+                    total.merge(util::contiguous_moments<A>(in + in_off, len));
+                    mean[out_off] = total.mean;
+                    m2[out_off] = total.m2;
+                } else {
+                    util::welford_row(in + in_off, len, red_off + 1, mean.data() + out_off, m2.data() + out_off);
+                }
+            }
+        );
+
+        const A denominator = (count > ddof)
+            ? static_cast<A>(count - ddof)
+            : std::numeric_limits<A>::quiet_NaN();
+
+        NArray<R> out(out_shape);
+        for (size_t i = 0; i < m2.size(); i++)
+            out.get_data()[i] = static_cast<R>(m2[i] / denominator);
+        return out;
+    }
+
+    // Returns the variance along an axis, dividing by (N - ddof)
+    template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+    NArray<floating_type_t<T>> var(
+        const NArray<T>& arr, const int axis,
+        const size_t ddof = 0, const bool keepdims = false
+    ) {
+        return var(arr, std::vector<int>{axis}, ddof, keepdims);
+    }
+
+
+    // Returns the standard deviation of the flattened array, dividing the variance by (N - ddof)
+    template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+    floating_type_t<T> std(const NArray<T>& arr, AllAxes = all_axes, const size_t ddof = 0) {
+        return std::sqrt(var(arr, all_axes, ddof));
+    }
+
+    // Returns the standard deviation along the given axes, dividing the variance by (N - ddof)
+    template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+    NArray<floating_type_t<T>> std(
+        const NArray<T>& arr, const std::vector<int>& axes,
+        const size_t ddof = 0, const bool keepdims = false
+    ) {
+        auto out = var(arr, axes, ddof, keepdims);
+        for (auto& elem : out) elem = std::sqrt(elem);
+        return out;
+    }
+
+    // Returns the standard deviation along an axis, dividing the variance by (N - ddof)
+    template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+    NArray<floating_type_t<T>> std(
+        const NArray<T>& arr, const int axis,
+        const size_t ddof = 0, const bool keepdims = false
+    ) {
+        return std(arr, std::vector<int>{axis}, ddof, keepdims);
+    }
+
+
+    /* Returns the quantiles `qs` (each in [0, 1]) of the flattened array, interpolating linearly between the
+     * two closest ranks. The ranks are found by selection (introselect), not by sorting. */
+    template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+    NArray<floating_type_t<T>> quantile(const NArray<T>& arr, const std::vector<double>& qs) {
+        util::check_quantiles(qs);
+        std::vector<T> data(arr.get_data(), arr.get_data() + arr.get_total_size());
+        NArray<floating_type_t<T>> out(Shape{qs.size()});
+        util::quantiles_contiguous(data.data(), data.size(), qs, out.get_data(), 1);
+        return out;
+    }
+
+    // Returns the quantile `q` (in [0, 1]) of the flattened array
+    template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+    floating_type_t<T> quantile(const NArray<T>& arr, const double q) {
+        return quantile(arr, std::vector<double>{q})(0);
+    }
+
+    // Returns the quantiles `qs` along an axis, stacked along a new first axis
+    template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+    NArray<floating_type_t<T>> quantile(
+        const NArray<T>& arr, const std::vector<double>& qs, const int axis, const bool keepdims = false
+    ) {
+        util::check_quantiles(qs);
+        const Shape& shape = arr.get_shape();
+        const size_t ax = util::normalize_axis(axis, shape.get_Ndim());
+        const auto [outer, inner] = util::get_outer_inner(shape, ax);
+
+        std::vector<size_t> dims{qs.size()};
+        if (shape.get_Ndim() > 1 || keepdims) {
+            const Shape reduced = util::get_reduced_shape(shape, util::get_axes_mask(shape, {axis}), keepdims);
+            dims.insert(dims.end(), reduced.dimensions.begin(), reduced.dimensions.end());
+        }
+
+        NArray<floating_type_t<T>> out{Shape(std::move(dims))};
+        util::quantile_axis(arr.get_data(), out.get_data(), outer, shape[ax], inner, qs);
+        return out;
+    }
+
+    // Returns the quantile `q` (in [0, 1]) along an axis
+    template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+    NArray<floating_type_t<T>> quantile(const NArray<T>& arr, const double q, const int axis, const bool keepdims = false) {
+        const Shape& shape = arr.get_shape();
+        const size_t ax = util::normalize_axis(axis, shape.get_Ndim());
+        const auto [outer, inner] = util::get_outer_inner(shape, ax);
+        util::check_quantiles({q});
+
+        NArray<floating_type_t<T>> out(util::get_reduced_shape(shape, util::get_axes_mask(shape, {axis}), keepdims));
+        util::quantile_axis(arr.get_data(), out.get_data(), outer, shape[ax], inner, {q});
+        return out;
+    }
+
+
+    // Returns the percentiles `ps` (each in [0, 100]) of the flattened array
+    template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+    NArray<floating_type_t<T>> percentile(const NArray<T>& arr, const std::vector<double>& ps) {
+        return quantile(arr, util::percentiles_to_quantiles(ps));
+    }
+
+    // Returns the percentile `p` (in [0, 100]) of the flattened array
+    template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+    floating_type_t<T> percentile(const NArray<T>& arr, const double p) {
+        return quantile(arr, util::percentiles_to_quantiles({p})[0]);
+    }
+
+    // Returns the percentiles `ps` along an axis, stacked along a new first axis
+    template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+    NArray<floating_type_t<T>> percentile(
+        const NArray<T>& arr, const std::vector<double>& ps, const int axis, const bool keepdims = false
+    ) {
+        return quantile(arr, util::percentiles_to_quantiles(ps), axis, keepdims);
+    }
+
+    // Returns the percentile `p` (in [0, 100]) along an axis
+    template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+    NArray<floating_type_t<T>> percentile(const NArray<T>& arr, const double p, const int axis, const bool keepdims = false) {
+        return quantile(arr, util::percentiles_to_quantiles({p})[0], axis, keepdims);
+    }
+
+
+    // Returns the median of the flattened array
+    template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+    floating_type_t<T> median(const NArray<T>& arr) {
+        return quantile(arr, 0.5);
+    }
+
+    // Returns the median along an axis
+    template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+    NArray<floating_type_t<T>> median(const NArray<T>& arr, const int axis, const bool keepdims = false) {
+        return quantile(arr, 0.5, axis, keepdims);
+    }
+
+
+
+    /* Returns the histogram of the flattened array over `bins` equal bins spanning [range.first, range.second],
+     * together with the bin edges. Every bin is half-open except the last, which includes its right edge;
+     * values outside the range and NaNs are not counted. The bin of each value is computed, not searched. */
+    template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+    std::pair<NArray<size_t>, NArray<double>> histogram(
+        const NArray<T>& arr, const size_t bins, std::pair<double, double> range
+    ) {
+        if (bins == 0) throw error::ValueError("The number of bins must be positive.");
+        if (!(range.first <= range.second) || std::isinf(range.first) || std::isinf(range.second))
+            throw error::ValueError("The histogram range must be finite and increasing.");
+        if (range.first == range.second) {
+            range.first -= 0.5;
+            range.second += 0.5;
+        }
+
+        const auto edges = util::get_uniform_edges(range.first, range.second, bins);
+        const double scale = static_cast<double>(bins) / (range.second - range.first);
+        const T* data = arr.get_data();
+
+        auto counts = util::parallel_histogram<size_t>(arr.get_total_size(), bins,
+            [&] (const size_t i) { return util::get_uniform_bin(static_cast<double>(data[i]), edges.data(), bins, scale); },
+            [] (size_t) { return size_t(1); }
+        );
+        return {NArray<size_t>(std::move(counts)), NArray<double>(edges)};
+    }
+
+    // Returns the histogram of the flattened array over `bins` equal bins spanning its (non-NaN) values
+    template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+    std::pair<NArray<size_t>, NArray<double>> histogram(const NArray<T>& arr, const size_t bins = 10) {
+        std::pair<double, double> range{0.0, 1.0};
+        if (arr.get_total_size() != 0) {
+            range.first = static_cast<double>(util::extremum<false, true>(arr.get_data(), arr.get_total_size()));
+            range.second = static_cast<double>(util::extremum<true, true>(arr.get_data(), arr.get_total_size()));
+            if (std::isnan(range.first))
+                throw error::ValueError("Cannot infer the histogram range of an array of NaNs.");
+        }
+        return histogram(arr, bins, range);
+    }
+
+    /* Returns the histogram of the flattened array over the bins between consecutive `edges`, together with
+     * the edges. Every bin is half-open except the last, which includes its right edge. */
+    template <typename T, typename E,
+        typename = std::enable_if_t<std::is_arithmetic_v<T> && std::is_arithmetic_v<E>>>
+    std::pair<NArray<size_t>, NArray<double>> histogram(const NArray<T>& arr, const NArray<E>& edges) {
+        util::check_bin_edges(edges.get_data(), edges.get_total_size());
+        const size_t bins = edges.get_total_size() - 1;
+        const E* e = edges.get_data();
+        const T* data = arr.get_data();
+
+        auto counts = util::parallel_histogram<size_t>(arr.get_total_size(), bins,
+            [&] (const size_t i) { return util::get_edges_bin(data[i], e, bins); },
+            [] (size_t) { return size_t(1); }
+        );
+        return {NArray<size_t>(std::move(counts)), NArray<double>(std::vector<double>(e, e + bins + 1))};
+    }
+
+
+    // Returns the number of occurrences of every value in a non-negative integer array, with at least `minlength` bins
+    template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
+    NArray<size_t> bincount(const NArray<T>& arr, const size_t minlength = 0) {
+        const T* data = arr.get_data();
+        const size_t n = arr.get_total_size();
+        if constexpr (std::is_signed_v<T>) {
+            if (n != 0 && util::extremum<false, false>(data, n) < 0)
+                throw error::ValueError("bincount requires a non-negative array.");
+        }
+
+        const size_t bins = std::max(minlength, n ? static_cast<size_t>(util::extremum<true, false>(data, n)) + 1 : 0);
+        return NArray<size_t>(util::parallel_histogram<size_t>(n, bins,
+            [data] (const size_t i) { return static_cast<size_t>(data[i]); },
+            [] (size_t) { return size_t(1); }
+        ));
+    }
+
+    // Returns the sum of the weights of every value in a non-negative integer array
+    template <typename T, typename W,
+        typename = std::enable_if_t<std::is_integral_v<T> && std::is_arithmetic_v<W>>>
+    NArray<double> bincount(const NArray<T>& arr, const NArray<W>& weights, const size_t minlength = 0) {
+        if (weights.get_shape() != arr.get_shape()) {
+            throw error::ShapeError("Weights of shape " + util::toString(weights.get_shape())
+                + " do not match an array of shape " + util::toString(arr.get_shape()) + ".");
+        }
+        const T* data = arr.get_data();
+        const W* w = weights.get_data();
+        const size_t n = arr.get_total_size();
+        if constexpr (std::is_signed_v<T>) {
+            if (n != 0 && util::extremum<false, false>(data, n) < 0)
+                throw error::ValueError("bincount requires a non-negative array.");
+        }
+
+        const size_t bins = std::max(minlength, n ? static_cast<size_t>(util::extremum<true, false>(data, n)) + 1 : 0);
+        return NArray<double>(util::parallel_histogram<double>(n, bins,
+            [data] (const size_t i) { return static_cast<size_t>(data[i]); },
+            [w] (const size_t i) { return static_cast<double>(w[i]); }
+        ));
+    }
+
+
+    /* Returns the index of the bin every element falls in, for monotonic `bins`. When they increase this is
+     * i such that bins[i-1] <= x < bins[i], or bins[i-1] < x <= bins[i] if `right` is set; values below the first
+     * edge get 0 and values above the last get bins.size(), and so do NaNs. When they decrease it is i such that
+     * bins[i-1] > x >= bins[i], or bins[i-1] >= x > bins[i] if `right` is set, and NaNs get 0. */
+    template <typename T, typename E,
+        typename = std::enable_if_t<std::is_arithmetic_v<T> && std::is_arithmetic_v<E>>>
+    NArray<size_t> digitize(const NArray<T>& arr, const NArray<E>& bins, const bool right = false) {
+        const size_t n_edges = bins.get_total_size();
+        const bool increasing = util::check_monotonic_edges(bins.get_data(), n_edges);
+
+        // Decreasing bins are searched in reverse, and the index counted back from the end
+        std::vector<E> reversed;
+        if (!increasing) reversed.assign(std::make_reverse_iterator(bins.get_data() + n_edges),
+                                         std::make_reverse_iterator(bins.get_data()));
+        const E* e = increasing ? bins.get_data() : reversed.data();
+
+        NArray<size_t> out(arr.get_shape());
+        const T* data = arr.get_data();
+        size_t* res = out.get_data();
+
+        util::parallel_for(arr.get_total_size(), 1 << 14, [&] (const size_t begin, const size_t end, size_t) {
+            for (size_t i = begin; i < end; i++) {
+                size_t b;
+                if (util::is_nan(data[i])) b = n_edges;
+                else if (right) b = util::branchless_search<false>(e, n_edges, data[i]);
+                else b = util::branchless_search<true>(e, n_edges, data[i]);
+                res[i] = increasing ? b : n_edges - b;
+            }
+        });
+        return out;
+    }
+
+    /* Returns the index of the bucket every element falls in, for monotonically increasing `boundaries`:
+     * i such that boundaries[i-1] < x <= boundaries[i], or boundaries[i-1] <= x < boundaries[i] if `right` is set. */
+    template <typename T, typename E,
+        typename = std::enable_if_t<std::is_arithmetic_v<T> && std::is_arithmetic_v<E>>>
+    NArray<size_t> bucketize(const NArray<T>& arr, const NArray<E>& boundaries, const bool right = false) {
+        return digitize(arr, boundaries, !right);
+    }
+
+} // namespace numxx
@@ -0,0 +1,268 @@
+/* Blas.hpp */
+#pragma once
+
+#include <algorithm>
+#include <climits>
+#include <type_traits>
+#include <vector>
+
+#include "../Complex.hpp"
+
+
+/* Optional system BLAS/LAPACK backend.
+ * With NUMXX_USE_BLAS defined (the CMake option of the same name defines it when find_package finds a BLAS, such
+ * as OpenBLAS or BLIS), the kernels below forward float, double and complex matrices to the Fortran BLAS, and
+ * with NUMXX_USE_LAPACK also defined (when a LAPACK is found too) the factorisations go to LAPACK.
+ * Every kernel returns whether it handled the call. It declines when the backend is absent, for other element
+ * types, or for sizes beyond the 32-bit integers of the Fortran interface, and the caller then runs its own
+ * kernel, so the library behaves the same with or without a backend.
+ * The matrices are row-major, which the column-major routines see as transposed: C = A * B is computed as
+ * C^T = B^T * A^T, and the triangular solves and factorisations are set up accordingly. */
+
+#ifdef NUMXX_USE_BLAS
+extern "C" {
+    // Complex arguments are passed as void*, since numxx::complex has the layout of a Fortran complex
+    void sgemm_(const char*, const char*, const int*, const int*, const int*, const float*, const float*, const int*,
+                const float*, const int*, const float*, float*, const int*);
+    void dgemm_(const char*, const char*, const int*, const int*, const int*, const double*, const double*, const int*,
+                const double*, const int*, const double*, double*, const int*);
+    void cgemm_(const char*, const char*, const int*, const int*, const int*, const void*, const void*, const int*,
+                const void*, const int*, const void*, void*, const int*);
+    void zgemm_(const char*, const char*, const int*, const int*, const int*, const void*, const void*, const int*,
+                const void*, const int*, const void*, void*, const int*);
+
+    void sgemv_(const char*, const int*, const int*, const float*, const float*, const int*, const float*, const int*,
+                const float*, float*, const int*);
+    void dgemv_(const char*, const int*, const int*, const double*, const double*, const int*, const double*,
+                const int*, const double*, double*, const int*);
+    void cgemv_(const char*, const int*, const int*, const void*, const void*, const int*, const void*, const int*,
+                const void*, void*, const int*);
+    void zgemv_(const char*, const int*, const int*, const void*, const void*, const int*, const void*, const int*,
+                const void*, void*, const int*);
+
+    void strsm_(const char*, const char*, const char*, const char*, const int*, const int*, const float*,
+                const float*, const int*, float*, const int*);
+    void dtrsm_(const char*, const char*, const char*, const char*, const int*, const int*, const double*,
+                const double*, const int*, double*, const int*);
+    void ctrsm_(const char*, const char*, const char*, const char*, const int*, const int*, const void*,
+                const void*, const int*, void*, const int*);
+    void ztrsm_(const char*, const char*, const char*, const char*, const int*, const int*, const void*,
+                const void*, const int*, void*, const int*);
+
+#ifdef NUMXX_USE_LAPACK
+    void sgetrf_(const int*, const int*, float*, const int*, int*, int*);
+    void dgetrf_(const int*, const int*, double*, const int*, int*, int*);
+    void cgetrf_(const int*, const int*, void*, const int*, int*, int*);
+    void zgetrf_(const int*, const int*, void*, const int*, int*, int*);
+
+    void spotrf_(const char*, const int*, float*, const int*, int*);
+    void dpotrf_(const char*, const int*, double*, const int*, int*);
+    void cpotrf_(const char*, const int*, void*, const int*, int*);
+    void zpotrf_(const char*, const int*, void*, const int*, int*);
+#endif
+}
+#endif
+
+
+namespace numxx::util::blas {
+
+// The routines for each element type the backend takes
+template <typename T>
+struct Routines {
+    static constexpr bool available = false;
+};
+
+#ifdef NUMXX_USE_BLAS
+template <>
+struct Routines<float> {
+    static constexpr bool available = true;
+    static constexpr auto gemm = sgemm_;
+    static constexpr auto gemv = sgemv_;
+    static constexpr auto trsm = strsm_;
+#ifdef NUMXX_USE_LAPACK
+    static constexpr auto getrf = sgetrf_;
+    static constexpr auto potrf = spotrf_;
+#endif
+};
+
+template <>
+struct Routines<double> {
+    static constexpr bool available = true;
+    static constexpr auto gemm = dgemm_;
+    static constexpr auto gemv = dgemv_;
+    static constexpr auto trsm = dtrsm_;
+#ifdef NUMXX_USE_LAPACK
+    static constexpr auto getrf = dgetrf_;
+    static constexpr auto potrf = dpotrf_;
+#endif
+};
+
+template <>
+struct Routines<complex<float>> {
+    static constexpr bool available = true;
+    static constexpr auto gemm = cgemm_;
+    static constexpr auto gemv = cgemv_;
+    static constexpr auto trsm = ctrsm_;
+#ifdef NUMXX_USE_LAPACK
+    static constexpr auto getrf = cgetrf_;
+    static constexpr auto potrf = cpotrf_;
+#endif
+};
+
+template <>
+struct Routines<complex<double>> {
+    static constexpr bool available = true;
+    static constexpr auto gemm = zgemm_;
+    static constexpr auto gemv = zgemv_;
+    static constexpr auto trsm = ztrsm_;
+#ifdef NUMXX_USE_LAPACK
+    static constexpr auto getrf = zgetrf_;
+    static constexpr auto potrf = zpotrf_;
+#endif
+};
+
+static_assert(sizeof(complex<double>) == 2 * sizeof(double), "numxx::complex must match the Fortran complex layout");
+#endif
+
+
+// Whether the BLAS routines take elements of type T
+template <typename T>
+inline constexpr bool has_blas = Routines<T>::available;
+
+// Whether the LAPACK routines take elements of type T
+#ifdef NUMXX_USE_LAPACK
+template <typename T>
+inline constexpr bool has_lapack = Routines<T>::available;
+#else
+template <typename T>
+inline constexpr bool has_lapack = false;
+#endif
+
+
+// Whether all the sizes fit the 32-bit integers of the Fortran interface
+template <typename... Sizes>
+bool fits_int(const Sizes... sizes) {
+    return ((sizes <= static_cast<size_t>(INT_MAX)) && ...);
+}
+
+
+// y = alpha * A * x + beta * y for the row-major m x n matrix A (leading dimension lda), with strided x and y
+template <typename T>
+bool gemv(
+    const size_t m, const size_t n, const T alpha, const T* a, const size_t lda,
+    const T* x, const size_t incx, const T beta, T* y, const size_t incy
+) {
+    if constexpr (has_blas<T>) {
+        if (m == 0 || n == 0 || !fits_int(m, n, lda, incx, incy)) return false;
+        const int mi = static_cast<int>(m), ni = static_cast<int>(n), ldai = static_cast<int>(lda);
+        const int incxi = static_cast<int>(incx), incyi = static_cast<int>(incy);
+        // The column-major view of A is the n x m matrix A^T
+        Routines<T>::gemv("T", &ni, &mi, &alpha, a, &ldai, x, &incxi, &beta, y, &incyi);
+        return true;
+    } else {
+        (void)m; (void)n; (void)alpha; (void)a; (void)lda; (void)x; (void)incx; (void)beta; (void)y; (void)incy;
+        return false;
+    }
+}
+
+
+// C = alpha * A * B + beta * C for row-major matrices, as util::gemm. Products with one row or column go to gemv
+template <typename T>
+bool gemm(
+    const size_t m, const size_t n, const size_t k, const T alpha,
+    const T* a, const size_t lda, const T* b, const size_t ldb,
+    const T beta, T* c, const size_t ldc
+) {
+    if constexpr (has_blas<T>) {
+        if (m == 0 || n == 0 || k == 0 || !fits_int(m, n, k, lda, ldb, ldc)) return false;
+        if (n == 1) return gemv(m, k, alpha, a, lda, b, ldb, beta, c, ldc);
+
+        const int mi = static_cast<int>(m), ni = static_cast<int>(n), ki = static_cast<int>(k);
+        const int ldai = static_cast<int>(lda), ldbi = static_cast<int>(ldb), ldci = static_cast<int>(ldc);
+        if (m == 1) {
+            // c^T = B^T * a^T, where B^T is the column-major view of B
+            const int one = 1;
+            Routines<T>::gemv("N", &ni, &ki, &alpha, b, &ldbi, a, &one, &beta, c, &one);
+            return true;
+        }
+        Routines<T>::gemm("N", "N", &ni, &mi, &ki, &alpha, b, &ldbi, a, &ldai, &beta, c, &ldci);
+        return true;
+    } else {
+        (void)m; (void)n; (void)k; (void)alpha; (void)a; (void)lda; (void)b; (void)ldb; (void)beta; (void)c; (void)ldc;
+        return false;
+    }
+}
+
+
+/* Solves T * X = B in place for the n x nrhs row-major matrix `b`, where T is the lower (or upper) triangle of
+ * the row-major matrix `t` (leading dimension lda), with a unit diagonal if `unit_diagonal` is set.
+ * In the column-major view this is X^T * T^T = B^T, a solve from the right with the opposite triangle. */
+template <typename T>
+bool trsm(
+    const T* t, const size_t lda, const size_t n, T* b, const size_t nrhs, const bool lower, const bool unit_diagonal
+) {
+    if constexpr (has_blas<T>) {
+        if (n == 0 || nrhs == 0 || !fits_int(n, nrhs, lda)) return false;
+        const int ni = static_cast<int>(n), nrhsi = static_cast<int>(nrhs), ldai = static_cast<int>(lda);
+        const T one(1);
+        Routines<T>::trsm("R", lower ? "U" : "L", "N", unit_diagonal ? "U" : "N", &nrhsi, &ni, &one, t, &ldai, b, &nrhsi);
+        return true;
+    } else {
+        (void)t; (void)lda; (void)n; (void)b; (void)nrhs; (void)lower; (void)unit_diagonal;
+        return false;
+    }
+}
+
+
+/* Factors the n x n row-major matrix `a` in place as P * A = L * U, with the storage and pivots of
+ * util::lu_factor. LAPACK's getrf works on columns, so the matrix is transposed into a column-major buffer
+ * and back, which costs O(n^2) against the O(n^3) factorisation. */
+template <typename T>
+bool getrf(T* a, const size_t n, size_t* piv) {
+    if constexpr (has_lapack<T>) {
+        if (n == 0 || !fits_int(n)) return false;
+        std::vector<T> col_major(n * n);
+        for (size_t i = 0; i < n; i++)
+            for (size_t j = 0; j < n; j++) col_major[j * n + i] = a[i * n + j];
+
+        const int ni = static_cast<int>(n);
+        std::vector<int> ipiv(n);
+        int info = 0;
+        Routines<T>::getrf(&ni, &ni, col_major.data(), &ni, ipiv.data(), &info);
+        if (info < 0) return false;
+
+        // A positive info flags an exactly zero pivot, which the caller detects on the diagonal of U
+        for (size_t i = 0; i < n; i++)
+            for (size_t j = 0; j < n; j++) a[i * n + j] = col_major[j * n + i];
+        for (size_t i = 0; i < n; i++) piv[i] = static_cast<size_t>(ipiv[i] - 1);
+        return true;
+    } else {
+        (void)a; (void)n; (void)piv;
+        return false;
+    }
+}
+
+
+/* Factors the Hermitian matrix whose lower triangle is in the n x n row-major matrix `a` in place as
+ * A = L * L^H, with the storage of util::cholesky_factor, setting `positive_definite`. The row-major lower
+ * triangle is the column-major upper triangle of conj(A) = U^H * U with U = L^T, so potrf('U') gives L in place. */
+template <typename T>
+bool potrf(T* a, const size_t n, bool& positive_definite) {
+    if constexpr (has_lapack<T>) {
+        if (n == 0 || !fits_int(n)) return false;
+        const int ni = static_cast<int>(n);
+        int info = 0;
+        Routines<T>::potrf("U", &ni, a, &ni, &info);
+        if (info < 0) return false;
+
+        positive_definite = (info == 0);
+        for (size_t i = 0; i < n; i++)
+            for (size_t j = i + 1; j < n; j++) a[i * n + j] = T(0);
+        return true;
+    } else {
+        (void)a; (void)n; (void)positive_definite;
+        return false;
+    }
+}
+
+} // namespace numxx::util::blas
@@ -0,0 +1,166 @@
+/* DiffUtils.hpp */
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Errors.hpp"
+#include "Parallel.hpp"
+#include "StringOps.hpp"
+#include "../Complex.hpp"
+
+
+namespace numxx::util {
+
+// Writes the binomial coefficients C(n, k), k = 0..n, into `binom`. Returns false, leaving `binom`
+// incomplete, as soon as one of them would exceed `limit`
+inline bool get_binomials(const size_t n, const long long limit, std::vector<long long>& binom) {
+    binom.assign(n + 1, 0);
+    binom[0] = 1;
+    for (size_t k = 0; k < n; k++) {
+        // C(n, k + 1) = C(n, k) * (n - k) / (k + 1), reduced first so that only the result can overflow
+        const long long num = static_cast<long long>(n - k), den = static_cast<long long>(k + 1);
+        const long long g = std::gcd(binom[k], den);
+        const long long factor = num / (den / g);
+        if (binom[k] / g > limit / factor) return false;
+        binom[k + 1] = (binom[k] / g) * factor;
+    }
+    return true;
+}
+
+
+/* Returns the coefficients (-1)^k * C(n, k) of the n-th forward difference, k = 0..n.
+ * Integral types get them exactly, and a ValueError if some C(n, k) does not fit in a long long.
+ * Floating and complex types get them converted exactly to floating_type_t<T>, or an empty vector if some
+ * C(n, k) is beyond the integers that type represents exactly (n > 57 for double, n > 26 for float), where
+ * the alternating sum would cancel catastrophically. */
+template <typename T>
+std::vector<T> get_diff_coefficients(const size_t n) {
+    long long limit = std::numeric_limits<long long>::max();
+    if constexpr (!std::is_integral_v<T>) {
+        using R = floating_type_t<underlying_type_t<T>>;
+        if constexpr (std::numeric_limits<R>::digits < 63) limit = 1LL << std::numeric_limits<R>::digits;
+    }
+
+    std::vector<long long> binom;
+    if (!get_binomials(n, limit, binom)) {
+        if constexpr (std::is_integral_v<T>)
+            throw error::ValueError("The coefficients of a difference of order " + toString(n) + " overflow a long long.");
+        else
+            return {};
+    }
+
+    std::vector<T> coeffs(n + 1);
+    for (size_t k = 0; k <= n; k++) {
+        const long long signed_binom = (k % 2) ? -binom[k] : binom[k];
+        if constexpr (is_complex_v<T>) coeffs[k] = T(static_cast<underlying_type_t<T>>(signed_binom));
+        else coeffs[k] = static_cast<T>(signed_binom);
+    }
+    return coeffs;
+}
+
+
+/* Computes one difference of the given coefficients along an axis of an array viewed as (outer, axis_len,
+ * inner), where n = coeffs.size() - 1. For a fixed outer index the output rows are contiguous, so output row
+ * i is the sum over k of coeffs[k] * (input row i + n - k), computed for the whole slab at once. */
+template <typename T>
+void diff_axis_fused(
+    const T* in, T* out, const size_t outer, const size_t axis_len, const size_t inner, const std::vector<T>& coeffs
+) {
+    const size_t n = coeffs.size() - 1;
+    const size_t out_slab = (axis_len - n) * inner;
+    const size_t in_slab = axis_len * inner;
+    if (outer * out_slab == 0) return;
+
+    parallel_for(outer * out_slab, 1 << 14, [&] (const size_t begin, const size_t end, size_t) {
+        for (size_t o = begin / out_slab; o * out_slab < end; o++) {
+            const size_t j0 = std::max(begin, o * out_slab) - o * out_slab;
+            const size_t j1 = std::min(end, (o + 1) * out_slab) - o * out_slab;
+            const T* src = in + o * in_slab;
+            T* dst = out + o * out_slab;
+
+            const T* last = src + n * inner;
+            for (size_t j = j0; j < j1; j++) dst[j] = last[j];
+            for (size_t k = 1; k <= n; k++) {
+                const T c = coeffs[k];
+                const T* row = src + (n - k) * inner;
+                for (size_t j = j0; j < j1; j++) dst[j] += c * row[j];
+            }
+        }
+    });
+}
+
+
+/* Computes the n-th difference along one axis of an array viewed as (outer, axis_len, inner), in one pass
+ * with the binomial coefficients. When those are not exact in a floating type, the n first differences are
+ * taken one after another instead, through two scratch buffers. */
+template <typename T>
+void diff_axis(
+    const T* in, T* out, const size_t outer, const size_t axis_len, const size_t inner, const size_t n
+) {
+    const std::vector<T> coeffs = get_diff_coefficients<T>(n);
+    if (!coeffs.empty()) {
+        diff_axis_fused(in, out, outer, axis_len, inner, coeffs);
+        return;
+    }
+
+    const std::vector<T> first_difference{T(1), T(0) - T(1)};
+    std::vector<T> current(outer * (axis_len - 1) * inner), next(current.size());
+    const T* src = in;
+    for (size_t step = 1; step <= n; step++) {
+        T* dst = (step == n) ? out : next.data();
+        diff_axis_fused(src, dst, outer, axis_len - step + 1, inner, first_difference);
+        std::swap(current, next);
+        src = current.data();
+    }
+}
+
+
+/* Computes the gradient along one axis of an array viewed as (outer, axis_len, inner), with sample
+ * spacing `h`. Interior points use second-order central differences; the two edges use first or
+ * second-order one-sided differences depending on `edge_order`. Requires axis_len > edge_order. */
+template <typename R, typename T>
+void gradient_axis(
+    const T* in, R* out, const size_t outer, const size_t axis_len, const size_t inner,
+    const R h, const int edge_order
+) {
+    const size_t slab = axis_len * inner;
+    if (outer * slab == 0) return;
+    const R half_inv_h = R(0.5) / h;
+    const R inv_h = R(1) / h;
+
+    parallel_for(outer, std::max<size_t>(1, (1 << 14) / slab), [&] (const size_t begin, const size_t end, size_t) {
+        for (size_t o = begin; o < end; o++) {
+            const T* src = in + o * slab;
+            R* dst = out + o * slab;
+
+            // Interior: every row from 1 to axis_len - 2 in one contiguous sweep
+            for (size_t j = inner; j + inner < slab; j++)
+                dst[j] = (static_cast<R>(src[j + inner]) - static_cast<R>(src[j - inner])) * half_inv_h;
+
+            const T* first = src;
+            const T* last = src + (axis_len - 1) * inner;
+            const T* prev = last - inner;
+            R* dst_last = dst + (axis_len - 1) * inner;
+            if (edge_order == 1) {
+                for (size_t j = 0; j < inner; j++) {
+                    dst[j] = (static_cast<R>(first[j + inner]) - static_cast<R>(first[j])) * inv_h;
+                    dst_last[j] = (static_cast<R>(last[j]) - static_cast<R>(prev[j])) * inv_h;
+                }
+            } else {
+                for (size_t j = 0; j < inner; j++) {
+                    dst[j] = (R(-3) * static_cast<R>(first[j]) + R(4) * static_cast<R>(first[j + inner])
+                        - static_cast<R>(first[j + 2 * inner])) * half_inv_h;
+                    dst_last[j] = (R(3) * static_cast<R>(last[j]) - R(4) * static_cast<R>(prev[j])
+                        + static_cast<R>((prev - inner)[j])) * half_inv_h;
+                }
+            }
+        }
+    });
+}
+
+} // namespace numxx::util
@@ -0,0 +1,510 @@
+/* EigenUtils.hpp */
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+#include "LinalgUtils.hpp"
+#include "Parallel.hpp"
+
+
+namespace numxx::util {
+
+    // Returns the real part of x, or x itself if it is real
+    template <typename T>
+    underlying_type_t<T> real_part(const T& x) {
+        if constexpr (is_complex_v<T>) return x.real();
+        else return x;
+    }
+
+
+    // Number of columns the blocked tridiagonalisation reduces before updating the rest of the matrix
+    constexpr size_t tridiag_block = 32;
+
+
+    /* Reduces the n x n row-major Hermitian matrix `a` (both triangles stored) to the real symmetric tridiagonal
+     * matrix T = Q^H * A * Q, writing its diagonal to d (n elements) and its off-diagonal to e (n - 1 elements).
+     * Q = H_0 * ... * H_{n-2}, where H_j acts on the rows from j + 1 on: its vector is left below the subdiagonal
+     * of column j and its scalar in tau[j], so Q is applied by apply_q on the matrix starting at the second row.
+     * The reduction is blocked (LAPACK's sytrd and latrd): the reflectors of a panel are built against the matrix
+     * as updated so far, expressed through the panel's V and W, and the rest of the matrix then takes the
+     * rank-2k update A -= V * W^H + W * V^H as two gemms. */
+    template <typename T>
+    void tridiagonalize(T* a, const size_t n, underlying_type_t<T>* d, underlying_type_t<T>* e, T* tau) {
+        if (n == 0) return;
+        constexpr size_t NB = tridiag_block;
+        std::vector<T> v(n * NB), w(n * NB), x(n), y(NB), z(NB), packed;
+
+        for (size_t j0 = 0; j0 + 1 < n; j0 += NB) {
+            const size_t nb = std::min(NB, n - 1 - j0);
+            std::fill(v.begin() + j0 * NB, v.end(), T(0));
+            std::fill(w.begin() + j0 * NB, w.end(), T(0));
+
+            for (size_t i = 0; i < nb; i++) {
+                const size_t j = j0 + i;
+
+                // Bring column j up to date with the reflectors of the panel so far
+                for (size_t r = j; r < n; r++) {
+                    const T* vr = v.data() + r * NB;
+                    const T* wr = w.data() + r * NB;
+                    T s(0);
+                    for (size_t c = 0; c < i; c++)
+                        s += vr[c] * numxx::conj(w[j * NB + c]) + wr[c] * numxx::conj(v[j * NB + c]);
+                    a[r * n + j] -= s;
+                }
+                d[j] = real_part(a[j * n + j]);
+
+                const T tau_j = make_householder(a[(j + 1) * n + j], a + (j + 2) * n + j, n - j - 1, n);
+                tau[j] = tau_j;
+                e[j] = real_part(a[(j + 1) * n + j]);
+
+                std::fill(x.begin(), x.end(), T(0));
+                x[j + 1] = T(1);
+                for (size_t r = j + 2; r < n; r++) x[r] = a[r * n + j];
+                for (size_t r = j + 1; r < n; r++) v[r * NB + i] = x[r];
+                if (tau_j == T(0)) continue;
+
+                // w = tau * (A - V * W^H - W * V^H) * v on the rows below j, with A as it was before the panel
+                for (size_t c = 0; c < i; c++) y[c] = z[c] = T(0);
+                for (size_t r = j + 1; r < n; r++) {
+                    for (size_t c = 0; c < i; c++) {
+                        y[c] += numxx::conj(w[r * NB + c]) * x[r];
+                        z[c] += numxx::conj(v[r * NB + c]) * x[r];
+                    }
+                }
+                parallel_for(n - j - 1, std::max<size_t>(1, (1 << 14) / n), [&] (const size_t begin, const size_t end, size_t) {
+                    for (size_t r = j + 1 + begin; r < j + 1 + end; r++) {
+                        const T* row = a + r * n;
+                        T s(0);
+                        for (size_t c = j + 1; c < n; c++) s += row[c] * x[c];
+                        for (size_t c = 0; c < i; c++) s -= v[r * NB + c] * y[c] + w[r * NB + c] * z[c];
+                        w[r * NB + i] = tau_j * s;
+                    }
+                });
+
+                T wv(0);
+                for (size_t r = j + 1; r < n; r++) wv += numxx::conj(w[r * NB + i]) * x[r];
+                const T alpha = T(underlying_type_t<T>(-0.5)) * tau_j * wv;
+                for (size_t r = j + 1; r < n; r++) w[r * NB + i] += alpha * x[r];
+            }
+
+            const size_t k1 = j0 + nb, rest = n - k1;
+            packed.resize(nb * rest);
+            for (size_t r = 0; r < rest; r++)
+                for (size_t c = 0; c < nb; c++) packed[c * rest + r] = numxx::conj(w[(k1 + r) * NB + c]);
+            gemm(rest, rest, nb, T(-1), v.data() + k1 * NB, NB, packed.data(), rest, T(1), a + k1 * n + k1, n);
+            for (size_t r = 0; r < rest; r++)
+                for (size_t c = 0; c < nb; c++) packed[c * rest + r] = numxx::conj(v[(k1 + r) * NB + c]);
+            gemm(rest, rest, nb, T(-1), w.data() + k1 * NB, NB, packed.data(), rest, T(1), a + k1 * n + k1, n);
+        }
+        d[n - 1] = real_part(a[(n - 1) * n + n - 1]);
+    }
+
+
+    /* Plane rotations recorded to be applied later to the rows of a matrix: rotation t replaces the rows
+     * x = first[t] and y = second[t] with c * x + s * y and c * y - s * x.
+     * Holding them back lets apply() take the matrix a block of columns at a time and run every recorded rotation
+     * over the block while it stays in cache, rather than streaming the whole matrix through memory each sweep. */
+    template <typename Real>
+    struct RotationBuffer {
+        std::vector<size_t> first, second;
+        std::vector<Real> c, s;
+
+        void push(const size_t x, const size_t y, const Real cx, const Real sx) {
+            first.push_back(x);
+            second.push_back(y);
+            c.push_back(cx);
+            s.push_back(sx);
+        }
+
+        size_t size() const { return c.size(); }
+
+        // Applies the rotations in order to the row-major matrix `mat` with `cols` columns, and forgets them
+        void apply(Real* mat, const size_t rows, const size_t cols) {
+            if (c.empty()) return;
+            const size_t width = std::clamp<size_t>((1 << 16) / std::max<size_t>(rows, 1), 8, 256);
+            const size_t blocks = (cols + width - 1) / width;
+            parallel_for(blocks, 1, [&] (const size_t begin, const size_t end, size_t) {
+                for (size_t k0 = begin * width; k0 < std::min(end * width, cols); k0 += width) {
+                    const size_t k1 = std::min(k0 + width, cols);
+                    for (size_t t = 0; t < c.size(); t++) {
+                        Real* x = mat + first[t] * cols;
+                        Real* y = mat + second[t] * cols;
+                        const Real ct = c[t], st = s[t];
+                        for (size_t k = k0; k < k1; k++) {
+                            const Real xk = x[k];
+                            x[k] = ct * xk + st * y[k];
+                            y[k] = ct * y[k] - st * xk;
+                        }
+                    }
+                }
+            });
+            first.clear();
+            second.clear();
+            c.clear();
+            s.clear();
+        }
+    };
+
+
+    // Rotations recorded per row of the matrix they act on before a RotationBuffer is applied
+    constexpr size_t rotation_batch = 16;
+
+
+    /* Finds the eigenvalues of the real symmetric tridiagonal matrix with diagonal d and off-diagonal e (e[i]
+     * couples i and i + 1; e[n - 1] is scratch) by the implicit QL method with Wilkinson shifts (EISPACK's tql2),
+     * leaving them unsorted in d. If `zt` is not null, the n x n matrix it points to (the identity, to get the
+     * eigenvectors of T itself) is multiplied by the rotations, and its row i ends up as the eigenvector of d[i].
+     * Returns false if an eigenvalue did not converge. */
+    template <typename Real>
+    bool tridiagonal_ql(Real* d, Real* e, const size_t n, Real* zt) {
+        if (n == 0) return true;
+        constexpr size_t max_iter = 30;
+        const Real eps = std::numeric_limits<Real>::epsilon();
+        RotationBuffer<Real> rotations;
+        e[n - 1] = Real(0);
+
+        Real shift_sum(0), tst(0);
+        for (size_t l = 0; l < n; l++) {
+            tst = std::max(tst, std::abs(d[l]) + std::abs(e[l]));
+            size_t m = l;
+            while (m + 1 < n && std::abs(e[m]) > eps * tst) m++;
+
+            size_t iter = 0;
+            while (m > l) {
+                if (iter++ == max_iter) return false;
+
+                // Shift by the eigenvalue of the leading 2x2 block closer to d[l]
+                Real g = d[l];
+                Real p = (d[l + 1] - g) / (Real(2) * e[l]);
+                Real r = std::hypot(p, Real(1));
+                if (p < Real(0)) r = Real(0) - r;
+                d[l] = e[l] / (p + r);
+                d[l + 1] = e[l] * (p + r);
+                const Real dl1 = d[l + 1];
+                Real h = g - d[l];
+                for (size_t i = l + 2; i < n; i++) d[i] -= h;
+                shift_sum += h;
+
+                // Chase the bulge up from m to l
+                p = d[m];
+                Real c = 1, c2 = 1, c3 = 1, s = 0, s2 = 0;
+                const Real el1 = e[l + 1];
+                for (size_t i = m; i-- > l;) {
+                    c3 = c2;
+                    c2 = c;
+                    s2 = s;
+                    g = c * e[i];
+                    h = c * p;
+                    r = std::hypot(p, e[i]);
+                    e[i + 1] = s * r;
+                    s = e[i] / r;
+                    c = p / r;
+                    p = c * d[i] - s * g;
+                    d[i + 1] = h + s * (c * g + s * d[i]);
+                    if (zt) rotations.push(i, i + 1, c, Real(0) - s);
+                }
+                p = (Real(0) - s) * s2 * c3 * el1 * e[l] / dl1;
+                e[l] = s * p;
+                d[l] = c * p;
+
+                if (zt && rotations.size() >= rotation_batch * n) rotations.apply(zt, n, n);
+                if (std::abs(e[l]) <= eps * tst) break;
+            }
+            d[l] += shift_sum;
+            e[l] = Real(0);
+        }
+        if (zt) rotations.apply(zt, n, n);
+        return true;
+    }
+
+
+    /* Computes the eigenvalues of the n x n Hermitian matrix whose lower triangle is in `a` (overwritten), in
+     * ascending order into w, and, if `v` is not null, its eigenvectors as the columns of the n x n matrix v.
+     * The eigenvectors of the tridiagonal matrix are carried back to those of A by applying Q through gemm.
+     * Returns false if the QL iteration did not converge. */
+    template <typename T>
+    bool hermitian_eigen(T* a, const size_t n, underlying_type_t<T>* w, T* v) {
+        using Real = underlying_type_t<T>;
+        for (size_t i = 0; i < n; i++) {
+            a[i * n + i] = T(real_part(a[i * n + i]));
+            for (size_t j = i + 1; j < n; j++) a[i * n + j] = numxx::conj(a[j * n + i]);
+        }
+
+        std::vector<Real> d(n), e(n), zt;
+        std::vector<T> tau(n);
+        tridiagonalize(a, n, d.data(), e.data(), tau.data());
+        if (v) {
+            zt.assign(n * n, Real(0));
+            for (size_t i = 0; i < n; i++) zt[i * n + i] = Real(1);
+        }
+        if (!tridiagonal_ql(d.data(), e.data(), n, v ? zt.data() : nullptr)) return false;
+
+        std::vector<size_t> order(n);
+        std::iota(order.begin(), order.end(), size_t(0));
+        std::stable_sort(order.begin(), order.end(), [&] (const size_t x, const size_t y) { return d[x] < d[y]; });
+        for (size_t j = 0; j < n; j++) w[j] = d[order[j]];
+
+        if (v) {
+            for (size_t j = 0; j < n; j++) {
+                const Real* row = zt.data() + order[j] * n;
+                for (size_t i = 0; i < n; i++) v[i * n + j] = T(row[i]);
+            }
+            if (n > 1) apply_q(a + n, n - 1, n, n - 1, tau.data(), v + n, n);
+        }
+        return true;
+    }
+
+
+
+
+    /* Reduces the n x n row-major matrix `a` to the real upper bidiagonal matrix B = Q^H * A * P, writing its
+     * diagonal to d (n elements) and its superdiagonal to e (n - 1 elements) (LAPACK's gebrd, unblocked).
+     * Q = H_0 * ... * H_{n-1} is stored like householder_qr's, with its scalars in tauq. P = G_0 * ... * G_{n-2},
+     * where G_j acts on the columns from j + 1 on, has its vector left right of the superdiagonal of row j and its
+     * scalar in taup[j]. Right reflectors are applied row by row, so both passes run along contiguous rows. */
+    template <typename T>
+    void bidiagonalize(T* a, const size_t n, underlying_type_t<T>* d, underlying_type_t<T>* e, T* tauq, T* taup) {
+        std::vector<T> work(n);
+        for (size_t j = 0; j < n; j++) {
+            T* v_tail = a + (j + 1) * n + j;
+            tauq[j] = make_householder(a[j * n + j], v_tail, n - j, n);
+            apply_householder(a, n, j, n - j, j + 1, n, v_tail, n, numxx::conj(tauq[j]), work.data());
+            d[j] = real_part(a[j * n + j]);
+            if (j + 1 == n) break;
+
+            // G_j^H maps the conjugate of the rest of row j onto its first element, so A * G_j zeroes the row
+            T* row_j = a + j * n;
+            for (size_t c = j + 1; c < n; c++) row_j[c] = numxx::conj(row_j[c]);
+            const T tau = make_householder(row_j[j + 1], row_j + j + 2, n - j - 1, 1);
+            taup[j] = tau;
+            e[j] = real_part(row_j[j + 1]);
+            if (tau == T(0)) continue;
+
+            parallel_for(n - j - 1, std::max<size_t>(1, (1 << 14) / n), [&] (const size_t begin, const size_t end, size_t) {
+                for (size_t r = j + 1 + begin; r < j + 1 + end; r++) {
+                    T* row = a + r * n;
+                    T s = row[j + 1];
+                    for (size_t c = j + 2; c < n; c++) s += row[c] * row_j[c];
+                    s *= tau;
+                    row[j + 1] -= s;
+                    for (size_t c = j + 2; c < n; c++) row[c] -= s * numxx::conj(row_j[c]);
+                }
+            });
+        }
+    }
+
+
+    /* Finds the singular values of the real upper bidiagonal matrix with diagonal d and superdiagonal e (e[n - 1]
+     * is scratch) by the implicit-shift QR method of Golub and Kahan (LINPACK's svdc), leaving them unsorted and
+     * non-negative in d. If `ut` and `vt` are not null, the n x n matrices they point to (the identity, to get the
+     * singular vectors of B itself) are multiplied by the left and right rotations, and row i of each ends up as
+     * the left and right singular vector of d[i]. Returns false if the iteration did not converge. */
+    template <typename Real>
+    bool bidiagonal_qr(Real* d, Real* e, const size_t n, Real* ut, Real* vt) {
+        if (n == 0) return true;
+        const size_t max_iter = 75 * n;
+        const Real eps = std::numeric_limits<Real>::epsilon();
+        const Real tiny = std::numeric_limits<Real>::min() / eps;
+        RotationBuffer<Real> u_rot, v_rot;
+        e[n - 1] = Real(0);
+
+        auto flush = [&] (const bool force) {
+            if (!ut) return;
+            if (force || u_rot.size() >= rotation_batch * n) u_rot.apply(ut, n, n);
+            if (force || v_rot.size() >= rotation_batch * n) v_rot.apply(vt, n, n);
+        };
+
+        size_t p = n, iter = 0;
+        while (p > 0) {
+            if (iter++ == max_iter) return false;
+
+            // k is the last negligible superdiagonal element before p - 1, if any (k + 1 == 0 otherwise)
+            size_t k = p - 1;
+            while (k-- > 0) {
+                if (std::abs(e[k]) <= tiny + eps * (std::abs(d[k]) + std::abs(d[k + 1]))) {
+                    e[k] = Real(0);
+                    break;
+                }
+            }
+
+            // The block (k, p) is split off below; look for a negligible diagonal element within it
+            enum { DeflateLast, Split, QRStep, Converged } kase;
+            if (k + 2 == p) {
+                kase = Converged;
+            } else {
+                size_t ks = p;
+                while (--ks != k) {
+                    const Real t = ((ks != p - 1) ? std::abs(e[ks]) : Real(0)) + ((ks != k + 1) ? std::abs(e[ks - 1]) : Real(0));
+                    if (std::abs(d[ks]) <= tiny + eps * t) {
+                        d[ks] = Real(0);
+                        break;
+                    }
+                }
+                if (ks == k) {
+                    kase = QRStep;
+                } else if (ks == p - 1) {
+                    kase = DeflateLast;
+                } else {
+                    kase = Split;
+                    k = ks;
+                }
+            }
+            k++;
+
+            switch (kase) {
+                case DeflateLast: {
+                    // d[p - 1] is zero: chase e[p - 2] up and out by rotations from the right
+                    Real f = e[p - 2];
+                    e[p - 2] = Real(0);
+                    for (size_t j = p - 1; j-- > k;) {
+                        const Real t = std::hypot(d[j], f);
+                        const Real cs = d[j] / t, sn = f / t;
+                        d[j] = t;
+                        if (j != k) {
+                            f = (Real(0) - sn) * e[j - 1];
+                            e[j - 1] = cs * e[j - 1];
+                        }
+                        if (vt) v_rot.push(j, p - 1, cs, sn);
+                    }
+                    break;
+                }
+                case Split: {
+                    // d[k - 1] is zero: chase e[k - 1] down and out by rotations from the left
+                    Real f = e[k - 1];
+                    e[k - 1] = Real(0);
+                    for (size_t j = k; j < p; j++) {
+                        const Real t = std::hypot(d[j], f);
+                        const Real cs = d[j] / t, sn = f / t;
+                        d[j] = t;
+                        f = (Real(0) - sn) * e[j];
+                        e[j] = cs * e[j];
+                        if (ut) u_rot.push(j, k - 1, cs, sn);
+                    }
+                    break;
+                }
+                case QRStep: {
+                    // Shift by the eigenvalue of the trailing 2x2 block of B^T * B closer to its last element
+                    const Real scale = std::max({std::abs(d[p - 1]), std::abs(d[p - 2]), std::abs(e[p - 2]),
+                                                 std::abs(d[k]), std::abs(e[k])});
+                    const Real sp = d[p - 1] / scale, spm1 = d[p - 2] / scale, epm1 = e[p - 2] / scale;
+                    const Real sk = d[k] / scale, ek = e[k] / scale;
+                    const Real b = ((spm1 + sp) * (spm1 - sp) + epm1 * epm1) / Real(2);
+                    const Real c = (sp * epm1) * (sp * epm1);
+                    Real shift(0);
+                    if (b != Real(0) || c != Real(0)) {
+                        shift = std::sqrt(b * b + c);
+                        if (b < Real(0)) shift = Real(0) - shift;
+                        shift = c / (b + shift);
+                    }
+
+                    // Chase the bulge down from k to p - 1
+                    Real f = (sk + sp) * (sk - sp) + shift;
+                    Real g = sk * ek;
+                    for (size_t j = k; j + 1 < p; j++) {
+                        Real t = std::hypot(f, g);
+                        Real cs = f / t, sn = g / t;
+                        if (j != k) e[j - 1] = t;
+                        f = cs * d[j] + sn * e[j];
+                        e[j] = cs * e[j] - sn * d[j];
+                        g = sn * d[j + 1];
+                        d[j + 1] = cs * d[j + 1];
+                        if (vt) v_rot.push(j, j + 1, cs, sn);
+
+                        t = std::hypot(f, g);
+                        cs = f / t;
+                        sn = g / t;
+                        d[j] = t;
+                        f = cs * e[j] + sn * d[j + 1];
+                        d[j + 1] = cs * d[j + 1] - sn * e[j];
+                        g = sn * e[j + 1];
+                        e[j + 1] = cs * e[j + 1];
+                        if (ut) u_rot.push(j, j + 1, cs, sn);
+                    }
+                    e[p - 2] = f;
+                    break;
+                }
+                case Converged: {
+                    p--;
+                    break;
+                }
+            }
+            flush(false);
+        }
+        flush(true);
+
+        // A singular value is final once deflated, so the signs can be fixed at the end
+        for (size_t j = 0; j < n; j++) {
+            if (d[j] >= Real(0)) continue;
+            d[j] = Real(0) - d[j];
+            if (vt)
+                for (size_t i = 0; i < n; i++) vt[j * n + i] = Real(0) - vt[j * n + i];
+        }
+        return true;
+    }
+
+
+    /* Computes the singular value decomposition A = U * diag(s) * V^H of the m x n row-major matrix `a`, m >= n,
+     * which is overwritten. The singular values are written to s in descending order. If `u` and `vh` are not null
+     * they get the first u_cols (n or m) columns of U and the n x n matrix V^H.
+     * A is first factored as Q * R by the blocked Householder QR, R is reduced to bidiagonal form and diagonalised
+     * by Golub-Kahan QR sweeps, and the reflectors then carry the singular vectors back to A's through gemm.
+     * Returns false if the QR sweeps did not converge. */
+    template <typename T>
+    bool svd_tall(T* a, const size_t m, const size_t n, underlying_type_t<T>* s, T* u, const size_t u_cols, T* vh) {
+        using Real = underlying_type_t<T>;
+        std::vector<T> tau(n), tauq(n), taup(n);
+        householder_qr(a, m, n, tau.data());
+
+        std::vector<T> r(n * n, T(0));
+        for (size_t i = 0; i < n; i++)
+            for (size_t j = i; j < n; j++) r[i * n + j] = a[i * n + j];
+        std::vector<Real> d(n), e(n), ut, vt;
+        bidiagonalize(r.data(), n, d.data(), e.data(), tauq.data(), taup.data());
+
+        const bool vectors = u && vh;
+        if (vectors) {
+            ut.assign(n * n, Real(0));
+            vt.assign(n * n, Real(0));
+            for (size_t i = 0; i < n; i++) ut[i * n + i] = vt[i * n + i] = Real(1);
+        }
+        if (!bidiagonal_qr(d.data(), e.data(), n, vectors ? ut.data() : nullptr, vectors ? vt.data() : nullptr))
+            return false;
+
+        std::vector<size_t> order(n);
+        std::iota(order.begin(), order.end(), size_t(0));
+        std::stable_sort(order.begin(), order.end(), [&] (const size_t x, const size_t y) { return d[x] > d[y]; });
+        for (size_t j = 0; j < n; j++) s[j] = d[order[j]];
+        if (!vectors) return true;
+
+        // U = Q * [Q_B * U_B, 0; 0, I] and V = P * V_B
+        std::fill(u, u + m * u_cols, T(0));
+        for (size_t j = 0; j < n; j++) {
+            const Real* row = ut.data() + order[j] * n;
+            for (size_t i = 0; i < n; i++) u[i * u_cols + j] = T(row[i]);
+        }
+        for (size_t i = n; i < u_cols; i++) u[i * u_cols + i] = T(1);
+        apply_q(r.data(), n, n, n, tauq.data(), u, u_cols);
+        apply_q(a, m, n, n, tau.data(), u, u_cols);
+
+        std::vector<T> v(n * n);
+        for (size_t j = 0; j < n; j++) {
+            const Real* row = vt.data() + order[j] * n;
+            for (size_t i = 0; i < n; i++) v[i * n + j] = T(row[i]);
+        }
+        if (n > 1) {
+            // The vectors of P, moved below the diagonal of an (n - 1) x (n - 1) matrix for apply_q
+            std::vector<T> pv((n - 1) * (n - 1), T(0));
+            for (size_t j = 0; j + 1 < n; j++)
+                for (size_t c = j + 2; c < n; c++) pv[(c - 1) * (n - 1) + j] = r[j * n + c];
+            apply_q(pv.data(), n - 1, n - 1, n - 1, taup.data(), v.data() + n, n);
+        }
+        for (size_t i = 0; i < n; i++)
+            for (size_t j = 0; j < n; j++) vh[j * n + i] = numxx::conj(v[i * n + j]);
+        return true;
+    }
+
+} // namespace numxx::util
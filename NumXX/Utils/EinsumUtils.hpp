@@ -0,0 +1,490 @@
+/* EinsumUtils.hpp */
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Errors.hpp"
+#include "Gemm.hpp"
+#include "Parallel.hpp"
+
+
+namespace numxx::util {
+
+/* A tensor taking part in a contraction: its dimensions, the label of every axis and its row-major data.
+ * `data` points either into an input array, which is never copied unless it has to be rearranged, or at
+ * `owned`, whose buffer keeps its address when the tensor is moved. */
+template <typename T>
+struct LabelledTensor {
+    const T* data = nullptr;
+    std::vector<T> owned;
+    std::vector<int> labels;
+    std::vector<size_t> dims;
+
+    LabelledTensor() = default;
+
+    LabelledTensor(const T* data, std::vector<int> labels, std::vector<size_t> dims)
+        : data(data), labels(std::move(labels)), dims(std::move(dims)) {}
+
+    LabelledTensor(std::vector<T>&& values, std::vector<int> labels, std::vector<size_t> dims)
+        : owned(std::move(values)), labels(std::move(labels)), dims(std::move(dims)) { data = owned.data(); }
+
+    [[nodiscard]] size_t get_size() const {
+        size_t size = 1;
+        for (const size_t d : dims) size *= d;
+        return size;
+    }
+};
+
+
+// Returns the row-major strides of a tensor with the dimensions `dims`
+inline std::vector<size_t> get_strides(const std::vector<size_t>& dims) {
+    std::vector<size_t> strides(dims.size(), 1);
+    for (size_t i = dims.size(); i-- > 1;) strides[i - 1] = strides[i] * dims[i];
+    return strides;
+}
+
+
+/* Copies the elements src[sum of idx[i] * strides[i]] into the row-major tensor `dst` with the dimensions
+ * `dims`, for every index idx of it: an axis permutation when `strides` are permuted strides of the source,
+ * and a diagonal when one stride is the sum of several. The last axis is copied by an inner loop, and the
+ * rows are split across threads. */
+template <typename T>
+void gather_strided(const T* src, const std::vector<size_t>& dims, const std::vector<size_t>& strides, T* dst) {
+    const size_t ndim = dims.size();
+    if (ndim == 0) {
+        dst[0] = src[0];
+        return;
+    }
+
+    const size_t inner = dims.back(), inner_stride = strides.back();
+    size_t rows = 1;
+    for (size_t i = 0; i + 1 < ndim; i++) rows *= dims[i];
+    if (rows == 0 || inner == 0) return;
+
+    parallel_for(rows, std::max<size_t>(1, (1 << 16) / inner), [&] (const size_t begin, const size_t end, size_t) {
+        // Unravel the first row of the chunk, then step through the rows like an odometer
+        std::vector<size_t> index(ndim - 1);
+        size_t offset = 0;
+        for (size_t i = ndim - 1, r = begin; i-- > 0;) {
+            index[i] = r % dims[i];
+            r /= dims[i];
+            offset += index[i] * strides[i];
+        }
+
+        for (size_t r = begin; r < end; r++) {
+            T* out = dst + r * inner;
+            const T* in = src + offset;
+            if (inner_stride == 1) {
+                for (size_t j = 0; j < inner; j++) out[j] = in[j];
+            } else {
+                for (size_t j = 0; j < inner; j++) out[j] = in[j * inner_stride];
+            }
+
+            for (size_t i = ndim - 1; i-- > 0;) {
+                offset += strides[i];
+                if (++index[i] < dims[i]) break;
+                offset -= strides[i] * dims[i];
+                index[i] = 0;
+            }
+        }
+    });
+}
+
+
+// Rearranges a tensor so that its axes carry `labels` in that order, copying only if the order changes
+template <typename T>
+void permute_labels(LabelledTensor<T>& tensor, const std::vector<int>& labels) {
+    if (tensor.labels == labels) return;
+
+    const std::vector<size_t> src_strides = get_strides(tensor.dims);
+    std::vector<size_t> dims, strides;
+    for (const int label : labels) {
+        const size_t axis = static_cast<size_t>(
+            std::find(tensor.labels.begin(), tensor.labels.end(), label) - tensor.labels.begin());
+        dims.push_back(tensor.dims[axis]);
+        strides.push_back(src_strides[axis]);
+    }
+
+    std::vector<T> values(tensor.get_size());
+    gather_strided(tensor.data, dims, strides, values.data());
+    tensor = LabelledTensor<T>(std::move(values), labels, std::move(dims));
+}
+
+
+/* Replaces the axes that share a label (as "ii" in a trace) by the single axis of their diagonal, keeping the
+ * first occurrence of every label in place. The shared axes must have the same length. */
+template <typename T>
+void take_diagonals(LabelledTensor<T>& tensor) {
+    std::vector<int> labels;
+    std::vector<size_t> dims, strides;
+    const std::vector<size_t> src_strides = get_strides(tensor.dims);
+    for (size_t axis = 0; axis < tensor.labels.size(); axis++) {
+        const size_t pos = static_cast<size_t>(
+            std::find(labels.begin(), labels.end(), tensor.labels[axis]) - labels.begin());
+        if (pos == labels.size()) {
+            labels.push_back(tensor.labels[axis]);
+            dims.push_back(tensor.dims[axis]);
+            strides.push_back(src_strides[axis]);
+        } else {
+            if (dims[pos] != tensor.dims[axis])
+                throw error::ShapeError("Repeated einsum subscripts must index axes of the same length.");
+            strides[pos] += src_strides[axis];
+        }
+    }
+    if (labels.size() == tensor.labels.size()) return;
+
+    size_t size = 1;
+    for (const size_t d : dims) size *= d;
+    std::vector<T> values(size);
+    gather_strided(tensor.data, dims, strides, values.data());
+    tensor = LabelledTensor<T>(std::move(values), std::move(labels), std::move(dims));
+}
+
+
+// Sums a tensor over the axes whose labels are not in `keep`, keeping the order of the other axes
+template <typename T>
+void sum_out_labels(LabelledTensor<T>& tensor, const std::vector<int>& keep) {
+    std::vector<int> kept, summed;
+    size_t kept_size = 1, summed_size = 1;
+    for (size_t axis = 0; axis < tensor.labels.size(); axis++) {
+        if (std::find(keep.begin(), keep.end(), tensor.labels[axis]) != keep.end()) {
+            kept.push_back(tensor.labels[axis]);
+            kept_size *= tensor.dims[axis];
+        } else {
+            summed.push_back(tensor.labels[axis]);
+            summed_size *= tensor.dims[axis];
+        }
+    }
+    if (summed.empty()) return;
+
+    std::vector<int> order = kept;
+    order.insert(order.end(), summed.begin(), summed.end());
+    permute_labels(tensor, order);
+
+    std::vector<T> values(kept_size);
+    std::vector<size_t> dims(tensor.dims.begin(), tensor.dims.begin() + static_cast<std::ptrdiff_t>(kept.size()));
+    parallel_for(kept_size, std::max<size_t>(1, (1 << 16) / std::max<size_t>(1, summed_size)),
+        [&] (const size_t begin, const size_t end, size_t) {
+            for (size_t i = begin; i < end; i++) {
+                const T* block = tensor.data + i * summed_size;
+                T sum(0);
+                for (size_t j = 0; j < summed_size; j++) sum += block[j];
+                values[i] = sum;
+            }
+        }
+    );
+    tensor = LabelledTensor<T>(std::move(values), std::move(kept), std::move(dims));
+}
+
+
+/* Contracts the tensors a and b over the labels they share, keeping the labels in `keep` (those still needed
+ * by other tensors or by the output). Labels that are in both and kept are batch axes; labels in both and not
+ * kept are summed over; labels in only one tensor and not kept are summed out of it first.
+ * Both tensors are permuted (copied only if needed) to [batch, free, contracted] and [batch, contracted, free],
+ * so every batch is one gemm, and the result has the labels [batch, free of a, free of b]. */
+template <typename T>
+LabelledTensor<T> contract_pair(LabelledTensor<T> a, LabelledTensor<T> b, const std::vector<int>& keep) {
+    auto in = [] (const std::vector<int>& labels, const int label) {
+        return std::find(labels.begin(), labels.end(), label) != labels.end();
+    };
+
+    std::vector<int> keep_a = keep, keep_b = keep;
+    keep_a.insert(keep_a.end(), b.labels.begin(), b.labels.end());
+    keep_b.insert(keep_b.end(), a.labels.begin(), a.labels.end());
+    sum_out_labels(a, keep_a);
+    sum_out_labels(b, keep_b);
+
+    std::vector<int> batch, contracted, free_a, free_b;
+    size_t n_batch = 1, m = 1, k = 1, n = 1;
+    for (size_t axis = 0; axis < a.labels.size(); axis++) {
+        const int label = a.labels[axis];
+        if (!in(b.labels, label)) {
+            free_a.push_back(label);
+            m *= a.dims[axis];
+        } else if (in(keep, label)) {
+            batch.push_back(label);
+            n_batch *= a.dims[axis];
+        } else {
+            contracted.push_back(label);
+            k *= a.dims[axis];
+        }
+    }
+    for (size_t axis = 0; axis < b.labels.size(); axis++) {
+        if (!in(a.labels, b.labels[axis])) {
+            free_b.push_back(b.labels[axis]);
+            n *= b.dims[axis];
+        }
+    }
+
+    std::vector<int> order_a = batch, order_b = batch;
+    order_a.insert(order_a.end(), free_a.begin(), free_a.end());
+    order_a.insert(order_a.end(), contracted.begin(), contracted.end());
+    order_b.insert(order_b.end(), contracted.begin(), contracted.end());
+    order_b.insert(order_b.end(), free_b.begin(), free_b.end());
+    permute_labels(a, order_a);
+    permute_labels(b, order_b);
+
+    std::vector<int> labels = batch;
+    labels.insert(labels.end(), free_a.begin(), free_a.end());
+    labels.insert(labels.end(), free_b.begin(), free_b.end());
+    std::vector<size_t> dims(a.dims.begin(), a.dims.begin() + static_cast<std::ptrdiff_t>(batch.size() + free_a.size()));
+    dims.insert(dims.end(), b.dims.end() - static_cast<std::ptrdiff_t>(free_b.size()), b.dims.end());
+
+    std::vector<T> values(n_batch * m * n);
+    const size_t grain = std::max<size_t>(1, gemm_parallel_grain / std::max<size_t>(1, m * n * k));
+    parallel_for(n_batch, grain, [&] (const size_t begin, const size_t end, size_t) {
+        for (size_t p = begin; p < end; p++)
+            gemm(m, n, k, T(1), a.data + p * m * k, k, b.data + p * k * n, n, T(0), values.data() + p * m * n, n);
+    });
+    return LabelledTensor<T>(std::move(values), std::move(labels), std::move(dims));
+}
+
+
+/* ====== Contraction order ====== */
+
+// Returns the number of multiply-adds of contracting tensors with the labels `a` and `b`: the product of the
+// lengths of all the labels involved
+inline double get_contraction_cost(const std::vector<int>& a, const std::vector<int>& b, const std::vector<size_t>& sizes) {
+    double cost = 1;
+    for (const int label : a) cost *= static_cast<double>(sizes[static_cast<size_t>(label)]);
+    for (const int label : b)
+        if (std::find(a.begin(), a.end(), label) == a.end()) cost *= static_cast<double>(sizes[static_cast<size_t>(label)]);
+    return cost;
+}
+
+
+// Returns the labels of the union of `a` and `b` that appear in `needed`
+inline std::vector<int> get_kept_labels(const std::vector<int>& a, const std::vector<int>& b, const std::vector<int>& needed) {
+    std::vector<int> kept;
+    for (const auto* labels : {&a, &b})
+        for (const int label : *labels)
+            if (std::find(needed.begin(), needed.end(), label) != needed.end() &&
+                std::find(kept.begin(), kept.end(), label) == kept.end()) kept.push_back(label);
+    return kept;
+}
+
+
+// Up to this many operands, einsum searches every contraction order; beyond it, it picks one greedily
+constexpr size_t einsum_optimal_limit = 8;
+
+
+/* Returns a pairwise contraction order for tensors with the given labels, which contributes `output` to the
+ * result, as a list of pairs of tensor ids: the inputs are 0 to n-1, and the result of the i-th pair is n + i.
+ * Small problems search all orders (a dynamic programme over subsets of the operands, O(3^n)) for the fewest
+ * multiply-adds. Larger ones repeatedly contract the pair with the fewest multiply-adds, preferring the
+ * smallest result. */
+inline std::vector<std::pair<size_t, size_t>> get_contraction_order(
+    const std::vector<std::vector<int>>& operand_labels, const std::vector<int>& output, const std::vector<size_t>& sizes
+) {
+    const size_t n = operand_labels.size();
+    std::vector<std::pair<size_t, size_t>> order;
+    if (n < 2) return order;
+
+    // The labels of a group of operands that something outside the group still needs
+    auto needed_outside = [&] (const std::vector<bool>& inside) {
+        std::vector<int> needed = output;
+        for (size_t i = 0; i < n; i++)
+            if (!inside[i]) needed.insert(needed.end(), operand_labels[i].begin(), operand_labels[i].end());
+        return needed;
+    };
+
+    if (n <= einsum_optimal_limit) {
+        const size_t n_sets = size_t(1) << n;
+        std::vector<std::vector<int>> labels(n_sets);
+        std::vector<double> cost(n_sets, std::numeric_limits<double>::infinity());
+        std::vector<size_t> split(n_sets, 0);
+        for (size_t set = 1; set < n_sets; set++) {
+            std::vector<bool> inside(n);
+            std::vector<int> all;
+            for (size_t i = 0; i < n; i++) {
+                inside[i] = (set >> i) & 1;
+                if (inside[i]) all.insert(all.end(), operand_labels[i].begin(), operand_labels[i].end());
+            }
+            labels[set] = get_kept_labels(all, {}, needed_outside(inside));
+            if ((set & (set - 1)) == 0) cost[set] = 0;
+        }
+        for (size_t set = 1; set < n_sets; set++) {
+            if ((set & (set - 1)) == 0) continue;
+            // Every split into two non-empty halves, each visited once by keeping the lowest operand on the left
+            const size_t low = set & (~set + 1);
+            for (size_t left = (set - 1) & set; left > 0; left = (left - 1) & set) {
+                if (!(left & low)) continue;
+                const size_t right = set ^ left;
+                const double c = cost[left] + cost[right] + get_contraction_cost(labels[left], labels[right], sizes);
+                if (c < cost[set]) {
+                    cost[set] = c;
+                    split[set] = left;
+                }
+            }
+        }
+
+        // Emit the contractions of the best tree, children before parents
+        std::vector<std::pair<size_t, size_t>> stack = {{n_sets - 1, 0}};
+        std::vector<size_t> ids(n_sets, 0);
+        for (size_t i = 0; i < n; i++) ids[size_t(1) << i] = i;
+        while (!stack.empty()) {
+            auto& [set, state] = stack.back();
+            if ((set & (set - 1)) == 0) {
+                stack.pop_back();
+            } else if (state == 0) {
+                state = 1;
+                const size_t left = split[set];
+                stack.push_back({left, 0});
+            } else if (state == 1) {
+                state = 2;
+                const size_t right = set ^ split[set];
+                stack.push_back({right, 0});
+            } else {
+                order.emplace_back(ids[split[set]], ids[set ^ split[set]]);
+                ids[set] = n + order.size() - 1;
+                stack.pop_back();
+            }
+        }
+        return order;
+    }
+
+    std::vector<std::vector<int>> live = operand_labels;
+    std::vector<size_t> live_ids(n);
+    for (size_t i = 0; i < n; i++) live_ids[i] = i;
+    while (live.size() > 1) {
+        double best_cost = std::numeric_limits<double>::infinity(), best_size = 0;
+        size_t best_i = 0, best_j = 1;
+        std::vector<int> best_labels;
+        for (size_t i = 0; i < live.size(); i++) {
+            for (size_t j = i + 1; j < live.size(); j++) {
+                std::vector<int> needed = output;
+                for (size_t t = 0; t < live.size(); t++)
+                    if (t != i && t != j) needed.insert(needed.end(), live[t].begin(), live[t].end());
+                std::vector<int> kept = get_kept_labels(live[i], live[j], needed);
+                const double c = get_contraction_cost(live[i], live[j], sizes);
+                double size = 1;
+                for (const int label : kept) size *= static_cast<double>(sizes[static_cast<size_t>(label)]);
+                if (c < best_cost || (c == best_cost && size < best_size)) {
+                    best_cost = c;
+                    best_size = size;
+                    best_i = i;
+                    best_j = j;
+                    best_labels = std::move(kept);
+                }
+            }
+        }
+        order.emplace_back(live_ids[best_i], live_ids[best_j]);
+        live.erase(live.begin() + static_cast<std::ptrdiff_t>(best_j));
+        live_ids.erase(live_ids.begin() + static_cast<std::ptrdiff_t>(best_j));
+        live[best_i] = std::move(best_labels);
+        live_ids[best_i] = n + order.size() - 1;
+    }
+    return order;
+}
+
+
+/* ====== Subscripts ====== */
+
+// Returns the label of an einsum subscript letter: 0-25 for 'a'-'z' and 26-51 for 'A'-'Z'
+inline int get_einsum_label(const char c) {
+    if (c >= 'a' && c <= 'z') return c - 'a';
+    if (c >= 'A' && c <= 'Z') return c - 'A' + 26;
+    throw error::ValueError(std::string("Invalid einsum subscript '") + c + "': subscripts must be letters.");
+}
+
+
+/* Parses einsum subscripts such as "bij,bjk->bik" for `n_operands` operands into the labels of every operand
+ * and of the output. Without "->", the output is every label that appears exactly once, in alphabetical
+ * order (uppercase after lowercase), as in NumPy. Spaces are ignored. */
+inline std::pair<std::vector<std::vector<int>>, std::vector<int>> parse_einsum(
+    const std::string& subscripts, const size_t n_operands
+) {
+    std::string spec;
+    for (const char c : subscripts)
+        if (c != ' ') spec.push_back(c);
+
+    const size_t arrow = spec.find("->");
+    const std::string inputs = spec.substr(0, arrow);
+
+    std::vector<std::vector<int>> operand_labels(1);
+    for (const char c : inputs) {
+        if (c == ',') operand_labels.emplace_back();
+        else operand_labels.back().push_back(get_einsum_label(c));
+    }
+    if (operand_labels.size() != n_operands)
+        throw error::ValueError("einsum subscripts name " + std::to_string(operand_labels.size())
+                                + " operands, but " + std::to_string(n_operands) + " were given.");
+
+    std::vector<size_t> counts(52, 0);
+    for (const auto& labels : operand_labels)
+        for (const int label : labels) counts[static_cast<size_t>(label)]++;
+
+    std::vector<int> output;
+    if (arrow == std::string::npos) {
+        for (int label = 0; label < 52; label++)
+            if (counts[static_cast<size_t>(label)] == 1) output.push_back(label);
+    } else {
+        for (const char c : spec.substr(arrow + 2)) {
+            const int label = get_einsum_label(c);
+            if (std::find(output.begin(), output.end(), label) != output.end())
+                throw error::ValueError(std::string("einsum output subscript '") + c + "' appears more than once.");
+            if (counts[static_cast<size_t>(label)] == 0)
+                throw error::ValueError(std::string("einsum output subscript '") + c + "' does not appear in the inputs.");
+            output.push_back(label);
+        }
+    }
+    return {std::move(operand_labels), std::move(output)};
+}
+
+
+/* Evaluates a tensor contraction: the operands' axes carry integer labels, and the result has the axes
+ * labelled `output`, summed over every other label. Repeated labels within an operand are reduced to their
+ * diagonal first, then pairs of tensors are contracted in the order of get_contraction_order, and the last
+ * tensor is summed over what is left and permuted into the order of `output`. */
+template <typename T>
+LabelledTensor<T> contract_tensors(std::vector<LabelledTensor<T>> tensors, const std::vector<int>& output) {
+    const size_t n = tensors.size();
+
+    int max_label = -1;
+    for (auto& tensor : tensors) {
+        take_diagonals(tensor);
+        for (const int label : tensor.labels) max_label = std::max(max_label, label);
+    }
+    std::vector<size_t> sizes(static_cast<size_t>(max_label + 1), 0);
+    std::vector<bool> seen(sizes.size(), false);
+    for (const auto& tensor : tensors) {
+        for (size_t axis = 0; axis < tensor.labels.size(); axis++) {
+            const size_t label = static_cast<size_t>(tensor.labels[axis]);
+            if (seen[label] && sizes[label] != tensor.dims[axis])
+                throw error::ShapeError("Operands disagree on the length of a contracted axis.");
+            seen[label] = true;
+            sizes[label] = tensor.dims[axis];
+        }
+    }
+
+    std::vector<std::vector<int>> operand_labels(n);
+    for (size_t i = 0; i < n; i++) operand_labels[i] = tensors[i].labels;
+    const auto order = get_contraction_order(operand_labels, output, sizes);
+
+    std::vector<bool> live(n + order.size(), false);
+    std::fill(live.begin(), live.begin() + static_cast<std::ptrdiff_t>(n), true);
+    tensors.resize(n + order.size());
+    for (size_t step = 0; step < order.size(); step++) {
+        const auto [i, j] = order[step];
+        live[i] = live[j] = false;
+
+        std::vector<int> keep = output;
+        for (size_t t = 0; t < live.size(); t++)
+            if (live[t]) keep.insert(keep.end(), tensors[t].labels.begin(), tensors[t].labels.end());
+        tensors[n + step] = contract_pair(std::move(tensors[i]), std::move(tensors[j]), keep);
+        live[n + step] = true;
+        tensors[i] = LabelledTensor<T>();
+        tensors[j] = LabelledTensor<T>();
+    }
+
+    LabelledTensor<T> result = std::move(tensors.back());
+    sum_out_labels(result, output);
+    permute_labels(result, output);
+    return result;
+}
+
+} // namespace numxx::util
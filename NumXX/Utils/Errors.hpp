@@ -36,6 +36,12 @@ public:
         : std::runtime_error("[ArgumentError]: " + std::move(message)) {}
 };
 
+class LinAlgError final : public std::runtime_error {
+public:
+    explicit LinAlgError(std::string&& message)
+        : std::runtime_error("[LinAlgError]: " + std::move(message)) {}
+};
+
 
 class ConversionError final : public std::domain_error {
 public:
@@ -0,0 +1,304 @@
+/* ExtremaUtils.hpp */
+#pragma once
+
+#include <limits>
+#include <utility>
+
+#include "ReduceUtils.hpp"
+
+
+namespace numxx::util {
+
+// Key used to order elements: the value itself, or the squared magnitude for complex numbers
+// (which orders complex numbers the same way as complex::operator<, without the square root)
+template <typename T>
+auto order_key(const T& x) {
+    if constexpr (is_complex_v<T>) {
+        using K = floating_type_t<underlying_type_t<T>>;
+        const K re = x.real(), im = x.imag();
+        return re * re + im * im;
+    } else {
+        return x;
+    }
+}
+
+template <typename T>
+using order_key_t = decltype(order_key(std::declval<T>()));
+
+
+template <typename K>
+bool is_nan(const K& key) {
+    if constexpr (std::is_floating_point_v<K>) return key != key;
+    else return false;
+}
+
+
+// Returns true if key `a` beats key `b` (NaNs never win a comparison)
+template <bool IsMax, typename K>
+bool is_better(const K& a, const K& b) {
+    if constexpr (IsMax) return b < a;
+    else return a < b;
+}
+
+
+// Returns the worst possible key, i.e. the starting point of a search for the extremum
+template <bool IsMax, typename K>
+K worst_key() {
+    if constexpr (std::numeric_limits<K>::has_infinity)
+        return IsMax ? -std::numeric_limits<K>::infinity() : std::numeric_limits<K>::infinity();
+    else
+        return IsMax ? std::numeric_limits<K>::lowest() : std::numeric_limits<K>::max();
+}
+
+
+/* Returns the index of the first extremum of a contiguous run.
+ * Without SkipNaN the first NaN wins, with SkipNaN NaNs are ignored and `len` is returned if every element is NaN.
+ * The first pass finds the extreme key with independent branchless compare/blend lanes (which the compiler
+ * can turn into SIMD min/max instructions); the second pass finds where it occurs. */
+template <bool IsMax, bool SkipNaN, typename T>
+size_t arg_extremum(const T* x, const size_t len) {
+    using K = order_key_t<T>;
+    constexpr size_t lanes = 8;
+
+    K acc[lanes];
+    bool nan_seen[lanes];
+    for (size_t k = 0; k < lanes; k++) {
+        acc[k] = worst_key<IsMax, K>();
+        nan_seen[k] = false;
+    }
+
+    size_t i = 0;
+    for (; i + lanes <= len; i += lanes) {
+        for (size_t k = 0; k < lanes; k++) {
+            const K key = order_key(x[i + k]);
+            acc[k] = is_better<IsMax>(key, acc[k]) ? key : acc[k];
+            nan_seen[k] |= is_nan(key);
+        }
+    }
+
+    K best = acc[0];
+    bool has_nan = nan_seen[0];
+    for (size_t k = 1; k < lanes; k++) {
+        best = is_better<IsMax>(acc[k], best) ? acc[k] : best;
+        has_nan |= nan_seen[k];
+    }
+    for (; i < len; i++) {
+        const K key = order_key(x[i]);
+        best = is_better<IsMax>(key, best) ? key : best;
+        has_nan |= is_nan(key);
+    }
+
+    if (!SkipNaN && has_nan) {
+        for (i = 0; i < len; i++)
+            if (is_nan(order_key(x[i]))) return i;
+    }
+    for (i = 0; i < len; i++)
+        if (order_key(x[i]) == best) return i;
+    return len;
+}
+
+
+// Returns a NaN of type T (only reached for types that can hold one)
+template <typename T>
+T nan_value() {
+    if constexpr (is_complex_v<T>) {
+        const auto nan = std::numeric_limits<underlying_type_t<T>>::quiet_NaN();
+        return T(nan, nan);
+    } else {
+        return std::numeric_limits<T>::quiet_NaN();
+    }
+}
+
+
+// Returns the extremum of a contiguous run (NaN if it must propagate, or if every element is NaN)
+template <bool IsMax, bool SkipNaN, typename T>
+T extremum(const T* x, const size_t len) {
+    const size_t i = arg_extremum<IsMax, SkipNaN>(x, len);
+    return (i < len) ? x[i] : nan_value<T>();
+}
+
+
+/* Returns the minimum and the maximum of a contiguous run in a single pass (both NaN if any element is NaN).
+ * Each lane keeps both a low and a high key with branchless compare/blends, as in arg_extremum. Real
+ * elements are their own keys, so the extreme keys are the result; complex elements take one more pass to
+ * find the first elements with the extreme magnitudes. */
+template <typename T>
+std::pair<T, T> minmax_extrema(const T* x, const size_t len) {
+    using K = order_key_t<T>;
+    constexpr size_t lanes = 8;
+
+    K lo_acc[lanes], hi_acc[lanes];
+    bool nan_seen[lanes];
+    for (size_t k = 0; k < lanes; k++) {
+        lo_acc[k] = worst_key<false, K>();
+        hi_acc[k] = worst_key<true, K>();
+        nan_seen[k] = false;
+    }
+
+    size_t i = 0;
+    for (; i + lanes <= len; i += lanes) {
+        for (size_t k = 0; k < lanes; k++) {
+            const K key = order_key(x[i + k]);
+            lo_acc[k] = is_better<false>(key, lo_acc[k]) ? key : lo_acc[k];
+            hi_acc[k] = is_better<true>(key, hi_acc[k]) ? key : hi_acc[k];
+            nan_seen[k] |= is_nan(key);
+        }
+    }
+
+    K lo = lo_acc[0], hi = hi_acc[0];
+    bool has_nan = nan_seen[0];
+    for (size_t k = 1; k < lanes; k++) {
+        lo = is_better<false>(lo_acc[k], lo) ? lo_acc[k] : lo;
+        hi = is_better<true>(hi_acc[k], hi) ? hi_acc[k] : hi;
+        has_nan |= nan_seen[k];
+    }
+    for (; i < len; i++) {
+        const K key = order_key(x[i]);
+        lo = is_better<false>(key, lo) ? key : lo;
+        hi = is_better<true>(key, hi) ? key : hi;
+        has_nan |= is_nan(key);
+    }
+
+    if (has_nan) return {nan_value<T>(), nan_value<T>()};
+    if constexpr (is_complex_v<T>) {
+        size_t lo_idx = len, hi_idx = len;
+        for (i = 0; i < len && (lo_idx == len || hi_idx == len); i++) {
+            const K key = order_key(x[i]);
+            if (lo_idx == len && key == lo) lo_idx = i;
+            if (hi_idx == len && key == hi) hi_idx = i;
+        }
+        return {x[lo_idx], x[hi_idx]};
+    } else {
+        return {lo, hi};
+    }
+}
+
+
+// Returns true if `candidate` should replace the current extremum `current`
+template <bool IsMax, bool SkipNaN, typename T>
+bool should_replace(const T& candidate, const T& current) {
+    const auto cand_key = order_key(candidate), cur_key = order_key(current);
+    if constexpr (SkipNaN)
+        return !is_nan(cand_key) && (is_better<IsMax>(cand_key, cur_key) || is_nan(cur_key));
+    else
+        return is_better<IsMax>(cand_key, cur_key) || (is_nan(cand_key) && !is_nan(cur_key));
+}
+
+
+// Finds the extrema over the masked dimensions of an NArray
+template <bool IsMax, bool SkipNaN, typename T>
+NArray<T> extremum_along(const NArray<T>& arr, const std::vector<bool>& mask, const bool keepdims) {
+    const Shape& shape = arr.get_shape();
+    Shape out_shape = get_reduced_shape(shape, mask, keepdims);
+    if (get_reduction_size(shape, mask) == 0 && out_shape.get_total_size() != 0)
+        throw error::ValueError("Cannot find the extrema of a zero-size array.");
+
+    NArray<T> out(std::move(out_shape));
+    const T* in = arr.get_data();
+    T* res = out.get_data();
+
+    for_each_reduce_run(shape, mask,
+        [&] (size_t in_off, size_t out_off, size_t red_off, size_t len, bool inner_reduced) {
+            const T* src = in + in_off;
+            T* dst = res + out_off;
+
+            if (inner_reduced) {
+                const T value = extremum<IsMax, SkipNaN>(src, len);
+                if (red_off == 0 || should_replace<IsMax, SkipNaN>(value, *dst)) *dst = value;
+            } else if (red_off == 0) {
+                for (size_t j = 0; j < len; j++) dst[j] = src[j];
+            } else {
+                for (size_t j = 0; j < len; j++)
+                    dst[j] = should_replace<IsMax, SkipNaN>(src[j], dst[j]) ? src[j] : dst[j];
+            }
+        }
+    );
+    return out;
+}
+
+
+// Finds the indices of the extrema along a single axis of an NArray
+template <bool IsMax, bool SkipNaN, typename T>
+NArray<size_t> arg_extremum_along(const NArray<T>& arr, const int axis, const bool keepdims) {
+    const Shape& shape = arr.get_shape();
+    const auto mask = get_axes_mask(shape, {axis});
+    Shape out_shape = get_reduced_shape(shape, mask, keepdims);
+    if (get_reduction_size(shape, mask) == 0 && out_shape.get_total_size() != 0)
+        throw error::ValueError("Cannot find the extrema of a zero-size array.");
+
+    NArray<size_t> out(out_shape);
+    NArray<T> best(std::move(out_shape));
+    const T* in = arr.get_data();
+    size_t* idx = out.get_data();
+    T* val = best.get_data();
+
+    for_each_reduce_run(shape, mask,
+        [&] (size_t in_off, size_t out_off, size_t red_off, size_t len, bool inner_reduced) {
+            const T* src = in + in_off;
+
+            // A single reduced axis that is innermost is always covered by one run
+            if (inner_reduced) {
+                const size_t i = arg_extremum<IsMax, SkipNaN>(src, len);
+                if (i == len) throw error::ValueError("All-NaN slice encountered.");
+                val[out_off] = src[i];
+                idx[out_off] = i;
+            } else if (red_off == 0) {
+                for (size_t j = 0; j < len; j++) {
+                    val[out_off + j] = src[j];
+                    idx[out_off + j] = 0;
+                }
+            } else {
+                for (size_t j = 0; j < len; j++) {
+                    const bool take = should_replace<IsMax, SkipNaN>(src[j], val[out_off + j]);
+                    val[out_off + j] = take ? src[j] : val[out_off + j];
+                    idx[out_off + j] = take ? red_off : idx[out_off + j];
+                }
+            }
+        }
+    );
+
+    if constexpr (SkipNaN) {
+        for (size_t i = 0; i < best.get_total_size(); i++)
+            if (is_nan(order_key(val[i]))) throw error::ValueError("All-NaN slice encountered.");
+    }
+    return out;
+}
+
+
+// Finds both the minima and the maxima over the masked dimensions in one traversal
+template <typename T>
+std::pair<NArray<T>, NArray<T>> minmax_along(const NArray<T>& arr, const std::vector<bool>& mask, const bool keepdims) {
+    const Shape& shape = arr.get_shape();
+    Shape out_shape = get_reduced_shape(shape, mask, keepdims);
+    if (get_reduction_size(shape, mask) == 0 && out_shape.get_total_size() != 0)
+        throw error::ValueError("Cannot find the extrema of a zero-size array.");
+
+    NArray<T> lo(out_shape), hi(std::move(out_shape));
+    const T* in = arr.get_data();
+    T* lo_data = lo.get_data();
+    T* hi_data = hi.get_data();
+
+    for_each_reduce_run(shape, mask,
+        [&] (size_t in_off, size_t out_off, size_t red_off, size_t len, bool inner_reduced) {
+            const T* src = in + in_off;
+            T* l = lo_data + out_off;
+            T* h = hi_data + out_off;
+
+            if (inner_reduced) {
+                const auto [run_lo, run_hi] = minmax_extrema(src, len);
+                if (red_off == 0 || should_replace<false, false>(run_lo, *l)) *l = run_lo;
+                if (red_off == 0 || should_replace<true, false>(run_hi, *h)) *h = run_hi;
+            } else if (red_off == 0) {
+                for (size_t j = 0; j < len; j++) l[j] = h[j] = src[j];
+            } else {
+                for (size_t j = 0; j < len; j++) {
+                    l[j] = should_replace<false, false>(src[j], l[j]) ? src[j] : l[j];
+                    h[j] = should_replace<true, false>(src[j], h[j]) ? src[j] : h[j];
+                }
+            }
+        }
+    );
+    return {std::move(lo), std::move(hi)};
+}
+
+} // namespace numxx::util
@@ -0,0 +1,364 @@
+/* Gemm.hpp */
+#pragma once
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "Blas.hpp"
+#include "Parallel.hpp"
+
+
+namespace numxx::util {
+
+/* Block sizes of the packed matrix product. The micro-kernel keeps an mr x nr tile of C in registers,
+ * a kc x nr sliver of packed B stays in L1, an mc x kc block of packed A stays in L2 and a kc x nc
+ * panel of packed B stays in L3. Other element types (integers, complex numbers) use a small tile. */
+template <typename T>
+struct GemmBlocking {
+    static constexpr size_t mr = 2, nr = 4, mc = 64, kc = 128, nc = 1024;
+};
+
+template <>
+struct GemmBlocking<double> {
+    static constexpr size_t mr = 8, nr = 8, mc = 128, kc = 256, nc = 2048;
+};
+
+template <>
+struct GemmBlocking<float> {
+    static constexpr size_t mr = 8, nr = 8, mc = 128, kc = 256, nc = 4096;
+};
+
+
+// Copies the mc x kc block of A at `a` into row panels of `mr` rows, each stored column by column
+// The last panel is padded with zeros
+template <size_t MR, typename T>
+void pack_gemm_a(const T* a, const size_t lda, const size_t mc, const size_t kc, T* out) {
+    for (size_t i0 = 0; i0 < mc; i0 += MR) {
+        const size_t rows = std::min(MR, mc - i0);
+        for (size_t p = 0; p < kc; p++) {
+            for (size_t i = 0; i < rows; i++) out[i] = a[(i0 + i) * lda + p];
+            for (size_t i = rows; i < MR; i++) out[i] = T(0);
+            out += MR;
+        }
+    }
+}
+
+
+// Copies the kc x nc block of B at `b` into column panels of `nr` columns, each stored row by row
+// The last panel is padded with zeros
+template <size_t NR, typename T>
+void pack_gemm_b(const T* b, const size_t ldb, const size_t kc, const size_t nc, T* out) {
+    for (size_t j0 = 0; j0 < nc; j0 += NR) {
+        const size_t cols = std::min(NR, nc - j0);
+        for (size_t p = 0; p < kc; p++) {
+            const T* row = b + p * ldb + j0;
+            for (size_t j = 0; j < cols; j++) out[j] = row[j];
+            for (size_t j = cols; j < NR; j++) out[j] = T(0);
+            out += NR;
+        }
+    }
+}
+
+
+/* Multiplies a packed MR x kc panel of A by a packed kc x NR panel of B and writes
+ * alpha * product + beta * C into the top-left mr x nr corner of the tile of C at `c`.
+ * The whole tile is accumulated in a local array of fixed size, which the compiler keeps in vector registers.
+ * C is not read when beta is zero. */
+template <size_t MR, size_t NR, typename T>
+void gemm_micro_kernel(
+    const size_t kc, const T* ap, const T* bp, T* c, const size_t ldc,
+    const size_t mr, const size_t nr, const T alpha, const T beta
+) {
+    T acc[MR][NR];
+    for (size_t i = 0; i < MR; i++)
+        for (size_t j = 0; j < NR; j++) acc[i][j] = T(0);
+
+    for (size_t p = 0; p < kc; p++) {
+        T b[NR];
+        for (size_t j = 0; j < NR; j++) b[j] = bp[j];
+        for (size_t i = 0; i < MR; i++) {
+            const T ai = ap[i];
+            for (size_t j = 0; j < NR; j++) acc[i][j] += ai * b[j];
+        }
+        ap += MR;
+        bp += NR;
+    }
+
+    for (size_t i = 0; i < mr; i++) {
+        T* row = c + i * ldc;
+        const T* tile = acc[i];
+        if (beta == T(0)) {
+            for (size_t j = 0; j < nr; j++) row[j] = alpha * tile[j];
+        } else {
+            for (size_t j = 0; j < nr; j++) row[j] = alpha * tile[j] + beta * row[j];
+        }
+    }
+}
+
+
+// Computes C = alpha * A * B + beta * C one row of C at a time, as a sum of scaled rows of B
+// Packing does not pay off for small or thin products, which this handles instead
+template <typename T>
+void gemm_rows(
+    const size_t m, const size_t n, const size_t k, const T alpha,
+    const T* a, const size_t lda, const T* b, const size_t ldb,
+    const T beta, T* c, const size_t ldc
+) {
+    for (size_t i = 0; i < m; i++) {
+        T* row = c + i * ldc;
+        if (beta == T(0)) {
+            for (size_t j = 0; j < n; j++) row[j] = T(0);
+        } else if (!(beta == T(1))) {
+            for (size_t j = 0; j < n; j++) row[j] *= beta;
+        }
+
+        for (size_t t = 0; t < k; t++) {
+            const T x = alpha * a[i * lda + t];
+            const T* b_row = b + t * ldb;
+            for (size_t j = 0; j < n; j++) row[j] += x * b_row[j];
+        }
+    }
+}
+
+
+// Products with fewer multiply-adds than this, or with a dimension below gemm_min_dim, skip the packing
+constexpr size_t gemm_min_work = 64 * 64 * 64;
+constexpr size_t gemm_min_dim = 16;
+
+// Multiply-adds per thread below which a product is not split further
+constexpr size_t gemm_parallel_grain = 1 << 21;
+
+
+/* Returns how to split an m x n block of C across `n_parts` threads as a (row parts, column parts) grid,
+ * choosing the factorisation of `n_parts` whose pieces are closest to square. Square pieces read the least
+ * packed data per multiply-add: every thread packs the rows of A it needs and streams its columns of B. */
+inline std::pair<size_t, size_t> get_gemm_grid(const size_t m, const size_t n, const size_t n_parts) {
+    std::pair<size_t, size_t> best{n_parts, 1};
+    double best_ratio = 0;
+    for (size_t rows = 1; rows <= n_parts; rows++) {
+        if (n_parts % rows) continue;
+        const double h = static_cast<double>(m) / static_cast<double>(rows);
+        const double w = static_cast<double>(n) / static_cast<double>(n_parts / rows);
+        const double ratio = std::min(h, w) / std::max(h, w);
+        if (ratio > best_ratio) {
+            best_ratio = ratio;
+            best = {rows, n_parts / rows};
+        }
+    }
+    return best;
+}
+
+
+/* Multiplies the rows [r0, r1) of A (from column pc, kc wide) by the packed kc x nc panel of B, restricted
+ * to the columns [c0, c1) of the panel (multiples of NR), into the matching part of C.
+ * The rows are taken mc at a time, each block being packed into `packed_a` first. */
+template <typename T>
+void gemm_macro_kernel(
+    const size_t r0, const size_t r1, const size_t c0, const size_t c1, const size_t kc,
+    const T alpha, const T* a, const size_t lda, const T* packed_b,
+    const T beta, T* c, const size_t ldc, T* packed_a
+) {
+    using B = GemmBlocking<T>;
+    constexpr size_t MR = B::mr, NR = B::nr;
+
+    for (size_t ic = r0; ic < r1; ic += B::mc) {
+        const size_t mc = std::min(B::mc, r1 - ic);
+        pack_gemm_a<MR>(a + ic * lda, lda, mc, kc, packed_a);
+
+        for (size_t jr = c0; jr < c1; jr += NR) {
+            for (size_t ir = 0; ir < mc; ir += MR) {
+                gemm_micro_kernel<MR, NR>(
+                    kc, packed_a + ir * kc, packed_b + jr * kc, c + (ic + ir) * ldc + jr, ldc,
+                    std::min(MR, mc - ir), std::min(NR, c1 - jr), alpha, beta
+                );
+            }
+        }
+    }
+}
+
+
+/* Returns the dot product of the contiguous vectors x and y of length n. Eight independent partial sums let
+ * consecutive multiply-adds overlap instead of each waiting on the last, and the compiler pairs them into
+ * vector registers; they are named variables rather than an array so that they stay in registers. */
+template <typename T>
+T dot_kernel(const size_t n, const T* x, const T* y) {
+    T s0(0), s1(0), s2(0), s3(0), s4(0), s5(0), s6(0), s7(0);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        s0 += x[i] * y[i];         s1 += x[i + 1] * y[i + 1];
+        s2 += x[i + 2] * y[i + 2]; s3 += x[i + 3] * y[i + 3];
+        s4 += x[i + 4] * y[i + 4]; s5 += x[i + 5] * y[i + 5];
+        s6 += x[i + 6] * y[i + 6]; s7 += x[i + 7] * y[i + 7];
+    }
+    T sum = ((s0 + s4) + (s2 + s6)) + ((s1 + s5) + (s3 + s7));
+    for (; i < n; i++) sum += x[i] * y[i];
+    return sum;
+}
+
+
+// Multiply-adds per thread below which a matrix-vector or dot product is not split further
+constexpr size_t gemv_parallel_grain = 1 << 16;
+
+
+// Returns the dot product of the contiguous vectors x and y of length n, split across threads when long enough
+template <typename T>
+T dot(const size_t n, const T* x, const T* y) {
+    const size_t n_parts = in_parallel_region ? 1 : get_num_chunks(n, gemv_parallel_grain);
+    if (n_parts == 1) return dot_kernel(n, x, y);
+
+    std::vector<T> partial(n_parts);
+    parallel_for(n, gemv_parallel_grain, [&] (const size_t begin, const size_t end, const size_t chunk) {
+        partial[chunk] = dot_kernel(end - begin, x + begin, y + begin);
+    });
+    T sum(0);
+    for (const T& p : partial) sum += p;
+    return sum;
+}
+
+
+/* Computes y = alpha * A * x + beta * y for a row-major m x k matrix A with leading dimension lda, a contiguous
+ * vector x and a vector y with stride incy. Every element of y is the dot product of a row of A with x, so A is
+ * read once, row by row, and the rows are split across threads. y is not read when beta is zero. */
+template <typename T>
+void gemv(
+    const size_t m, const size_t k, const T alpha, const T* a, const size_t lda,
+    const T* x, const T beta, T* y, const size_t incy
+) {
+    if (m == 1) {
+        const T s = alpha * dot(k, a, x);
+        y[0] = (beta == T(0)) ? s : s + beta * y[0];
+        return;
+    }
+
+    parallel_for(m, std::max<size_t>(1, gemv_parallel_grain / std::max<size_t>(1, k)),
+        [&] (const size_t begin, const size_t end, size_t) {
+            for (size_t i = begin; i < end; i++) {
+                const T s = alpha * dot_kernel(k, a + i * lda, x);
+                y[i * incy] = (beta == T(0)) ? s : s + beta * y[i * incy];
+            }
+        }
+    );
+}
+
+
+/* Computes y = alpha * x^T * B + beta * y for a contiguous vector x of length k, a row-major k x n matrix B with
+ * leading dimension ldb and a contiguous vector y of length n: a sum of scaled rows of B. Four rows are added per
+ * pass over y, which quarters the traffic through y, and the columns are split across threads, each running
+ * down its own strip of B. y is not read when beta is zero. */
+template <typename T>
+void gemv_t(
+    const size_t k, const size_t n, const T alpha, const T* x,
+    const T* b, const size_t ldb, const T beta, T* y
+) {
+    parallel_for(n, std::max<size_t>(64, gemv_parallel_grain / std::max<size_t>(1, k)),
+        [&] (const size_t begin, const size_t end, size_t) {
+            T* out = y + begin;
+            const size_t cols = end - begin;
+            if (beta == T(0)) {
+                for (size_t j = 0; j < cols; j++) out[j] = T(0);
+            } else if (!(beta == T(1))) {
+                for (size_t j = 0; j < cols; j++) out[j] *= beta;
+            }
+
+            size_t t = 0;
+            for (; t + 4 <= k; t += 4) {
+                const T x0 = alpha * x[t], x1 = alpha * x[t + 1], x2 = alpha * x[t + 2], x3 = alpha * x[t + 3];
+                const T* r0 = b + t * ldb + begin;
+                const T *r1 = r0 + ldb, *r2 = r1 + ldb, *r3 = r2 + ldb;
+                for (size_t j = 0; j < cols; j++) out[j] += (x0 * r0[j] + x1 * r1[j]) + (x2 * r2[j] + x3 * r3[j]);
+            }
+            for (; t < k; t++) {
+                const T xt = alpha * x[t];
+                const T* r = b + t * ldb + begin;
+                for (size_t j = 0; j < cols; j++) out[j] += xt * r[j];
+            }
+        }
+    );
+}
+
+
+/* Computes C = alpha * A * B + beta * C for a row-major m x k matrix A, k x n matrix B and m x n matrix C,
+ * with leading dimensions (row strides) lda, ldb and ldc. C is not read when beta is zero.
+ * This is the GotoBLAS scheme: a kc x nc panel of B and then an mc x kc block of A are packed into
+ * contiguous buffers, in the order the micro-kernel reads them, and the micro-kernel sweeps the block
+ * one mr x nr tile of C at a time.
+ * Large products are split across threads over a 2D grid of rows and columns of C. The threads share one
+ * packed panel of B, which they pack together, and each packs its own blocks of A.
+ * Products with a single row or column of C go to gemv_t and gemv instead, and with the BLAS backend enabled
+ * (NUMXX_USE_BLAS) the product goes to the system BLAS. */
+template <typename T>
+void gemm(
+    const size_t m, const size_t n, const size_t k, const T alpha,
+    const T* a, const size_t lda, const T* b, const size_t ldb,
+    const T beta, T* c, const size_t ldc
+) {
+    if (blas::gemm(m, n, k, alpha, a, lda, b, ldb, beta, c, ldc)) return;
+
+    if (n == 1) {
+        if (ldb == 1) {
+            gemv(m, k, alpha, a, lda, b, beta, c, ldc);
+        } else {
+            std::vector<T> x(k);
+            for (size_t t = 0; t < k; t++) x[t] = b[t * ldb];
+            gemv(m, k, alpha, a, lda, x.data(), beta, c, ldc);
+        }
+        return;
+    }
+    if (m == 1) {
+        gemv_t(k, n, alpha, a, b, ldb, beta, c);
+        return;
+    }
+
+    using B = GemmBlocking<T>;
+    constexpr size_t MR = B::mr, NR = B::nr;
+
+    if (m * n * k < gemm_min_work || std::min({m, n, k}) < gemm_min_dim) {
+        gemm_rows(m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+        return;
+    }
+
+    const size_t n_parts = in_parallel_region ? 1 : get_num_chunks(m * n * k, gemm_parallel_grain);
+    const size_t mc_max = std::min(B::mc, (m + MR - 1) / MR * MR);
+    const size_t nc_max = std::min(B::nc, (n + NR - 1) / NR * NR);
+    const size_t kc_max = std::min(B::kc, k);
+    std::vector<T> packed_a(n_parts * mc_max * kc_max), packed_b(kc_max * nc_max);
+
+    for (size_t jc = 0; jc < n; jc += B::nc) {
+        const size_t nc = std::min(B::nc, n - jc);
+        const size_t n_panels = (nc + NR - 1) / NR;
+        const auto [row_parts, col_parts] = get_gemm_grid(m, nc, n_parts);
+
+        for (size_t pc = 0; pc < k; pc += B::kc) {
+            const size_t kc = std::min(B::kc, k - pc);
+            const T beta_block = (pc == 0) ? beta : T(1);
+            const T* a_block = a + pc;
+            T* c_block = c + jc;
+
+            parallel_for(n_panels, std::max<size_t>(1, (1 << 16) / (kc * NR)),
+                [&] (const size_t begin, const size_t end, size_t) {
+                    pack_gemm_b<NR>(b + pc * ldb + jc + begin * NR, ldb, kc,
+                        std::min(end * NR, nc) - begin * NR, packed_b.data() + begin * NR * kc);
+                }
+            );
+
+            // Rows are split in whole micro-tiles, and columns in whole packed panels
+            const size_t m_tiles = (m + MR - 1) / MR;
+            parallel_for(n_parts, 1, [&] (const size_t begin, const size_t end, size_t) {
+                for (size_t part = begin; part < end; part++) {
+                    const size_t rp = part / col_parts, cp = part % col_parts;
+                    const size_t r0 = std::min(m, get_chunk_begin(m_tiles, row_parts, rp) * MR);
+                    const size_t r1 = std::min(m, get_chunk_begin(m_tiles, row_parts, rp + 1) * MR);
+                    const size_t c0 = std::min(nc, get_chunk_begin(n_panels, col_parts, cp) * NR);
+                    const size_t c1 = std::min(nc, get_chunk_begin(n_panels, col_parts, cp + 1) * NR);
+                    if (r0 == r1 || c0 == c1) continue;
+
+                    gemm_macro_kernel(r0, r1, c0, c1, kc, alpha, a_block, lda, packed_b.data(),
+                        beta_block, c_block, ldc, packed_a.data() + part * mc_max * kc_max);
+                }
+            });
+        }
+    }
+}
+
+} // namespace numxx::util
@@ -0,0 +1,93 @@
+/* HistogramUtils.hpp */
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "Errors.hpp"
+#include "Parallel.hpp"
+#include "SortUtils.hpp"
+
+
+namespace numxx::util {
+
+/* Counts `n` elements into `n_bins` bins, where `bin_of(i)` gives the bin of element i (or `n_bins` to drop it)
+ * and `weight_of(i)` its weight. Every thread fills a private histogram with one extra slot for the dropped
+ * elements, so the hot loop has neither branches nor atomics, and the private histograms are summed at the end. */
+template <typename C, typename BinOf, typename WeightOf>
+std::vector<C> parallel_histogram(const size_t n, const size_t n_bins, BinOf bin_of, WeightOf weight_of) {
+    constexpr size_t grain = 1 << 16;
+    std::vector<std::vector<C>> partial(get_num_chunks(n, grain));
+
+    parallel_for(n, grain, [&] (const size_t begin, const size_t end, const size_t c) {
+        std::vector<C> counts(n_bins + 1, C(0));
+        for (size_t i = begin; i < end; i++) counts[bin_of(i)] += weight_of(i);
+        partial[c] = std::move(counts);
+    });
+
+    std::vector<C> total(n_bins, C(0));
+    for (const auto& counts : partial)
+        for (size_t b = 0; b < n_bins; b++) total[b] += counts[b];
+    return total;
+}
+
+
+// Returns `n_bins + 1` evenly spaced edges from lo to hi
+inline std::vector<double> get_uniform_edges(const double lo, const double hi, const size_t n_bins) {
+    std::vector<double> edges(n_bins + 1);
+    const double width = (hi - lo) / static_cast<double>(n_bins);
+    for (size_t b = 0; b < n_bins; b++) edges[b] = lo + width * static_cast<double>(b);
+    edges[n_bins] = hi;
+    return edges;
+}
+
+
+/* Returns the bin of x among `n_bins` equal bins spanning `edges`, or `n_bins` if x is outside them (or NaN).
+ * The bin is computed directly from x and corrected by at most one when rounding puts x on the wrong side
+ * of an edge. The last bin includes its right edge. */
+inline size_t get_uniform_bin(const double x, const double* edges, const size_t n_bins, const double scale) {
+    if (!(x >= edges[0] && x <= edges[n_bins])) return n_bins;
+    auto b = std::min(static_cast<size_t>((x - edges[0]) * scale), n_bins - 1);
+    if (x < edges[b]) b--;
+    else if (b + 1 < n_bins && x >= edges[b + 1]) b++;
+    return b;
+}
+
+
+// Returns the bin of x among the bins between consecutive sorted `edges`, or `n_bins` if x is outside them
+// The last bin includes its right edge
+template <typename E, typename T>
+size_t get_edges_bin(const T& x, const E* edges, const size_t n_bins) {
+    if (!(x >= edges[0] && x <= edges[n_bins])) return n_bins;
+    const size_t b = branchless_search<true>(edges, n_bins + 1, x);
+    return std::min(b, n_bins) - 1;
+}
+
+
+// Throws unless the `n` edges are at least two monotonically increasing values
+template <typename E>
+void check_bin_edges(const E* edges, const size_t n) {
+    if (n < 2) throw error::ValueError("At least two bin edges are required.");
+    for (size_t i = 1; i < n; i++) {
+        if (!(edges[i - 1] <= edges[i]))
+            throw error::ValueError("Bin edges must increase monotonically.");
+    }
+}
+
+
+/* Returns true if the `n` edges increase monotonically and false if they decrease monotonically, and throws if
+ * they do neither or there are none. Equal edges count as increasing. */
+template <typename E>
+bool check_monotonic_edges(const E* edges, const size_t n) {
+    if (n == 0) throw error::ValueError("At least one bin edge is required.");
+    bool increasing = true, decreasing = true;
+    for (size_t i = 1; i < n; i++) {
+        increasing &= edges[i - 1] <= edges[i];
+        decreasing &= edges[i - 1] >= edges[i];
+    }
+    if (!increasing && !decreasing)
+        throw error::ValueError("Bins must increase or decrease monotonically.");
+    return increasing;
+}
+
+} // namespace numxx::util
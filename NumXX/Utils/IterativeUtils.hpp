@@ -0,0 +1,73 @@
+/* IterativeUtils.hpp */
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "../Complex.hpp"
+#include "Gemm.hpp"
+#include "Parallel.hpp"
+
+
+namespace numxx::util {
+
+    // Elements per thread below which a vector update of an iterative solver is not split further
+    constexpr size_t iterative_grain = 1 << 15;
+
+
+    // Returns x^H * y for contiguous vectors of length n, conjugating x if it is complex
+    template <typename T>
+    T dotc(const size_t n, const T* x, const T* y) {
+        if constexpr (!is_complex_v<T>) {
+            return dot(n, x, y);
+        } else {
+            auto kernel = [&] (const size_t begin, const size_t end) {
+                T s0(0), s1(0);
+                size_t i = begin;
+                for (; i + 2 <= end; i += 2) {
+                    s0 += x[i].conj() * y[i];
+                    s1 += x[i + 1].conj() * y[i + 1];
+                }
+                if (i < end) s0 += x[i].conj() * y[i];
+                return s0 + s1;
+            };
+
+            const size_t n_parts = in_parallel_region ? 1 : get_num_chunks(n, gemv_parallel_grain);
+            if (n_parts == 1) return kernel(0, n);
+
+            std::vector<T> partial(n_parts);
+            parallel_for(n, gemv_parallel_grain, [&] (const size_t begin, const size_t end, const size_t chunk) {
+                partial[chunk] = kernel(begin, end);
+            });
+            T sum(0);
+            for (const T& p : partial) sum += p;
+            return sum;
+        }
+    }
+
+
+    // Returns the Euclidean norm of a contiguous vector of length n
+    template <typename T>
+    underlying_type_t<T> norm2(const size_t n, const T* x) {
+        const T s = dotc(n, x, x);
+        if constexpr (is_complex_v<T>) return std::sqrt(s.real());
+        else return std::sqrt(s);
+    }
+
+
+    /* Returns the plane rotation (c, s), with c real, that maps the pair (a, b) to (r, 0) as
+     * [c, s; -conj(s), c] * [a; b]. For real a and b this is the usual Givens rotation. */
+    template <typename T>
+    std::pair<underlying_type_t<T>, T> get_givens_rotation(const T& a, const T& b) {
+        using Real = underlying_type_t<T>;
+        const Real abs_a = static_cast<Real>(numxx::abs(a)), abs_b = static_cast<Real>(numxx::abs(b));
+        if (abs_b == Real(0)) return {Real(1), T(0)};
+        if (abs_a == Real(0)) return {Real(0), T(1)};
+
+        const Real r = std::hypot(abs_a, abs_b);
+        return {abs_a / r, (a / T(abs_a)) * numxx::conj(b) / T(r)};
+    }
+
+} // namespace numxx::util
@@ -1,7 +1,15 @@
 /* LinalgUtils.hpp */
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+
 #include "../Core/NArray.hpp"
+#include "Gemm.hpp"
+#include "Parallel.hpp"
 
 
 namespace numxx::util {
@@ -32,4 +40,574 @@ namespace numxx::util {
         return out;
     }
 
+
+    // Throws unless `mat` is a square matrix, returning its order
+    template <typename T>
+    size_t check_square_matrix(const NArray<T>& mat, const std::string& operation) {
+        const Shape& shape = mat.get_shape();
+        if (!shape.is_square()) {
+            throw error::ShapeError(toString(shape) + " is not square. Cannot take the " + operation
+                + " of non-square matrix.");
+        }
+        return (shape.get_Ndim() == 2) ? shape[0] : 1;
+    }
+
+
+    // Throws unless `b` is a vector of length n or a matrix with n rows, returning its number of columns
+    template <typename T>
+    size_t check_right_hand_side(const NArray<T>& b, const size_t n) {
+        const Shape& shape = b.get_shape();
+        if ((shape.get_Ndim() != 1 && shape.get_Ndim() != 2) || shape[0] != n) {
+            throw error::ShapeError("A right-hand side of shape " + toString(shape) + " does not match a system with "
+                + toString(n) + " equations.");
+        }
+        return (shape.get_Ndim() == 2) ? shape[1] : 1;
+    }
+
+
+    // Converts a value to the floating type R (which is complex if T is)
+    template <typename R, typename T>
+    R to_floating(const T& x) {
+        if constexpr (is_complex_v<T>) return R(x.real(), x.imag());
+        else return static_cast<R>(x);
+    }
+
+
+    // Returns a contiguous copy of an NArray converted to the floating type R
+    template <typename R, typename T>
+    std::vector<R> get_floating_copy(const NArray<T>& arr) {
+        std::vector<R> out(arr.get_total_size());
+        const T* data = arr.get_data();
+        for (size_t i = 0; i < out.size(); i++) out[i] = to_floating<R>(data[i]);
+        return out;
+    }
+
+
+    // Returns a contiguous copy of the m x n matrix `mat` converted to R if m >= n, or of its conjugate
+    // transpose otherwise, so that the copy is always at least as tall as it is wide
+    template <typename R, typename T>
+    std::vector<R> get_tall_floating_copy(const NArray<T>& mat) {
+        const size_t m = mat.get_shape()[0], n = mat.get_shape()[1];
+        std::vector<R> out(m * n);
+        const T* data = mat.get_data();
+        for (size_t i = 0; i < m; i++) {
+            for (size_t j = 0; j < n; j++) {
+                const R x = to_floating<R>(data[i * n + j]);
+                if (m >= n) out[i * n + j] = x;
+                else out[j * m + i] = numxx::conj(x);
+            }
+        }
+        return out;
+    }
+
+
+    // Magnitude used to choose pivots: |x| for real numbers and the squared magnitude for complex ones
+    template <typename T>
+    auto pivot_magnitude(const T& x) {
+        if constexpr (is_complex_v<T>) return x.real() * x.real() + x.imag() * x.imag();
+        else return std::abs(x);
+    }
+
+
+    // Returns |x|^2, which for complex numbers needs no square root
+    template <typename T>
+    auto abs_squared(const T& x) {
+        if constexpr (is_complex_v<T>) return x.real() * x.real() + x.imag() * x.imag();
+        else return x * x;
+    }
+
+
+    // a[i, c0:c1] -= l * a[t, c0:c1] for the rows i in [i0, i1), with l = a[i, t] for every t in [t0, t1)
+    // This is the rank-(t1 - t0) update that LU applies to the rows below (or the block right of) a factored panel
+    template <typename T>
+    void lu_update_rows(
+        T* a, const size_t lda, const size_t i0, const size_t i1,
+        const size_t t0, const size_t t1, const size_t c0, const size_t c1
+    ) {
+        for (size_t i = i0; i < i1; i++) {
+            T* row = a + i * lda;
+            for (size_t t = t0; t < t1; t++) {
+                const T l = row[t];
+                if (l == T(0)) continue;
+                const T* pivot_row = a + t * lda;
+                for (size_t c = c0; c < c1; c++) row[c] -= l * pivot_row[c];
+            }
+        }
+    }
+
+
+    /* Factors the n x n row-major matrix `a` in place as P * A = L * U with partial pivoting, storing the unit
+     * lower triangle of L below the diagonal and U on and above it. At step j, row j was swapped with row piv[j].
+     * The factorisation is blocked (right-looking): a panel of `block` columns is factored one column at a time,
+     * the block right of it is solved against its unit lower triangle, and the trailing matrix then receives a
+     * single rank-`block` update through the (multithreaded) gemm. A zero pivot leaves its column unscaled,
+     * so a singular matrix factors into a U with a zero on the diagonal. LAPACK's getrf takes over when the
+     * backend of Blas.hpp is enabled. */
+    template <typename T>
+    void lu_factor(T* a, const size_t n, size_t* piv) {
+        if (blas::getrf(a, n, piv)) return;
+
+        constexpr size_t block = 64;
+
+        for (size_t k0 = 0; k0 < n; k0 += block) {
+            const size_t k1 = std::min(k0 + block, n);
+
+            // Factor the panel a[k0:n, k0:k1]
+            for (size_t j = k0; j < k1; j++) {
+                size_t p = j;
+                auto best = pivot_magnitude(a[j * n + j]);
+                for (size_t i = j + 1; i < n; i++) {
+                    const auto mag = pivot_magnitude(a[i * n + j]);
+                    if (best < mag) {
+                        best = mag;
+                        p = i;
+                    }
+                }
+                piv[j] = p;
+                if (p != j) std::swap_ranges(a + j * n, a + (j + 1) * n, a + p * n);
+
+                const T pivot = a[j * n + j];
+                if (pivot == T(0)) continue;
+                const T inv_pivot = T(1) / pivot;
+                for (size_t i = j + 1; i < n; i++) a[i * n + j] *= inv_pivot;
+                lu_update_rows(a, n, j + 1, n, j, j + 1, j + 1, k1);
+            }
+            if (k1 == n) break;
+
+            // U12 = L11^-1 * A12, then A22 -= L21 * U12
+            for (size_t i = k0 + 1; i < k1; i++) lu_update_rows(a, n, i, i + 1, k0, i, k1, n);
+
+            gemm(n - k1, n - k1, k1 - k0, T(-1), a + k1 * n + k0, n, a + k0 * n + k1, n, T(1), a + k1 * n + k1, n);
+        }
+    }
+
+
+    // Throws if the factored matrix has a zero on the diagonal of U (or R)
+    template <typename T>
+    void check_nonsingular(const T* a, const size_t n, const size_t lda) {
+        for (size_t i = 0; i < n; i++)
+            if (a[i * lda + i] == T(0)) throw error::LinAlgError("Singular matrix.");
+    }
+
+
+    // Applies the row interchanges recorded by lu_factor, in order, to the n x nrhs row-major matrix `b`
+    template <typename T>
+    void lu_apply_pivots(T* b, const size_t n, const size_t nrhs, const size_t* piv) {
+        for (size_t j = 0; j < n; j++)
+            if (piv[j] != j) std::swap_ranges(b + j * nrhs, b + (j + 1) * nrhs, b + piv[j] * nrhs);
+    }
+
+
+    // Block size of the triangular solves, whose updates off the diagonal blocks go through gemm
+    constexpr size_t trsm_block = 64;
+
+
+    /* Solves L * X = B in place for the n x nrhs row-major matrix `b`, where L is the lower triangle of the
+     * matrix `l` (leading dimension lda), taken to have ones on its diagonal if `unit_diagonal` is set.
+     * Every diagonal block is solved by forward substitution, and the rows below it are then updated by a
+     * single gemm. */
+    template <typename T>
+    void trsm_lower(const T* l, const size_t lda, const size_t n, T* b, const size_t nrhs, const bool unit_diagonal) {
+        if (blas::trsm(l, lda, n, b, nrhs, true, unit_diagonal)) return;
+
+        for (size_t k0 = 0; k0 < n; k0 += trsm_block) {
+            const size_t k1 = std::min(k0 + trsm_block, n);
+            for (size_t i = k0; i < k1; i++) {
+                T* row = b + i * nrhs;
+                for (size_t t = k0; t < i; t++) {
+                    const T x = l[i * lda + t];
+                    const T* src = b + t * nrhs;
+                    for (size_t c = 0; c < nrhs; c++) row[c] -= x * src[c];
+                }
+                if (!unit_diagonal) {
+                    const T inv_diag = T(1) / l[i * lda + i];
+                    for (size_t c = 0; c < nrhs; c++) row[c] *= inv_diag;
+                }
+            }
+            if (k1 < n)
+                gemm(n - k1, nrhs, k1 - k0, T(-1), l + k1 * lda + k0, lda, b + k0 * nrhs, nrhs, T(1), b + k1 * nrhs, nrhs);
+        }
+    }
+
+
+    /* Solves U * X = B in place for the n x nrhs row-major matrix `b`, where U is the upper triangle of the
+     * matrix `u` (leading dimension lda) with a nonzero diagonal. The diagonal blocks are solved from the bottom
+     * up by back substitution, each followed by a gemm update of the rows above it. */
+    template <typename T>
+    void trsm_upper(const T* u, const size_t lda, const size_t n, T* b, const size_t nrhs) {
+        if (blas::trsm(u, lda, n, b, nrhs, false, false)) return;
+
+        const size_t n_blocks = (n + trsm_block - 1) / trsm_block;
+        for (size_t blk = n_blocks; blk-- > 0;) {
+            const size_t k0 = blk * trsm_block, k1 = std::min(k0 + trsm_block, n);
+            for (size_t i = k1; i-- > k0;) {
+                T* row = b + i * nrhs;
+                for (size_t t = i + 1; t < k1; t++) {
+                    const T x = u[i * lda + t];
+                    const T* src = b + t * nrhs;
+                    for (size_t c = 0; c < nrhs; c++) row[c] -= x * src[c];
+                }
+                const T inv_diag = T(1) / u[i * lda + i];
+                for (size_t c = 0; c < nrhs; c++) row[c] *= inv_diag;
+            }
+            if (k0 > 0)
+                gemm(k0, nrhs, k1 - k0, T(-1), u + k0, lda, b + k0 * nrhs, nrhs, T(1), b, nrhs);
+        }
+    }
+
+
+    // Solves A * X = B in place for the n x nrhs matrix `b`, given the LU factorisation of A from lu_factor
+    template <typename T>
+    void lu_solve(const T* lu, const size_t n, const size_t* piv, T* b, const size_t nrhs) {
+        lu_apply_pivots(b, n, nrhs, piv);
+        trsm_lower(lu, n, n, b, nrhs, true);
+        trsm_upper(lu, n, n, b, nrhs);
+    }
+
+
+    /* Factors the lower triangle of the n x n row-major Hermitian matrix `a` in place as A = L * L^H, leaving L
+     * in the lower triangle and zeros above it; the upper triangle of A is never read. Returns false if A is not
+     * positive definite. The factorisation is blocked (right-looking): the diagonal block is factored directly,
+     * the rows below it are solved against it in parallel, and the lower triangle of the trailing matrix then
+     * receives the update A22 -= L21 * L21^H, one block row at a time through gemm (the work of a SYRK).
+     * LAPACK's potrf takes over when the backend of Blas.hpp is enabled. */
+    template <typename T>
+    bool cholesky_factor(T* a, const size_t n) {
+        if (bool positive_definite = false; blas::potrf(a, n, positive_definite)) return positive_definite;
+
+        using Real = underlying_type_t<T>;
+        constexpr size_t block = 64;
+        std::vector<T> l21_h;
+
+        for (size_t k0 = 0; k0 < n; k0 += block) {
+            const size_t k1 = std::min(k0 + block, n), nb = k1 - k0;
+
+            // Factor the diagonal block
+            for (size_t j = k0; j < k1; j++) {
+                T* row_j = a + j * n;
+                T d = row_j[j];
+                for (size_t t = k0; t < j; t++) d -= row_j[t] * numxx::conj(row_j[t]);
+
+                Real d_real;
+                if constexpr (is_complex_v<T>) d_real = d.real();
+                else d_real = d;
+                if (!(d_real > Real(0))) return false;
+
+                const Real l_jj = std::sqrt(d_real);
+                row_j[j] = T(l_jj);
+                for (size_t i = j + 1; i < k1; i++) {
+                    T* row_i = a + i * n;
+                    T s = row_i[j];
+                    for (size_t t = k0; t < j; t++) s -= row_i[t] * numxx::conj(row_j[t]);
+                    row_i[j] = s / T(l_jj);
+                }
+            }
+            if (k1 == n) break;
+
+            // L21 = A21 * L11^-H, row by row
+            parallel_for(n - k1, std::max<size_t>(1, (1 << 14) / (nb * nb)), [&] (const size_t begin, const size_t end, size_t) {
+                for (size_t i = k1 + begin; i < k1 + end; i++) {
+                    T* row_i = a + i * n;
+                    for (size_t j = k0; j < k1; j++) {
+                        const T* row_j = a + j * n;
+                        T s = row_i[j];
+                        for (size_t t = k0; t < j; t++) s -= row_i[t] * numxx::conj(row_j[t]);
+                        row_i[j] = s / row_j[j];
+                    }
+                }
+            });
+
+            // A22 -= L21 * L21^H on and below the diagonal, with L21^H packed contiguously
+            const size_t rest = n - k1;
+            l21_h.resize(nb * rest);
+            for (size_t r = 0; r < rest; r++)
+                for (size_t t = 0; t < nb; t++) l21_h[t * rest + r] = numxx::conj(a[(k1 + r) * n + k0 + t]);
+
+            for (size_t i0 = k1; i0 < n; i0 += block) {
+                const size_t i1 = std::min(i0 + block, n);
+                gemm(i1 - i0, i1 - k1, nb, T(-1), a + i0 * n + k0, n, l21_h.data(), rest, T(1), a + i0 * n + k1, n);
+            }
+        }
+
+        for (size_t i = 0; i < n; i++)
+            for (size_t j = i + 1; j < n; j++) a[i * n + j] = T(0);
+        return true;
+    }
+
+
+    // Solves A * X = B in place for the n x nrhs matrix `b`, given the Cholesky factor L of A = L * L^H
+    template <typename T>
+    void cholesky_solve(const T* l, const size_t n, T* b, const size_t nrhs) {
+        trsm_lower(l, n, n, b, nrhs, false);
+
+        std::vector<T> l_h(n * n, T(0));
+        for (size_t i = 0; i < n; i++)
+            for (size_t j = 0; j <= i; j++) l_h[j * n + i] = numxx::conj(l[i * n + j]);
+        trsm_upper(l_h.data(), n, n, b, nrhs);
+    }
+
+
+    /* Builds the Householder reflector H = I - tau * v * v^H, with v[0] = 1, for which H^H maps the vector
+     * (alpha, x) of length n to (beta, 0, ..., 0) with a real beta (LAPACK's larfg). `alpha` is overwritten
+     * by beta, x (n - 1 elements `stride` apart) by v[1:], and tau is returned. tau is zero, and H the
+     * identity, if there is nothing to eliminate. */
+    template <typename T>
+    T make_householder(T& alpha, T* x, const size_t n, const size_t stride) {
+        using Real = underlying_type_t<T>;
+        Real x_norm2(0);
+        for (size_t i = 0; i + 1 < n; i++) x_norm2 += abs_squared(x[i * stride]);
+
+        Real alpha_real;
+        if constexpr (is_complex_v<T>) {
+            alpha_real = alpha.real();
+            if (x_norm2 == Real(0) && alpha.imag() == Real(0)) return T(0);
+        } else {
+            alpha_real = alpha;
+            if (x_norm2 == Real(0)) return T(0);
+        }
+
+        const Real norm = std::sqrt(abs_squared(alpha) + x_norm2);
+        const Real beta = (alpha_real >= Real(0)) ? Real(0) - norm : norm;
+        const T tau = (T(beta) - alpha) / T(beta);
+        const T scale = T(1) / (alpha - T(beta));
+        for (size_t i = 0; i + 1 < n; i++) x[i * stride] *= scale;
+        alpha = T(beta);
+        return tau;
+    }
+
+
+    /* Applies the reflector I - tau * v * v^H to the rows [r0, r0 + len) of the columns [c0, c1) of the
+     * row-major matrix `a` from the left, where v[0] = 1 and v[i] = v_tail[(i - 1) * stride].
+     * w = v^H * A is accumulated row by row into `work` (c1 - c0 elements) so both passes stream along rows. */
+    template <typename T>
+    void apply_householder(
+        T* a, const size_t lda, const size_t r0, const size_t len, const size_t c0, const size_t c1,
+        const T* v_tail, const size_t stride, const T tau, T* work
+    ) {
+        if (tau == T(0) || c0 >= c1) return;
+        const size_t width = c1 - c0;
+
+        const T* first = a + r0 * lda + c0;
+        for (size_t c = 0; c < width; c++) work[c] = first[c];
+        for (size_t i = 1; i < len; i++) {
+            const T vi = numxx::conj(v_tail[(i - 1) * stride]);
+            const T* row = a + (r0 + i) * lda + c0;
+            for (size_t c = 0; c < width; c++) work[c] += vi * row[c];
+        }
+
+        for (size_t c = 0; c < width; c++) work[c] *= tau;
+        T* row0 = a + r0 * lda + c0;
+        for (size_t c = 0; c < width; c++) row0[c] -= work[c];
+        for (size_t i = 1; i < len; i++) {
+            const T vi = v_tail[(i - 1) * stride];
+            T* row = a + (r0 + i) * lda + c0;
+            for (size_t c = 0; c < width; c++) row[c] -= vi * work[c];
+        }
+    }
+
+
+    // Number of reflectors the blocked Householder routines gather into one block reflector
+    constexpr size_t qr_block = 32;
+
+
+    /* Gathers the nb reflectors j0, ..., j0 + nb - 1 stored below the diagonal of `qr` (m rows, leading dimension
+     * lda) into the compact WY form H_j0 * ... * H_{j0+nb-1} = I - V * T * V^H. V ((m - j0) x nb) is written out
+     * with its unit diagonal and zeros above it, and T (nb x nb) is upper triangular (LAPACK's larft). */
+    template <typename T>
+    void get_block_reflector(
+        const T* qr, const size_t lda, const size_t m, const size_t j0, const size_t nb, const T* tau,
+        std::vector<T>& v, std::vector<T>& t
+    ) {
+        const size_t rows = m - j0;
+        v.assign(rows * nb, T(0));
+        for (size_t i = 0; i < rows; i++) {
+            const T* src = qr + (j0 + i) * lda + j0;
+            for (size_t c = 0; c < std::min(i, nb); c++) v[i * nb + c] = src[c];
+            if (i < nb) v[i * nb + i] = T(1);
+        }
+
+        // T[:i, i] = -tau_i * T[:i, :i] * (V[:, :i]^H * v_i)
+        t.assign(nb * nb, T(0));
+        std::vector<T> w(nb);
+        for (size_t i = 0; i < nb; i++) {
+            const T tau_i = tau[j0 + i];
+            t[i * nb + i] = tau_i;
+            for (size_t r = 0; r < i; r++) w[r] = T(0);
+            for (size_t row = i; row < rows; row++) {
+                const T vi = v[row * nb + i];
+                for (size_t r = 0; r < i; r++) w[r] += numxx::conj(v[row * nb + r]) * vi;
+            }
+            for (size_t r = 0; r < i; r++) {
+                T s(0);
+                for (size_t c = r; c < i; c++) s += t[r * nb + c] * w[c];
+                t[r * nb + i] = (T(0) - tau_i) * s;
+            }
+        }
+    }
+
+
+    /* Applies the block reflector H = I - V * T * V^H (or H^H, if `adjoint` is set) from the left to the
+     * rows x ncols matrix `c` (leading dimension ldc): W = V^H * C and C -= V * (T * W) are both gemms, and only
+     * the small triangular product with T is done directly. */
+    template <typename T>
+    void apply_block_reflector(
+        const std::vector<T>& v, const std::vector<T>& t, const size_t rows, const size_t nb,
+        T* c, const size_t ldc, const size_t ncols, const bool adjoint
+    ) {
+        if (ncols == 0) return;
+        std::vector<T> v_h(nb * rows), w(nb * ncols);
+        for (size_t i = 0; i < rows; i++)
+            for (size_t r = 0; r < nb; r++) v_h[r * rows + i] = numxx::conj(v[i * nb + r]);
+        gemm(nb, ncols, rows, T(1), v_h.data(), rows, c, ldc, T(0), w.data(), ncols);
+
+        // W = T * W (top down) or T^H * W (bottom up), in place
+        if (adjoint) {
+            for (size_t i = nb; i-- > 0;) {
+                T* row = w.data() + i * ncols;
+                const T diag = numxx::conj(t[i * nb + i]);
+                for (size_t col = 0; col < ncols; col++) row[col] *= diag;
+                for (size_t r = 0; r < i; r++) {
+                    const T x = numxx::conj(t[r * nb + i]);
+                    const T* src = w.data() + r * ncols;
+                    for (size_t col = 0; col < ncols; col++) row[col] += x * src[col];
+                }
+            }
+        } else {
+            for (size_t i = 0; i < nb; i++) {
+                T* row = w.data() + i * ncols;
+                const T diag = t[i * nb + i];
+                for (size_t col = 0; col < ncols; col++) row[col] *= diag;
+                for (size_t r = i + 1; r < nb; r++) {
+                    const T x = t[i * nb + r];
+                    const T* src = w.data() + r * ncols;
+                    for (size_t col = 0; col < ncols; col++) row[col] += x * src[col];
+                }
+            }
+        }
+
+        gemm(rows, ncols, nb, T(-1), v.data(), nb, w.data(), ncols, T(1), c, ldc);
+    }
+
+
+    /* Factors the m x n row-major matrix `a` in place as A = Q * R with Householder reflections. R is left on
+     * and above the diagonal, and the reflector vectors below it; Q = H_0 * H_1 * ... * H_{k-1}, with
+     * k = min(m, n) and H_j = I - tau[j] * v_j * v_j^H.
+     * The factorisation is blocked: a panel of qr_block columns is factored one reflector at a time, and the
+     * reflectors are then applied to the rest of the matrix together, in compact WY form, through gemm. */
+    template <typename T>
+    void householder_qr(T* a, const size_t m, const size_t n, T* tau) {
+        const size_t k = std::min(m, n);
+        std::vector<T> work(n), v, t;
+        for (size_t j0 = 0; j0 < k; j0 += qr_block) {
+            const size_t j1 = std::min(j0 + qr_block, k);
+            for (size_t j = j0; j < j1; j++) {
+                T* v_tail = a + (j + 1) * n + j;
+                tau[j] = make_householder(a[j * n + j], v_tail, m - j, n);
+                apply_householder(a, n, j, m - j, j + 1, j1, v_tail, n, numxx::conj(tau[j]), work.data());
+            }
+            if (j1 < n) {
+                get_block_reflector(a, n, m, j0, j1 - j0, tau, v, t);
+                apply_block_reflector(v, t, m - j0, j1 - j0, a + j0 * n + j1, n, n - j1, true);
+            }
+        }
+    }
+
+
+    /* Factors the m x n row-major matrix `a` in place as A * P = Q * R with Householder reflections and column
+     * pivoting: at step j the remaining column of largest norm is swapped into place, so the magnitudes on the
+     * diagonal of R are non-increasing and reveal the numerical rank. The storage is that of householder_qr,
+     * and perm[j] is the column of A that ended up in column j. The column norms are downdated after every step
+     * and recomputed when cancellation makes the downdate unreliable (LAPACK's geqp3). Reflectors are applied
+     * one at a time, since every choice of pivot depends on the previous update. */
+    template <typename T>
+    void householder_qr_pivoted(T* a, const size_t m, const size_t n, T* tau, size_t* perm) {
+        using Real = underlying_type_t<T>;
+        const size_t k = std::min(m, n);
+        const Real tol = std::sqrt(std::numeric_limits<Real>::epsilon());
+
+        auto column_norm = [&] (const size_t col, const size_t r0) {
+            Real s(0);
+            for (size_t i = r0; i < m; i++) s += abs_squared(a[i * n + col]);
+            return std::sqrt(s);
+        };
+
+        std::vector<Real> norms(n), norms_ref(n);
+        for (size_t c = 0; c < n; c++) {
+            perm[c] = c;
+            norms[c] = norms_ref[c] = column_norm(c, 0);
+        }
+
+        std::vector<T> work(n);
+        for (size_t j = 0; j < k; j++) {
+            const size_t p = static_cast<size_t>(std::max_element(norms.begin() + j, norms.end()) - norms.begin());
+            if (p != j) {
+                for (size_t i = 0; i < m; i++) std::swap(a[i * n + j], a[i * n + p]);
+                std::swap(perm[j], perm[p]);
+                std::swap(norms[j], norms[p]);
+                std::swap(norms_ref[j], norms_ref[p]);
+            }
+
+            T* v_tail = a + (j + 1) * n + j;
+            tau[j] = make_householder(a[j * n + j], v_tail, m - j, n);
+            apply_householder(a, n, j, m - j, j + 1, n, v_tail, n, numxx::conj(tau[j]), work.data());
+
+            for (size_t c = j + 1; c < n; c++) {
+                if (norms[c] == Real(0)) continue;
+                const Real ratio = static_cast<Real>(numxx::abs(a[j * n + c])) / norms[c];
+                const Real shrink = std::max(Real(0), Real(1) - ratio * ratio);
+                const Real drift = shrink * (norms[c] / norms_ref[c]) * (norms[c] / norms_ref[c]);
+                if (drift <= tol) {
+                    norms[c] = norms_ref[c] = column_norm(c, j + 1);
+                } else {
+                    norms[c] *= std::sqrt(shrink);
+                }
+            }
+        }
+    }
+
+
+    // Computes Q^H * B in place for the m x nrhs matrix `b`, given the k reflectors stored by householder_qr
+    // in the m-row matrix `qr` with leading dimension lda. The reflectors are applied qr_block at a time
+    template <typename T>
+    void apply_qh(const T* qr, const size_t m, const size_t lda, const size_t k, const T* tau, T* b, const size_t nrhs) {
+        std::vector<T> v, t;
+        for (size_t j0 = 0; j0 < k; j0 += qr_block) {
+            const size_t nb = std::min(qr_block, k - j0);
+            get_block_reflector(qr, lda, m, j0, nb, tau, v, t);
+            apply_block_reflector(v, t, m - j0, nb, b + j0 * nrhs, nrhs, nrhs, true);
+        }
+    }
+
+
+    // Computes Q * B in place for the m x nrhs matrix `b`, given the k reflectors stored by householder_qr
+    // in the m-row matrix `qr` with leading dimension lda. The reflectors are applied qr_block at a time
+    template <typename T>
+    void apply_q(const T* qr, const size_t m, const size_t lda, const size_t k, const T* tau, T* b, const size_t nrhs) {
+        std::vector<T> v, t;
+        for (size_t blk = (k + qr_block - 1) / qr_block; blk-- > 0;) {
+            const size_t j0 = blk * qr_block, nb = std::min(qr_block, k - j0);
+            get_block_reflector(qr, lda, m, j0, nb, tau, v, t);
+            apply_block_reflector(v, t, m - j0, nb, b + j0 * nrhs, nrhs, nrhs, false);
+        }
+    }
+
+    // Builds Q and R from the Householder factorisation of an m x n matrix stored in `qr`, either reduced
+    // (Q is m x k and R is k x n, with k = min(m, n)) or complete (Q is m x m and R is m x n)
+    template <typename R>
+    std::pair<NArray<R>, NArray<R>> get_qr_factors(
+        const std::vector<R>& qr, const std::vector<R>& tau, const size_t m, const size_t n, const bool complete
+    ) {
+        const size_t k = std::min(m, n);
+        const size_t q_cols = complete ? m : k;
+
+        NArray<R> q(Shape({m, q_cols}), R(0));
+        for (size_t i = 0; i < q_cols; i++) q.get_data()[i * q_cols + i] = R(1);
+        apply_q(qr.data(), m, n, k, tau.data(), q.get_data(), q_cols);
+
+        NArray<R> r(Shape({q_cols, n}), R(0));
+        for (size_t i = 0; i < std::min(q_cols, m); i++)
+            for (size_t j = i; j < n; j++) r.get_data()[i * n + j] = qr[i * n + j];
+        return {std::move(q), std::move(r)};
+    }
+
 } // namespace numxx::util
\ No newline at end of file
@@ -0,0 +1,165 @@
+/* MatrixFuncUtils.hpp */
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <initializer_list>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../Complex.hpp"
+#include "Gemm.hpp"
+#include "Parallel.hpp"
+
+
+namespace numxx::util {
+
+    // Elements per thread below which a sum of matrices is not split further
+    constexpr size_t matrix_terms_grain = 1 << 15;
+
+
+    /* Computes base^power (power >= 1) of an n x n row-major matrix by binary exponentiation: base is squared
+     * once per bit of power, and multiplied into the result for every set bit. Each product goes through gemm
+     * into whichever of the three n x n buffers is free, and the buffers then swap roles, so nothing is
+     * allocated. `base` is overwritten. Returns the buffer that holds the result (one of the three). */
+    template <typename T>
+    T* matrix_power_buffers(const size_t n, unsigned long long power, T* base, T* result, T* work) {
+        bool has_result = false;
+        while (true) {
+            if (power & 1) {
+                if (!has_result) {
+                    std::copy(base, base + n * n, result);
+                    has_result = true;
+                } else {
+                    gemm(n, n, n, T(1), result, n, base, n, T(0), work, n);
+                    std::swap(result, work);
+                }
+            }
+            power >>= 1;
+            if (power == 0) return result;
+            gemm(n, n, n, T(1), base, n, base, n, T(0), work, n);
+            std::swap(base, work);
+        }
+    }
+
+
+    // Writes out = c * I + sum of coef * M over the (coef, M) terms, for n x n row-major matrices
+    template <typename T>
+    void add_matrix_terms(const size_t n, T* out, const T c, std::initializer_list<std::pair<T, const T*>> terms) {
+        parallel_for(n, std::max<size_t>(1, matrix_terms_grain / std::max<size_t>(1, n)),
+            [&] (const size_t begin, const size_t end, size_t) {
+                for (size_t i = begin; i < end; i++) {
+                    T* row = out + i * n;
+                    auto term = terms.begin();
+                    for (size_t j = 0; j < n; j++) row[j] = term->first * term->second[i * n + j];
+                    for (++term; term != terms.end(); ++term)
+                        for (size_t j = 0; j < n; j++) row[j] += term->first * term->second[i * n + j];
+                    row[i] += c;
+                }
+            }
+        );
+    }
+
+
+    // Returns the 1-norm (the largest absolute column sum) of an n x n row-major matrix
+    template <typename T>
+    underlying_type_t<T> matrix_norm1(const size_t n, const T* a) {
+        using Real = underlying_type_t<T>;
+        std::vector<Real> column_sums(n, Real(0));
+        for (size_t i = 0; i < n; i++)
+            for (size_t j = 0; j < n; j++) column_sums[j] += static_cast<Real>(numxx::abs(a[i * n + j]));
+        return n ? *std::max_element(column_sums.begin(), column_sums.end()) : Real(0);
+    }
+
+
+    // The coefficients b_0 ... b_m of the [m/m] Padé approximant of exp, p(x) = sum of b_k * x^k, scaled to integers
+    inline const double* get_pade_coefficients(const size_t m) {
+        static constexpr double b3[] = {120., 60., 12., 1.};
+        static constexpr double b5[] = {30240., 15120., 3360., 420., 30., 1.};
+        static constexpr double b7[] = {17297280., 8648640., 1995840., 277200., 25200., 1512., 56., 1.};
+        static constexpr double b9[] = {17643225600., 8821612800., 2075673600., 302702400., 30270240., 2162160.,
+                                        110880., 3960., 90., 1.};
+        static constexpr double b13[] = {64764752532480000., 32382376266240000., 7771770303897600.,
+                                         1187353796428800., 129060195264000., 10559470521600., 670442572800.,
+                                         33522128640., 1323241920., 40840800., 960960., 16380., 182., 1.};
+        switch (m) {
+            case 3: return b3;
+            case 5: return b5;
+            case 7: return b7;
+            case 9: return b9;
+            default: return b13;
+        }
+    }
+
+
+    // The Padé degrees expm chooses from, in increasing order
+    inline constexpr size_t pade_degrees[] = {3, 5, 7, 9, 13};
+
+    // How many of pade_degrees expm uses for elements of real type Real (single precision needs no more than 7)
+    template <typename Real>
+    inline constexpr size_t pade_degree_count_v = std::is_same_v<Real, float> ? 3 : 5;
+
+
+    /* Returns the largest 1-norm of A for which the approximant of degree pade_degrees[index] matches exp(A) to
+     * the unit roundoff of Real, from Higham, "The Scaling and Squaring Method for the Matrix Exponential
+     * Revisited" (2005) */
+    template <typename Real>
+    double get_pade_theta(const size_t index) {
+        static constexpr double theta_double[] = {1.495585217958292e-2, 2.539398330063230e-1, 9.504178996162932e-1,
+                                                  2.097847961257068e0, 5.371920351148152e0};
+        static constexpr double theta_float[] = {4.258730016922831e-1, 1.880152677804762e0, 3.925724783138660e0};
+        return std::is_same_v<Real, float> ? theta_float[index] : theta_double[index];
+    }
+
+
+    /* Evaluates the numerator and denominator terms of the [m/m] Padé approximant of exp at the n x n matrix A,
+     * which is r(A) = (V - U)^-1 * (V + U) with U holding the odd powers of A and V the even ones. The powers
+     * A^2, A^4, ... go into `powers` (up to four n x n matrices), and `work` is one more n x n buffer. Degree 13
+     * follows Higham's scheme, which needs only A^2, A^4 and A^6. */
+    template <typename T>
+    void get_pade_terms(const size_t n, const size_t m, const T* a, T* powers, T* u, T* v, T* work) {
+        using Real = underlying_type_t<T>;
+        const double* b = get_pade_coefficients(m);
+        auto coef = [b] (const size_t k) { return T(static_cast<Real>(b[k])); };
+        const size_t nn = n * n;
+        T *a2 = powers, *a4 = powers + nn, *a6 = powers + 2 * nn, *a8 = powers + 3 * nn;
+
+        gemm(n, n, n, T(1), a, n, a, n, T(0), a2, n);
+        if (m >= 5) gemm(n, n, n, T(1), a2, n, a2, n, T(0), a4, n);
+        if (m >= 7) gemm(n, n, n, T(1), a4, n, a2, n, T(0), a6, n);
+
+        // `work` gathers the odd part without its factor A, so that U = A * work
+        switch (m) {
+            case 3:
+                add_matrix_terms(n, work, coef(1), {{coef(3), a2}});
+                add_matrix_terms(n, v, coef(0), {{coef(2), a2}});
+                break;
+            case 5:
+                add_matrix_terms(n, work, coef(1), {{coef(5), a4}, {coef(3), a2}});
+                add_matrix_terms(n, v, coef(0), {{coef(4), a4}, {coef(2), a2}});
+                break;
+            case 7:
+                add_matrix_terms(n, work, coef(1), {{coef(7), a6}, {coef(5), a4}, {coef(3), a2}});
+                add_matrix_terms(n, v, coef(0), {{coef(6), a6}, {coef(4), a4}, {coef(2), a2}});
+                break;
+            case 9:
+                gemm(n, n, n, T(1), a6, n, a2, n, T(0), a8, n);
+                add_matrix_terms(n, work, coef(1), {{coef(9), a8}, {coef(7), a6}, {coef(5), a4}, {coef(3), a2}});
+                add_matrix_terms(n, v, coef(0), {{coef(8), a8}, {coef(6), a6}, {coef(4), a4}, {coef(2), a2}});
+                break;
+            default:
+                // work = A6 * (b13 A6 + b11 A4 + b9 A2) + b7 A6 + b5 A4 + b3 A2 + b1 I, and likewise for V,
+                // with the inner sum built in `u` before U itself is needed
+                add_matrix_terms(n, u, T(0), {{coef(13), a6}, {coef(11), a4}, {coef(9), a2}});
+                add_matrix_terms(n, work, coef(1), {{coef(7), a6}, {coef(5), a4}, {coef(3), a2}});
+                gemm(n, n, n, T(1), a6, n, u, n, T(1), work, n);
+                add_matrix_terms(n, u, T(0), {{coef(12), a6}, {coef(10), a4}, {coef(8), a2}});
+                add_matrix_terms(n, v, coef(0), {{coef(6), a6}, {coef(4), a4}, {coef(2), a2}});
+                gemm(n, n, n, T(1), a6, n, u, n, T(1), v, n);
+                break;
+        }
+        gemm(n, n, n, T(1), a, n, work, n, T(0), u, n);
+    }
+
+} // namespace numxx::util
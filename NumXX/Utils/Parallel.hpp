@@ -0,0 +1,181 @@
+/* Parallel.hpp */
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace numxx {
+
+inline size_t num_threads = std::max(1u, std::thread::hardware_concurrency());
+
+
+// Sets the number of threads used by the parallel kernels (0 resets to the hardware default)
+inline void set_num_threads(const size_t n) {
+    num_threads = n ? n : std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Returns the number of threads used by the parallel kernels
+inline size_t get_num_threads() { return num_threads; }
+
+
+namespace util {
+
+// Set while a thread is running a chunk, so nested parallel loops run serially instead of oversubscribing
+inline thread_local bool in_parallel_region = false;
+
+
+// Returns the number of chunks `parallel_for` splits `n` items into, given that a chunk holds at least `grain` items
+inline size_t get_num_chunks(const size_t n, const size_t grain) {
+    const size_t max_chunks = std::max<size_t>(1, n / std::max<size_t>(1, grain));
+    return std::min(max_chunks, num_threads);
+}
+
+
+// Returns the first item of chunk `c` out of `n_chunks` over `n` items
+inline size_t get_chunk_begin(const size_t n, const size_t n_chunks, const size_t c) {
+    return n / n_chunks * c + std::min(c, n % n_chunks);
+}
+
+
+/* Persistent worker threads shared by every parallel loop, so that a loop costs a wake-up rather than a
+ * thread creation. Workers are started on demand, up to the largest number of chunks any loop has needed,
+ * and live until the program exits. One loop runs on the pool at a time; the thread that submits it claims
+ * chunks alongside the workers, and chunks are handed out dynamically through an atomic counter. */
+class ThreadPool {
+    // A loop being run: calls invoke(context, c) for every chunk c < n_chunks
+    struct Job {
+        void (*invoke)(void*, size_t);
+        void* context;
+        size_t n_chunks;
+        std::atomic<size_t> next{0};
+        size_t remaining;   // chunks not finished yet, guarded by _mutex
+        size_t active = 0;  // workers holding a pointer to the job, guarded by _mutex
+    };
+
+    std::mutex _submit;     // serialises loops submitted from different threads
+    std::mutex _mutex;
+    std::condition_variable _wake, _done;
+    std::vector<std::thread> _workers;
+    Job* _job = nullptr;
+    size_t _generation = 0;
+    bool _stop = false;
+
+    // Runs chunks of `job` until none are left, returning how many this thread ran
+    static size_t run_chunks(Job& job) {
+        size_t finished = 0;
+        for (size_t c = job.next.fetch_add(1); c < job.n_chunks; c = job.next.fetch_add(1)) {
+            job.invoke(job.context, c);
+            finished++;
+        }
+        return finished;
+    }
+
+    void worker_loop() {
+        in_parallel_region = true;
+        size_t seen = 0;
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (true) {
+            _wake.wait(lock, [&] { return _stop || _generation != seen; });
+            if (_stop) return;
+            seen = _generation;
+            Job* job = _job;
+            if (!job) continue;
+
+            job->active++;
+            lock.unlock();
+            const size_t finished = run_chunks(*job);
+            lock.lock();
+            job->active--;
+            job->remaining -= finished;
+            if (job->remaining == 0 && job->active == 0) _done.notify_all();
+        }
+    }
+
+public:
+    ThreadPool() = default;
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _wake.notify_all();
+        for (auto& worker : _workers) worker.join();
+    }
+
+    // Calls func(c) for every c < n_chunks across the workers and the calling thread, returning once all are done
+    template <typename Func>
+    void run(const size_t n_chunks, Func& func) {
+        std::lock_guard<std::mutex> submit(_submit);
+        while (_workers.size() + 1 < n_chunks) _workers.emplace_back([this] { worker_loop(); });
+
+        Job job;
+        job.invoke = [] (void* context, const size_t c) { (*static_cast<Func*>(context))(c); };
+        job.context = &func;
+        job.n_chunks = n_chunks;
+        job.remaining = n_chunks;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _job = &job;
+            _generation++;
+        }
+        _wake.notify_all();
+
+        const bool was_parallel = in_parallel_region;
+        in_parallel_region = true;
+        const size_t finished = run_chunks(job);
+        in_parallel_region = was_parallel;
+
+        // Wait until every chunk is done and no worker still refers to the job, which lives on this stack
+        std::unique_lock<std::mutex> lock(_mutex);
+        job.remaining -= finished;
+        _done.wait(lock, [&] { return job.remaining == 0 && job.active == 0; });
+        _job = nullptr;
+    }
+};
+
+
+// Returns the pool behind parallel_for, created on first use
+inline ThreadPool& get_thread_pool() {
+    static ThreadPool pool;
+    return pool;
+}
+
+
+/* Splits [0, n) into `get_num_chunks(n, grain)` contiguous chunks and calls `func(begin, end, chunk)` for each.
+ * The chunks run on the shared thread pool, with the calling thread taking part, unless there is only one,
+ * or this is already inside a parallel region. The first exception thrown by any chunk is rethrown. */
+template <typename Func>
+void parallel_for(const size_t n, const size_t grain, Func func) {
+    const size_t n_chunks = get_num_chunks(n, grain);
+
+    if (n_chunks == 1 || in_parallel_region) {
+        for (size_t c = 0; c < n_chunks; c++)
+            func(get_chunk_begin(n, n_chunks, c), get_chunk_begin(n, n_chunks, c + 1), c);
+        return;
+    }
+
+    std::vector<std::exception_ptr> errors(n_chunks);
+    auto run_chunk = [&] (const size_t c) {
+        try {
+            func(get_chunk_begin(n, n_chunks, c), get_chunk_begin(n, n_chunks, c + 1), c);
+        } catch (...) {
+            errors[c] = std::current_exception();
+        }
+    };
+    get_thread_pool().run(n_chunks, run_chunk);
+
+    for (const auto& error : errors)
+        if (error) std::rethrow_exception(error);
+}
+
+} // namespace util
+} // namespace numxx
@@ -0,0 +1,247 @@
+/* ReduceUtils.hpp */
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "../Core/NArray.hpp"
+
+
+namespace numxx::util {
+
+// Returns a (possibly negative) axis as an index into the dimensions, throwing if it is out of bounds
+inline size_t normalize_axis(const int axis, const size_t ndim) {
+    const auto n = static_cast<int>(ndim);
+    if (axis < -n || axis >= n) {
+        throw error::ValueError("Axis " + toString(axis) + " is out of bounds for an array with "
+            + toString(n) + " dimensions.");
+    }
+    return static_cast<size_t>(axis < 0 ? axis + n : axis);
+}
+
+
+// Returns the number of elements before (outer) and after (inner) `axis` in row-major order,
+// so the array can be viewed as (outer, shape[axis], inner)
+inline std::pair<size_t, size_t> get_outer_inner(const Shape& shape, const size_t axis) {
+    size_t outer = 1, inner = 1;
+    for (size_t d = 0; d < axis; d++) outer *= shape[d];
+    for (size_t d = axis + 1; d < shape.get_Ndim(); d++) inner *= shape[d];
+    return {outer, inner};
+}
+
+
+// Converts a list of (possibly negative) axes into a mask of the dimensions being reduced
+inline std::vector<bool> get_axes_mask(const Shape& shape, const std::vector<int>& axes) {
+    const auto ndim = static_cast<int>(shape.get_Ndim());
+    std::vector<bool> mask(ndim, false);
+
+    for (const int a : axes) {
+        const size_t axis = normalize_axis(a, ndim);
+        if (mask[axis]) {
+            throw error::ValueError("Axis " + toString(axis) + " appears more than once.");
+        }
+        mask[axis] = true;
+    }
+    return mask;
+}
+
+
+// Returns a mask where every dimension of the shape is reduced
+inline std::vector<bool> get_full_mask(const Shape& shape) {
+    return std::vector<bool>(shape.get_Ndim(), true);
+}
+
+
+// Returns the shape left after reducing the masked dimensions
+inline Shape get_reduced_shape(const Shape& shape, const std::vector<bool>& mask, const bool keepdims) {
+    std::vector<size_t> dims;
+    for (size_t d = 0; d < shape.get_Ndim(); d++) {
+        if (!mask[d]) dims.push_back(shape[d]);
+        else if (keepdims) dims.push_back(1);
+    }
+    // A full reduction still yields a single element
+    if (dims.empty()) dims.push_back(1);
+    return Shape(std::move(dims));
+}
+
+
+// Returns the number of elements that get folded into each output element
+inline size_t get_reduction_size(const Shape& shape, const std::vector<bool>& mask) {
+    size_t size = 1;
+    for (size_t d = 0; d < shape.get_Ndim(); d++)
+        if (mask[d]) size *= shape[d];
+    return size;
+}
+
+
+/* Walks an array of the given shape in memory order, one contiguous run at a time.
+ * Adjacent dimensions that are both reduced (or both kept) are merged first, so the run is
+ * always the longest stretch of memory that can be handled by a single tight loop.
+ * For every run `func(in_offset, out_offset, reduce_offset, length, inner_reduced)` is called, where:
+ *  - in_offset is the flat offset of the run in the input
+ *  - out_offset is the flat offset of the (first) output element the run maps to
+ *  - reduce_offset is the flat index of the run inside the reduced dimensions, which is also
+ *    the number of elements each output has already received (outputs are visited in order)
+ *  - inner_reduced tells whether the run is folded into one output (true) or is mapped
+ *    element-by-element onto `length` consecutive outputs (false)
+ */
+template <typename Func>
+void for_each_reduce_run(const Shape& shape, const std::vector<bool>& mask, Func func) {
+    if (shape.get_total_size() == 0) return;
+
+    // Merge neighbouring dimensions with the same role, dropping unit dimensions
+    std::vector<size_t> dims;
+    std::vector<bool> reduced;
+    for (size_t d = 0; d < shape.get_Ndim(); d++) {
+        if (shape[d] == 1) continue;
+        if (!dims.empty() && reduced.back() == mask[d]) {
+            dims.back() *= shape[d];
+        } else {
+            dims.push_back(shape[d]);
+            reduced.push_back(mask[d]);
+        }
+    }
+    if (dims.empty()) {
+        func(0, 0, 0, 1, false);
+        return;
+    }
+
+    // Strides of every merged dimension in the input, the output and the reduced index space
+    const size_t ndim = dims.size();
+    std::vector<size_t> in_strides(ndim), out_strides(ndim, 0), red_strides(ndim, 0);
+    size_t in_stride = 1, out_stride = 1, red_stride = 1;
+    for (size_t d = ndim; d-- > 0;) {
+        in_strides[d] = in_stride;
+        in_stride *= dims[d];
+        if (reduced[d]) {
+            red_strides[d] = red_stride;
+            red_stride *= dims[d];
+        } else {
+            out_strides[d] = out_stride;
+            out_stride *= dims[d];
+        }
+    }
+
+    const size_t run = dims[ndim - 1];
+    const bool inner_reduced = reduced[ndim - 1];
+    const size_t n_runs = shape.get_total_size() / run;
+
+    // Odometer over every dimension except the innermost
+    std::vector<size_t> coords(ndim, 0);
+    size_t in_off = 0, out_off = 0, red_off = 0;
+
+    for (size_t r = 0; r < n_runs; r++) {
+        func(in_off, out_off, red_off, run, inner_reduced);
+        in_off += run;
+
+        for (size_t d = ndim - 1; d-- > 0;) {
+            if (++coords[d] < dims[d]) {
+                out_off += out_strides[d];
+                red_off += red_strides[d];
+                break;
+            }
+            coords[d] = 0;
+            out_off -= (dims[d] - 1) * out_strides[d];
+            red_off -= (dims[d] - 1) * red_strides[d];
+        }
+    }
+}
+
+
+// Folds a contiguous run into a single value using four independent accumulators
+template <typename T, typename Op>
+T fold_contiguous(const T* data, const size_t len, Op op) {
+    if (len < 8) {
+        T acc = data[0];
+        for (size_t i = 1; i < len; i++) acc = op(acc, data[i]);
+        return acc;
+    }
+
+    T a0 = data[0], a1 = data[1], a2 = data[2], a3 = data[3];
+    size_t i = 4;
+    for (; i + 4 <= len; i += 4) {
+        a0 = op(a0, data[i]);
+        a1 = op(a1, data[i + 1]);
+        a2 = op(a2, data[i + 2]);
+        a3 = op(a3, data[i + 3]);
+    }
+    for (; i < len; i++) a0 = op(a0, data[i]);
+    return op(op(a0, a1), op(a2, a3));
+}
+
+
+// Reduces the masked dimensions of `in` into `out` using `op`
+// If `has_initial` is false, every output is seeded with its first element instead of `out`'s contents
+template <typename T, typename Op>
+void reduce_into(
+    const T* in, const Shape& shape, const std::vector<bool>& mask,
+    T* out, Op op, const bool has_initial
+) {
+    for_each_reduce_run(shape, mask,
+        [&] (size_t in_off, size_t out_off, size_t red_off, size_t len, bool inner_reduced) {
+            const T* src = in + in_off;
+            T* dst = out + out_off;
+            const bool first = !has_initial && red_off == 0;
+
+            if (inner_reduced) {
+                const T folded = fold_contiguous(src, len, op);
+                *dst = first ? folded : op(*dst, folded);
+            } else if (first) {
+                for (size_t j = 0; j < len; j++) dst[j] = src[j];
+            } else {
+                for (size_t j = 0; j < len; j++) dst[j] = op(dst[j], src[j]);
+            }
+        }
+    );
+}
+
+
+// Reduces the masked dimensions of an NArray into a new NArray
+template <typename T, typename Op>
+NArray<T> reduce_array(
+    const NArray<T>& arr, const std::vector<bool>& mask, Op op,
+    const bool keepdims, const T* initial = nullptr
+) {
+    const Shape& shape = arr.get_shape();
+    Shape out_shape = get_reduced_shape(shape, mask, keepdims);
+    if (initial == nullptr && get_reduction_size(shape, mask) == 0 && out_shape.get_total_size() != 0) {
+        throw error::ValueError("Zero-size reduction with no initial value.");
+    }
+
+    NArray<T> out = initial
+        ? NArray<T>(std::move(out_shape), *initial)
+        : NArray<T>(std::move(out_shape));
+
+    reduce_into(arr.get_data(), shape, mask, out.get_data(), op, initial != nullptr);
+    return out;
+}
+
+
+// Tests the masked dimensions for non-zero elements
+// With `is_all` set, every element must be non-zero, otherwise a single one is enough
+template <typename T>
+NArray<bool> reduce_predicate(const NArray<T>& arr, const std::vector<bool>& mask, const bool keepdims, const bool is_all) {
+    NArray<bool> out(get_reduced_shape(arr.get_shape(), mask, keepdims), is_all);
+    const T* in = arr.get_data();
+    bool* res = out.get_data();
+
+    for_each_reduce_run(arr.get_shape(), mask,
+        [&] (size_t in_off, size_t out_off, size_t, size_t len, bool inner_reduced) {
+            const T* src = in + in_off;
+            bool* dst = res + out_off;
+
+            if (inner_reduced) {
+                bool acc = *dst;
+                for (size_t j = 0; j < len && acc == is_all; j++) acc = (src[j] != T());
+                *dst = acc;
+            } else if (is_all) {
+                for (size_t j = 0; j < len; j++) dst[j] = dst[j] && (src[j] != T());
+            } else {
+                for (size_t j = 0; j < len; j++) dst[j] = dst[j] || (src[j] != T());
+            }
+        }
+    );
+    return out;
+}
+
+} // namespace numxx::util
@@ -0,0 +1,88 @@
+/* ScanUtils.hpp */
+#pragma once
+
+#include <vector>
+
+#include "Parallel.hpp"
+#include "ReduceUtils.hpp"
+
+
+namespace numxx::util {
+
+// Inclusive scan of a contiguous run, continuing from `carry` unless this is the start of the scan
+template <typename T, typename Op>
+void scan_contiguous(const T* in, T* out, const size_t len, Op op, const T* carry = nullptr) {
+    if (len == 0) return;
+    T acc = carry ? op(*carry, in[0]) : in[0];
+    out[0] = acc;
+    for (size_t i = 1; i < len; i++) {
+        acc = op(acc, in[i]);
+        out[i] = acc;
+    }
+}
+
+
+/* Inclusive scan of a contiguous array using a blocked parallel scan (reduce-then-scan):
+ *  1. every thread reduces its own block to a single total
+ *  2. the block totals are scanned serially to get the offset each block starts from
+ *  3. every thread scans its own block starting from its offset
+ * `op` must be associative. */
+template <typename T, typename Op>
+void parallel_scan(const T* in, T* out, const size_t len, Op op) {
+    constexpr size_t grain = 1 << 16;
+    const size_t n_chunks = get_num_chunks(len, grain);
+
+    if (n_chunks == 1 || in_parallel_region) {
+        scan_contiguous(in, out, len, op);
+        return;
+    }
+
+    std::vector<T> totals(n_chunks);
+    parallel_for(len, grain, [&] (const size_t begin, const size_t end, const size_t c) {
+        if (c + 1 < n_chunks) totals[c] = fold_contiguous(in + begin, end - begin, op);
+    });
+
+    // Exclusive scan of the totals: offset c is the combination of every block before c
+    for (size_t c = 1; c + 1 < n_chunks; c++)
+        totals[c] = op(totals[c - 1], totals[c]);
+
+    parallel_for(len, grain, [&] (const size_t begin, const size_t end, const size_t c) {
+        scan_contiguous(in + begin, out + begin, end - begin, op, c ? &totals[c - 1] : nullptr);
+    });
+}
+
+
+/* Inclusive scan along one axis of an array viewed as (outer, axis_len, inner).
+ * Every lane (o, k) is independent, so the lanes are split across threads. When inner > 1 each step
+ * combines a whole contiguous row of lanes at once, which the compiler can vectorise. */
+template <typename T, typename Op>
+void scan_axis(
+    const T* in, T* out, const size_t outer, const size_t axis_len, const size_t inner, Op op
+) {
+    const size_t lanes = outer * inner;
+    if (axis_len == 0 || lanes == 0) return;
+    const size_t grain = std::max<size_t>(1, (1 << 15) / axis_len);
+
+    parallel_for(lanes, grain, [&] (const size_t begin, const size_t end, size_t) {
+        for (size_t o = begin / inner; o * inner < end; o++) {
+            const size_t k0 = std::max(begin, o * inner) - o * inner;
+            const size_t k1 = std::min(end, (o + 1) * inner) - o * inner;
+            const size_t base = o * axis_len * inner;
+
+            if (inner == 1) {
+                scan_contiguous(in + base, out + base, axis_len, op);
+                continue;
+            }
+
+            for (size_t k = k0; k < k1; k++) out[base + k] = in[base + k];
+            for (size_t i = 1; i < axis_len; i++) {
+                const T* prev = out + base + (i - 1) * inner;
+                const T* src = in + base + i * inner;
+                T* dst = out + base + i * inner;
+                for (size_t k = k0; k < k1; k++) dst[k] = op(prev[k], src[k]);
+            }
+        }
+    });
+}
+
+} // namespace numxx::util
@@ -0,0 +1,215 @@
+/* SelectUtils.hpp */
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "Errors.hpp"
+#include "Parallel.hpp"
+#include "SortUtils.hpp"
+
+
+namespace numxx::util {
+
+// Returns the offset of the first element of lane l = o * inner + k in an array viewed as (outer, axis_len, inner)
+inline size_t get_lane_offset(const size_t l, const size_t axis_len, const size_t inner) {
+    return l / inner * axis_len * inner + l % inner;
+}
+
+
+/* Calls `func(lane, idx, l)` for every lane l of an array viewed as (outer, axis_len, inner) along the
+ * middle axis. `lane` is a contiguous copy of the lane that `func` may reorder, and `idx` is scratch space
+ * for `axis_len` indices. Lanes are split across threads. */
+template <typename T, typename Func>
+void for_each_lane(const T* in, const size_t outer, const size_t axis_len, const size_t inner, Func func) {
+    const size_t lanes = outer * inner;
+    parallel_for(lanes, std::max<size_t>(1, (1 << 16) / std::max<size_t>(1, axis_len)),
+        [&] (const size_t begin, const size_t end, size_t) {
+            std::vector<T> lane(axis_len);
+            std::vector<size_t> idx(axis_len);
+            for (size_t l = begin; l < end; l++) {
+                const T* src = in + get_lane_offset(l, axis_len, inner);
+                for (size_t i = 0; i < axis_len; i++) lane[i] = src[i * inner];
+                func(lane.data(), idx.data(), l);
+            }
+        }
+    );
+}
+
+
+// Returns the partition positions sorted and without repeats, throwing if one is outside a lane of `axis_len`
+inline std::vector<size_t> get_kth_positions(std::vector<size_t> kth, const size_t axis_len) {
+    std::sort(kth.begin(), kth.end());
+    kth.erase(std::unique(kth.begin(), kth.end()), kth.end());
+    if (!kth.empty() && kth.back() >= axis_len) {
+        throw error::ValueError("kth(=" + toString(kth.back()) + ") out of bounds for an axis of length "
+            + toString(axis_len) + ".");
+    }
+    return kth;
+}
+
+
+/* Reorders a contiguous run so that every position in `kth` (sorted and unique) holds the element that
+ * would be there if the run were sorted, with no greater element before it and no smaller one after it.
+ * Each position is found with std::nth_element (introselect) over the part right of the previous one. */
+template <typename Item, typename Compare>
+void select_positions(Item* data, const size_t n, const std::vector<size_t>& kth, Compare less) {
+    size_t start = 0;
+    for (const size_t k : kth) {
+        std::nth_element(data + start, data + k, data + n, less);
+        start = k + 1;
+    }
+}
+
+
+// Partitions every lane of an array viewed as (outer, axis_len, inner) around the positions in `kth`
+template <typename T>
+void partition_axis(
+    const T* in, T* out, const size_t outer, const size_t axis_len, const size_t inner, const std::vector<size_t>& kth
+) {
+    for_each_lane(in, outer, axis_len, inner, [&] (T* lane, size_t*, const size_t l) {
+        select_positions(lane, axis_len, kth, [] (const T& a, const T& b) { return sort_less(a, b); });
+        T* dst = out + get_lane_offset(l, axis_len, inner);
+        for (size_t i = 0; i < axis_len; i++) dst[i * inner] = lane[i];
+    });
+}
+
+
+// Writes the indices that partition every lane of an array viewed as (outer, axis_len, inner) around `kth`
+template <typename T>
+void argpartition_axis(
+    const T* in, size_t* out, const size_t outer, const size_t axis_len, const size_t inner,
+    const std::vector<size_t>& kth
+) {
+    for_each_lane(in, outer, axis_len, inner, [&] (T* lane, size_t* idx, const size_t l) {
+        for (size_t i = 0; i < axis_len; i++) idx[i] = i;
+        select_positions(idx, axis_len, kth,
+            [lane] (const size_t a, const size_t b) { return sort_less(lane[a], lane[b]); });
+        size_t* dst = out + get_lane_offset(l, axis_len, inner);
+        for (size_t i = 0; i < axis_len; i++) dst[i * inner] = idx[i];
+    });
+}
+
+
+/* Finds the k best elements of a contiguous run (largest or smallest, NaNs counting as the largest),
+ * writing their indices best first into `idx`, which must hold `n` indices. Ties go to the lower index.
+ * For small k a bounded heap of the k best so far is kept, and elements that do not beat the worst of
+ * them (most of them, for random data) are rejected with a single comparison. Otherwise the k best are
+ * selected with introselect and then sorted. */
+template <typename T>
+void topk_contiguous(const T* data, const size_t n, const size_t k, const bool largest, size_t* idx) {
+    if (k == 0) return;
+    auto better = [data, largest] (const size_t a, const size_t b) {
+        if (sort_less(data[a], data[b])) return !largest;
+        if (sort_less(data[b], data[a])) return largest;
+        return a < b;
+    };
+
+    if (k * 16 <= n) {
+        // A heap under `better` keeps its worst element at the front
+        for (size_t i = 0; i < k; i++) idx[i] = i;
+        std::make_heap(idx, idx + k, better);
+        for (size_t i = k; i < n; i++) {
+            if (!better(i, idx[0])) continue;
+            std::pop_heap(idx, idx + k, better);
+            idx[k - 1] = i;
+            std::push_heap(idx, idx + k, better);
+        }
+        std::sort_heap(idx, idx + k, better);
+        return;
+    }
+
+    for (size_t i = 0; i < n; i++) idx[i] = i;
+    std::nth_element(idx, idx + (k - 1), idx + n, better);
+    std::sort(idx, idx + k, better);
+}
+
+
+// Finds the k best elements along the middle axis of an array viewed as (outer, axis_len, inner)
+// The outputs are viewed as (outer, k, inner)
+template <typename T>
+void topk_axis(
+    const T* in, T* values, size_t* indices, const size_t outer, const size_t axis_len, const size_t inner,
+    const size_t k, const bool largest
+) {
+    for_each_lane(in, outer, axis_len, inner, [&] (T* lane, size_t* idx, const size_t l) {
+        topk_contiguous(lane, axis_len, k, largest, idx);
+        const size_t offset = get_lane_offset(l, k, inner);
+        for (size_t i = 0; i < k; i++) {
+            values[offset + i * inner] = lane[idx[i]];
+            indices[offset + i * inner] = idx[i];
+        }
+    });
+}
+
+
+/* Computes the quantiles `qs` (each in [0, 1]) of a contiguous run that may be reordered, with linear
+ * interpolation between the two closest ranks, writing quantile i to results[i * stride].
+ * The ranks are selected in increasing order, each with introselect over the part right of the previous
+ * one; the upper neighbour of a rank is the minimum of the part right of it. A run holding a NaN gives NaN. */
+template <typename R, typename T>
+void quantiles_contiguous(T* data, const size_t n, const std::vector<double>& qs, R* results, const size_t stride) {
+    const auto less = [] (const T& a, const T& b) { return sort_less(a, b); };
+    const bool has_nan = std::any_of(data, data + n, [] (const T& x) { return is_nan(x); });
+    if (n == 0 || has_nan) {
+        for (size_t i = 0; i < qs.size(); i++) results[i * stride] = std::numeric_limits<R>::quiet_NaN();
+        return;
+    }
+
+    std::vector<size_t> order(qs.size());
+    for (size_t i = 0; i < order.size(); i++) order[i] = i;
+    std::sort(order.begin(), order.end(), [&qs] (const size_t a, const size_t b) { return qs[a] < qs[b]; });
+
+    size_t start = 0;
+    for (const size_t i : order) {
+        const double pos = qs[i] * static_cast<double>(n - 1);
+        const auto lo = std::min(static_cast<size_t>(std::floor(pos)), n - 1);
+        std::nth_element(data + start, data + lo, data + n, less);
+        start = lo;
+
+        const R lo_value = static_cast<R>(data[lo]);
+        const R frac = static_cast<R>(pos - static_cast<double>(lo));
+        if (frac == R(0) || lo + 1 == n) {
+            results[i * stride] = lo_value;
+            continue;
+        }
+        const R hi_value = static_cast<R>(*std::min_element(data + lo + 1, data + n, less));
+        results[i * stride] = lo_value + (hi_value - lo_value) * frac;
+    }
+}
+
+
+// Computes the quantiles `qs` along the middle axis of an array viewed as (outer, axis_len, inner)
+// The output is viewed as (qs.size(), outer * inner)
+template <typename R, typename T>
+void quantile_axis(
+    const T* in, R* out, const size_t outer, const size_t axis_len, const size_t inner, const std::vector<double>& qs
+) {
+    const size_t lanes = outer * inner;
+    for_each_lane(in, outer, axis_len, inner, [&] (T* lane, size_t*, const size_t l) {
+        quantiles_contiguous(lane, axis_len, qs, out + l, lanes);
+    });
+}
+
+
+// Throws if a quantile lies outside [0, 1]
+inline void check_quantiles(const std::vector<double>& qs) {
+    for (const double q : qs) {
+        if (!(q >= 0.0 && q <= 1.0))
+            throw error::ValueError("Quantiles must be in the range [0, 1], got " + toString(q) + ".");
+    }
+}
+
+// Scales percentiles in [0, 100] to quantiles in [0, 1]
+inline std::vector<double> percentiles_to_quantiles(std::vector<double> ps) {
+    for (auto& p : ps) {
+        if (!(p >= 0.0 && p <= 100.0))
+            throw error::ValueError("Percentiles must be in the range [0, 100], got " + toString(p) + ".");
+        p /= 100.0;
+    }
+    return ps;
+}
+
+} // namespace numxx::util
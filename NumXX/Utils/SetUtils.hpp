@@ -0,0 +1,194 @@
+/* SetUtils.hpp */
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Parallel.hpp"
+#include "SortUtils.hpp"
+
+
+namespace numxx::util {
+
+/* Strict weak order used by the set routines. Real values follow sort_less. Complex values are ordered by
+ * squared magnitude, then real part, then imaginary part, so that distinct values of the same magnitude (such
+ * as 1, -1 and 1j) stay apart. NaNs come last. */
+template <typename T>
+bool set_less(const T& a, const T& b) {
+    if constexpr (is_complex_v<T>) {
+        const auto key_a = order_key(a), key_b = order_key(b);
+        if (is_nan(key_a) || is_nan(key_b)) return is_nan(key_b) && !is_nan(key_a);
+        if (key_a != key_b) return key_a < key_b;
+        if (a.real() != b.real()) return a.real() < b.real();
+        return a.imag() < b.imag();
+    } else {
+        return sort_less(a, b);
+    }
+}
+
+
+// Equality used by the set routines: exact ==, except that all NaNs are equal to each other
+template <typename T>
+bool set_equal(const T& a, const T& b) {
+    const bool nan_a = is_nan(order_key(a)), nan_b = is_nan(order_key(b));
+    if (nan_a || nan_b) return nan_a && nan_b;
+    return a == b;
+}
+
+
+// Returns a copy of a contiguous run, sorted under set_less
+template <typename T>
+std::vector<T> get_sorted_copy(const T* data, const size_t n) {
+    std::vector<T> out(data, data + n), buf(n);
+    if constexpr (is_complex_v<T>)
+        parallel_merge_sort(out.data(), buf.data(), n, [] (const T& a, const T& b) { return set_less(a, b); }, false);
+    else
+        sort_contiguous(out.data(), buf.data(), n, false);
+    return out;
+}
+
+
+// Writes the indices that stably sort a contiguous run under set_less into `idx`
+template <typename T>
+void set_argsort(const T* data, size_t* idx, const size_t n) {
+    if constexpr (is_complex_v<T>) {
+        std::vector<size_t> buf(n);
+        for (size_t i = 0; i < n; i++) idx[i] = i;
+        parallel_merge_sort(idx, buf.data(), n,
+            [data] (const size_t a, const size_t b) { return set_less(data[a], data[b]); }, true);
+    } else {
+        ArgsortBuffer<T> scratch(n);
+        argsort_contiguous(data, idx, n, scratch, true);
+    }
+}
+
+
+// Returns the distinct values of a contiguous run, sorted
+template <typename T>
+std::vector<T> get_sorted_unique(const T* data, const size_t n) {
+    std::vector<T> out = get_sorted_copy(data, n);
+    out.erase(std::unique(out.begin(), out.end(), set_equal<T>), out.end());
+    return out;
+}
+
+
+// Returns true if a contiguous run is sorted under set_less
+template <typename T>
+bool is_sorted_run(const T* data, const size_t n) {
+    return std::is_sorted(data, data + n, [] (const T& a, const T& b) { return set_less(a, b); });
+}
+
+
+/* Open addressing hash set of values that have a radix key. Values are stored as their radix keys, with
+ * -0.0 folded into +0.0 so that the two compare equal; NaNs are never members. */
+template <typename T>
+class KeyHashSet {
+    using U = radix_key_t<T>;
+
+    std::vector<U> _slots;
+    std::vector<uint8_t> _used;
+    size_t _mask;
+    unsigned _shift;
+
+    static U key_of(T x) {
+        if constexpr (std::is_floating_point_v<T>) {
+            if (x == T(0)) x = T(0);
+        }
+        return radix_key(x);
+    }
+
+    // Fibonacci hashing: the top bits of the key times 2^64 / phi
+    [[nodiscard]] size_t slot_of(const U key) const {
+        return static_cast<size_t>((static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ull) >> _shift);
+    }
+
+public:
+    KeyHashSet(const T* data, const size_t n) {
+        unsigned bits = 4;
+        while ((size_t(1) << bits) < 2 * n) bits++;
+        _slots.assign(size_t(1) << bits, U(0));
+        _used.assign(size_t(1) << bits, 0);
+        _mask = (size_t(1) << bits) - 1;
+        _shift = 64 - bits;
+
+        for (size_t i = 0; i < n; i++) {
+            if (is_nan(data[i])) continue;
+            const U key = key_of(data[i]);
+            size_t s = slot_of(key);
+            while (_used[s] && _slots[s] != key) s = (s + 1) & _mask;
+            _slots[s] = key;
+            _used[s] = 1;
+        }
+    }
+
+    [[nodiscard]] bool contains(const T& x) const {
+        if (is_nan(x)) return false;
+        const U key = key_of(x);
+        for (size_t s = slot_of(key); _used[s]; s = (s + 1) & _mask)
+            if (_slots[s] == key) return true;
+        return false;
+    }
+};
+
+
+/* Writes whether every element of `a` occurs in `b` (or does not, if `invert` is set) into `out`.
+ * NaNs never match. The method depends on the inputs:
+ *  - both sorted: a single merge-like walk over the two runs
+ *  - large `b` with radix keys: a hash set of `b`, probed in parallel
+ *  - otherwise: a sorted copy of `b`, searched in parallel with a branchless binary search */
+template <typename T>
+void isin_contiguous(const T* a, const size_t n, const T* b, const size_t m, bool* out, const bool invert) {
+    const auto less = [] (const T& x, const T& y) { return set_less(x, y); };
+
+    if (is_sorted_run(a, n) && is_sorted_run(b, m)) {
+        size_t j = 0;
+        for (size_t i = 0; i < n; i++) {
+            while (j < m && less(b[j], a[i])) j++;
+            const bool found = j < m && set_equal(a[i], b[j]) && !is_nan(order_key(a[i]));
+            out[i] = found != invert;
+        }
+        return;
+    }
+
+    if constexpr (is_radix_sortable_v<T>) {
+        if (m > (1 << 12)) {
+            const KeyHashSet<T> set(b, m);
+            parallel_for(n, 1 << 14, [&] (const size_t begin, const size_t end, size_t) {
+                for (size_t i = begin; i < end; i++) out[i] = set.contains(a[i]) != invert;
+            });
+            return;
+        }
+    }
+
+    const std::vector<T> sorted = get_sorted_copy(b, m);
+    parallel_for(n, 1 << 14, [&] (const size_t begin, const size_t end, size_t) {
+        for (size_t i = begin; i < end; i++) {
+            const size_t pos = branchless_search<false>(sorted.data(), m, a[i], less);
+            const bool found = pos < m && set_equal(a[i], sorted[pos]) && !is_nan(order_key(a[i]));
+            out[i] = found != invert;
+        }
+    });
+}
+
+
+// Returns the sorted distinct values of `a` that occur in `b` (or do not, if `invert` is set)
+template <typename T>
+std::vector<T> select_members(
+    const T* a, const size_t n_a, const T* b, const size_t n_b, const bool assume_unique, const bool invert
+) {
+    std::vector<T> values = assume_unique ? get_sorted_copy(a, n_a) : get_sorted_unique(a, n_a);
+
+    std::vector<T> out;
+    if (!values.empty()) {
+        // std::vector<bool> has no contiguous storage, so the flags go through a plain bool array
+        std::unique_ptr<bool[]> flags(new bool[values.size()]);
+        isin_contiguous(values.data(), values.size(), b, n_b, flags.get(), invert);
+        for (size_t i = 0; i < values.size(); i++)
+            if (flags[i]) out.push_back(values[i]);
+    }
+    return out;
+}
+
+} // namespace numxx::util
@@ -0,0 +1,360 @@
+/* SortUtils.hpp */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "Parallel.hpp"
+#include "ExtremaUtils.hpp"
+
+
+namespace numxx::util {
+
+// Types whose order can be expressed by an unsigned integer key, and which are therefore radix sorted
+template <typename T>
+constexpr bool is_radix_sortable_v = std::is_integral_v<T> || std::is_same_v<T, float> || std::is_same_v<T, double>;
+
+
+template <size_t Bytes> struct unsigned_of_size;
+template <> struct unsigned_of_size<1> { using type = uint8_t; };
+template <> struct unsigned_of_size<2> { using type = uint16_t; };
+template <> struct unsigned_of_size<4> { using type = uint32_t; };
+template <> struct unsigned_of_size<8> { using type = uint64_t; };
+
+template <typename T>
+using radix_key_t = typename unsigned_of_size<sizeof(T)>::type;
+
+
+/* Returns an unsigned key with the same order as `x`:
+ *  - signed integers have their sign bit flipped
+ *  - floats have every bit flipped if negative, and only the sign bit flipped otherwise,
+ *    which gives a total order with -0 before +0; NaNs get the largest key so they sort last */
+template <typename T>
+radix_key_t<T> radix_key(const T x) {
+    using U = radix_key_t<T>;
+    constexpr U sign_bit = static_cast<U>(U(1) << (8 * sizeof(T) - 1));
+
+    if constexpr (std::is_same_v<T, bool>) {
+        return static_cast<U>(x);
+    } else if constexpr (std::is_floating_point_v<T>) {
+        if (x != x) return std::numeric_limits<U>::max();
+        U bits;
+        std::memcpy(&bits, &x, sizeof(T));
+        return (bits & sign_bit) ? static_cast<U>(~bits) : static_cast<U>(bits | sign_bit);
+    } else if constexpr (std::is_signed_v<T>) {
+        return static_cast<U>(static_cast<U>(x) ^ sign_bit);
+    } else {
+        return static_cast<U>(x);
+    }
+}
+
+
+// Strict weak order used by the comparison sorts: order_key order, with NaNs last
+template <typename T>
+bool sort_less(const T& a, const T& b) {
+    const auto key_a = order_key(a), key_b = order_key(b);
+    if (is_nan(key_b)) return !is_nan(key_a);
+    return key_a < key_b;
+}
+
+
+/* Returns the position at which `x` would be inserted into the run `sorted` of length n (sorted under `less`):
+ * before any equal elements, or after them if `Right` is set. The search halves the range with a conditional
+ * move instead of a branch, so its cost does not depend on how predictable the comparisons are. */
+template <bool Right, typename E, typename T, typename Compare = std::less<>>
+size_t branchless_search(const E* sorted, size_t n, const T& x, Compare less = Compare()) {
+    if (n == 0) return 0;
+    const E* base = sorted;
+    while (n > 1) {
+        const size_t half = n / 2;
+        const bool go_right = Right ? !less(x, base[half]) : less(base[half], x);
+        base = go_right ? base + half : base;
+        n -= half;
+    }
+    const bool after = Right ? !less(x, *base) : less(*base, x);
+    return static_cast<size_t>(base - sorted) + after;
+}
+
+
+// Hints that the memory at `ptr` will be read soon (a no-op on compilers without a prefetch builtin)
+inline void prefetch(const void* ptr) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(ptr);
+#else
+    (void) ptr;
+#endif
+}
+
+
+/* A sorted run stored in Eytzinger (breadth-first) order: node k has children 2k and 2k + 1, and slot 0 is
+ * unused. The first levels of the tree share a few cache lines, so many searches against a large run miss the
+ * cache far less often than a plain binary search, whose early probes are spread over the whole run. */
+template <typename T>
+class EytzingerLayout {
+    std::vector<T> _nodes;
+    std::vector<size_t> _rank;
+
+    // Fills the subtree rooted at node k in order, taking the elements from sorted[i...]
+    void build(const T* sorted, size_t& i, const size_t k) {
+        if (k >= _nodes.size()) return;
+        build(sorted, i, 2 * k);
+        _nodes[k] = sorted[i];
+        _rank[k] = i++;
+        build(sorted, i, 2 * k + 1);
+    }
+
+public:
+    EytzingerLayout(const T* sorted, const size_t n) : _nodes(n + 1), _rank(n + 1) {
+        size_t i = 0;
+        build(sorted, i, 1);
+        _rank[0] = n;
+    }
+
+    // Same result as branchless_search over the original sorted run
+    // The 16 descendants four levels down share a cache line or two, and are prefetched while this level is compared
+    template <bool Right, typename Compare>
+    size_t search(const T& x, Compare less) const {
+        size_t k = 1;
+        while (k < _nodes.size()) {
+            prefetch(_nodes.data() + std::min(16 * k, _nodes.size() - 1));
+            k = 2 * k + (Right ? !less(x, _nodes[k]) : less(_nodes[k], x));
+        }
+
+        // The answer is the last node where the search went left: drop the right turns after it, then it
+        while (k & 1) k >>= 1;
+        return _rank[k >> 1];
+    }
+};
+
+
+// Key and original position of an element, sorted together by argsort
+template <typename U>
+struct KeyIndex {
+    U key;
+    size_t index;
+};
+
+
+/* Stable LSD radix sort of `n` items by the unsigned key `key_of(item)`, one byte per pass.
+ * Each pass splits the items into per-thread blocks: every thread counts the digits in its block, the
+ * counts are turned into per-(digit, block) offsets, and every thread scatters its block. Scattering the
+ * blocks in order keeps the sort stable. Passes where every key has the same digit are skipped.
+ * `buf` must hold `n` items; the result ends up in `data`. */
+template <typename Item, typename KeyOf>
+void lsd_radix_sort(Item* data, Item* buf, const size_t n, KeyOf key_of) {
+    using U = decltype(key_of(*data));
+    constexpr size_t grain = 1 << 16;
+    constexpr size_t radix = 256;
+
+    const size_t n_chunks = get_num_chunks(n, grain);
+    std::vector<std::array<size_t, radix>> counts(n_chunks);
+    Item* src = data;
+    Item* dst = buf;
+
+    for (size_t shift = 0; shift < 8 * sizeof(U); shift += 8) {
+        parallel_for(n, grain, [&] (const size_t begin, const size_t end, const size_t c) {
+            size_t count[radix] = {};
+            for (size_t i = begin; i < end; i++)
+                count[(key_of(src[i]) >> shift) & (radix - 1)]++;
+            std::copy(count, count + radix, counts[c].begin());
+        });
+
+        bool trivial = false;
+        size_t offset = 0;
+        for (size_t d = 0; d < radix; d++) {
+            size_t digit_total = 0;
+            for (size_t c = 0; c < n_chunks; c++) {
+                const size_t count = counts[c][d];
+                counts[c][d] = offset + digit_total;
+                digit_total += count;
+            }
+            trivial |= (digit_total == n);
+            offset += digit_total;
+        }
+        if (trivial) continue;
+
+        // The offsets are copied to a local array so the compiler knows the scattered stores cannot modify them
+        parallel_for(n, grain, [&] (const size_t begin, const size_t end, const size_t c) {
+            size_t next[radix];
+            std::copy(counts[c].begin(), counts[c].end(), next);
+            for (size_t i = begin; i < end; i++)
+                dst[next[(key_of(src[i]) >> shift) & (radix - 1)]++] = src[i];
+        });
+        std::swap(src, dst);
+    }
+
+    if (src != data) {
+        parallel_for(n, grain, [&] (const size_t begin, const size_t end, size_t) {
+            std::copy(src + begin, src + end, data + begin);
+        });
+    }
+}
+
+
+/* Parallel merge sort of `n` items with the comparison `less`.
+ * Every thread sorts its own block (with std::stable_sort or std::sort), then the sorted runs are
+ * merged pairwise, with the pairs of a round merged in parallel. std::merge takes equal items from
+ * the left run first, so the merge rounds keep the sort stable. `buf` must hold `n` items. */
+template <typename Item, typename Compare>
+void parallel_merge_sort(Item* data, Item* buf, const size_t n, Compare less, const bool stable) {
+    constexpr size_t grain = 1 << 14;
+    const size_t n_chunks = get_num_chunks(n, grain);
+
+    parallel_for(n, grain, [&] (const size_t begin, const size_t end, size_t) {
+        if (stable) std::stable_sort(data + begin, data + end, less);
+        else std::sort(data + begin, data + end, less);
+    });
+    if (n_chunks == 1) return;
+
+    std::vector<size_t> bounds(n_chunks + 1);
+    for (size_t c = 0; c <= n_chunks; c++) bounds[c] = get_chunk_begin(n, n_chunks, c);
+
+    Item* src = data;
+    Item* dst = buf;
+    while (bounds.size() > 2) {
+        const size_t n_runs = bounds.size() - 1;
+        parallel_for((n_runs + 1) / 2, 1, [&] (const size_t begin, const size_t end, size_t) {
+            for (size_t p = begin; p < end; p++) {
+                const size_t lo = bounds[2 * p], mid = bounds[std::min(2 * p + 1, n_runs)];
+                const size_t hi = bounds[std::min(2 * p + 2, n_runs)];
+                std::merge(src + lo, src + mid, src + mid, src + hi, dst + lo, less);
+            }
+        });
+
+        std::vector<size_t> merged;
+        for (size_t r = 0; r < n_runs; r += 2) merged.push_back(bounds[r]);
+        merged.push_back(n);
+        bounds = std::move(merged);
+        std::swap(src, dst);
+    }
+
+    if (src != data) {
+        parallel_for(n, grain, [&] (const size_t begin, const size_t end, size_t) {
+            std::copy(src + begin, src + end, data + begin);
+        });
+    }
+}
+
+
+// Below this many elements radix sorting does not pay for its digit histograms
+constexpr size_t radix_sort_threshold = 256;
+
+
+// Sorts a contiguous run in place; `buf` must hold `n` elements
+template <typename T>
+void sort_contiguous(T* data, T* buf, const size_t n, const bool stable) {
+    if constexpr (is_radix_sortable_v<T>) {
+        if (n > radix_sort_threshold) {
+            lsd_radix_sort(data, buf, n, [] (const T& x) { return radix_key(x); });
+            return;
+        }
+    }
+    parallel_merge_sort(data, buf, n, [] (const T& a, const T& b) { return sort_less(a, b); }, stable);
+}
+
+
+// Scratch space for argsorting runs of up to `n` elements of type T
+template <typename T, bool Radix = is_radix_sortable_v<T>>
+struct ArgsortBuffer {
+    std::vector<size_t> buf;
+    explicit ArgsortBuffer(const size_t n) : buf(n) {}
+};
+
+template <typename T>
+struct ArgsortBuffer<T, true> {
+    std::vector<size_t> buf;
+    std::vector<KeyIndex<radix_key_t<T>>> items, items_buf;
+    explicit ArgsortBuffer(const size_t n) :
+        buf(n > radix_sort_threshold ? 0 : n),
+        items(n > radix_sort_threshold ? n : 0),
+        items_buf(n > radix_sort_threshold ? n : 0) {}
+};
+
+
+// Writes the indices that sort a contiguous run into `idx`
+template <typename T>
+void argsort_contiguous(const T* data, size_t* idx, const size_t n, ArgsortBuffer<T>& scratch, const bool stable) {
+    if constexpr (is_radix_sortable_v<T>) {
+        if (n > radix_sort_threshold) {
+            auto* items = scratch.items.data();
+            parallel_for(n, 1 << 16, [&] (const size_t begin, const size_t end, size_t) {
+                for (size_t i = begin; i < end; i++) items[i] = {radix_key(data[i]), i};
+            });
+            lsd_radix_sort(items, scratch.items_buf.data(), n,
+                [] (const KeyIndex<radix_key_t<T>>& item) { return item.key; });
+            parallel_for(n, 1 << 16, [&] (const size_t begin, const size_t end, size_t) {
+                for (size_t i = begin; i < end; i++) idx[i] = items[i].index;
+            });
+            return;
+        }
+    }
+    for (size_t i = 0; i < n; i++) idx[i] = i;
+    parallel_merge_sort(idx, scratch.buf.data(), n,
+        [data] (const size_t a, const size_t b) { return sort_less(data[a], data[b]); }, stable);
+}
+
+
+/* Sorts every lane of an array viewed as (outer, axis_len, inner) along the middle axis.
+ * Lanes are split across threads; a lane that is the only one gets the parallel sort instead.
+ * Strided lanes are gathered into a contiguous buffer, sorted and scattered back. */
+template <typename T>
+void sort_axis(const T* in, T* out, const size_t outer, const size_t axis_len, const size_t inner, const bool stable) {
+    if (axis_len == 0) return;
+    const size_t lanes = outer * inner;
+
+    parallel_for(lanes, std::max<size_t>(1, (1 << 16) / axis_len), [&] (const size_t begin, const size_t end, size_t) {
+        std::vector<T> lane(inner == 1 ? 0 : axis_len), buf(axis_len);
+        for (size_t l = begin; l < end; l++) {
+            const size_t o = l / inner, k = l % inner;
+            const T* src = in + o * axis_len * inner + k;
+            T* dst = out + o * axis_len * inner + k;
+
+            if (inner == 1) {
+                std::copy(src, src + axis_len, dst);
+                sort_contiguous(dst, buf.data(), axis_len, stable);
+                continue;
+            }
+            for (size_t i = 0; i < axis_len; i++) lane[i] = src[i * inner];
+            sort_contiguous(lane.data(), buf.data(), axis_len, stable);
+            for (size_t i = 0; i < axis_len; i++) dst[i * inner] = lane[i];
+        }
+    });
+}
+
+
+// Writes the indices that sort every lane of an array viewed as (outer, axis_len, inner) along the middle axis
+template <typename T>
+void argsort_axis(
+    const T* in, size_t* out, const size_t outer, const size_t axis_len, const size_t inner, const bool stable
+) {
+    if (axis_len == 0) return;
+    const size_t lanes = outer * inner;
+
+    parallel_for(lanes, std::max<size_t>(1, (1 << 16) / axis_len), [&] (const size_t begin, const size_t end, size_t) {
+        ArgsortBuffer<T> scratch(axis_len);
+        std::vector<T> lane(inner == 1 ? 0 : axis_len);
+        std::vector<size_t> idx(inner == 1 ? 0 : axis_len);
+
+        for (size_t l = begin; l < end; l++) {
+            const size_t o = l / inner, k = l % inner;
+            const T* src = in + o * axis_len * inner + k;
+            size_t* dst = out + o * axis_len * inner + k;
+
+            if (inner == 1) {
+                argsort_contiguous(src, dst, axis_len, scratch, stable);
+                continue;
+            }
+            for (size_t i = 0; i < axis_len; i++) lane[i] = src[i * inner];
+            argsort_contiguous(lane.data(), idx.data(), axis_len, scratch, stable);
+            for (size_t i = 0; i < axis_len; i++) dst[i * inner] = idx[i];
+        }
+    });
+}
+
+} // namespace numxx::util
@@ -0,0 +1,216 @@
+/* SparseUtils.hpp */
+#pragma once
+
+#include <algorithm>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "Errors.hpp"
+#include "Parallel.hpp"
+
+
+namespace numxx::util {
+
+// Throws unless indptr, indices and values describe a valid compressed matrix with n_major rows (or columns)
+// and n_minor columns (or rows)
+template <typename T>
+void check_compressed(
+    const size_t n_major, const size_t n_minor,
+    const std::vector<size_t>& indptr, const std::vector<size_t>& indices, const std::vector<T>& values
+) {
+    if (indptr.size() != n_major + 1 || indptr.front() != 0)
+        throw error::ValueError("Index pointer must have " + std::to_string(n_major + 1) + " elements, starting at 0.");
+    for (size_t i = 0; i < n_major; i++) {
+        if (indptr[i] > indptr[i + 1]) throw error::ValueError("Index pointer must be non-decreasing.");
+    }
+    if (indices.size() != indptr.back() || values.size() != indptr.back())
+        throw error::ValueError("Index and value arrays must have as many elements as the index pointer's last entry.");
+    for (const size_t idx : indices) {
+        if (idx >= n_minor) throw error::ValueError("Sparse matrix index " + std::to_string(idx) + " is out of range.");
+    }
+}
+
+
+// Stored elements per thread below which a sparse product is not split further
+constexpr size_t sparse_parallel_grain = 1 << 15;
+
+
+/* Returns the first row of each of `n_parts` ranges of rows of a compressed matrix, plus the end row, chosen so
+ * that every range holds about the same number of stored elements. Splitting by nonzeros rather than by rows
+ * keeps the threads balanced when a few rows are much denser than the rest (hubs of a graph, common terms). */
+inline std::vector<size_t> get_balanced_row_ranges(const std::vector<size_t>& indptr, const size_t n_parts) {
+    const size_t rows = indptr.size() - 1;
+    const size_t nnz = indptr.back();
+    std::vector<size_t> bounds(n_parts + 1, rows);
+    bounds[0] = 0;
+    for (size_t p = 1; p < n_parts; p++) {
+        const size_t target = get_chunk_begin(nnz, n_parts, p);
+        const size_t row = static_cast<size_t>(std::lower_bound(indptr.begin(), indptr.end(), target) - indptr.begin());
+        bounds[p] = std::clamp(row, bounds[p - 1], rows);
+    }
+    return bounds;
+}
+
+
+/* Calls func(row_begin, row_end) over ranges of rows of a compressed matrix with the row pointer `indptr`,
+ * on separate threads when there are enough stored elements, with about the same number of them per range. */
+template <typename Func>
+void parallel_for_rows(const std::vector<size_t>& indptr, const size_t work_per_element, Func func) {
+    const size_t rows = indptr.size() - 1;
+    const size_t n_parts = in_parallel_region ? 1
+        : get_num_chunks((indptr.back() + rows) * work_per_element, sparse_parallel_grain);
+    if (n_parts == 1) {
+        func(size_t(0), rows);
+        return;
+    }
+
+    const std::vector<size_t> bounds = get_balanced_row_ranges(indptr, n_parts);
+    parallel_for(n_parts, 1, [&] (const size_t begin, const size_t end, size_t) {
+        for (size_t p = begin; p < end; p++)
+            if (bounds[p] < bounds[p + 1]) func(bounds[p], bounds[p + 1]);
+    });
+}
+
+
+// y = A * x for the compressed-row matrix A, split by rows across threads. y is overwritten, not accumulated
+template <typename T>
+void csr_spmv(
+    const std::vector<size_t>& indptr, const std::vector<size_t>& indices, const std::vector<T>& values,
+    const T* x, T* y
+) {
+    parallel_for_rows(indptr, 1, [&] (const size_t r0, const size_t r1) {
+        for (size_t r = r0; r < r1; r++) {
+            T s(0);
+            for (size_t p = indptr[r]; p < indptr[r + 1]; p++) s += values[p] * x[indices[p]];
+            y[r] = s;
+        }
+    });
+}
+
+
+/* C = A * B for the compressed-row matrix A and the row-major dense matrix B with k columns, split by rows
+ * across threads. Each row of C is a sum of scaled rows of B, so the inner loop runs along contiguous rows. */
+template <typename T>
+void csr_spmm(
+    const std::vector<size_t>& indptr, const std::vector<size_t>& indices, const std::vector<T>& values,
+    const T* b, const size_t k, T* c
+) {
+    parallel_for_rows(indptr, k, [&] (const size_t r0, const size_t r1) {
+        for (size_t r = r0; r < r1; r++) {
+            T* row = c + r * k;
+            for (size_t j = 0; j < k; j++) row[j] = T(0);
+            for (size_t p = indptr[r]; p < indptr[r + 1]; p++) {
+                const T v = values[p];
+                const T* b_row = b + indices[p] * k;
+                for (size_t j = 0; j < k; j++) row[j] += v * b_row[j];
+            }
+        }
+    });
+}
+
+
+/* y = A * x for the compressed-column matrix A (with `rows` rows). Every column scatters into all of y, so the
+ * columns are split across threads that each accumulate into a private copy of y, and the copies are summed. */
+template <typename T>
+void csc_spmv(
+    const size_t rows, const std::vector<size_t>& indptr, const std::vector<size_t>& indices,
+    const std::vector<T>& values, const T* x, T* y
+) {
+    const size_t cols = indptr.size() - 1;
+    const size_t n_parts = in_parallel_region ? 1
+        : std::min(get_num_chunks(indptr.back() + cols, sparse_parallel_grain),
+                   std::max<size_t>(1, indptr.back() / std::max<size_t>(1, rows)));
+
+    std::vector<T> partial((n_parts - 1) * rows);
+    const std::vector<size_t> bounds = get_balanced_row_ranges(indptr, n_parts);
+    parallel_for(n_parts, 1, [&] (const size_t begin, const size_t end, size_t) {
+        for (size_t part = begin; part < end; part++) {
+            T* out = (part == 0) ? y : partial.data() + (part - 1) * rows;
+            for (size_t i = 0; i < rows; i++) out[i] = T(0);
+            for (size_t c = bounds[part]; c < bounds[part + 1]; c++) {
+                const T xc = x[c];
+                for (size_t p = indptr[c]; p < indptr[c + 1]; p++) out[indices[p]] += values[p] * xc;
+            }
+        }
+    });
+    for (size_t part = 1; part < n_parts; part++) {
+        const T* src = partial.data() + (part - 1) * rows;
+        for (size_t i = 0; i < rows; i++) y[i] += src[i];
+    }
+}
+
+
+/* Converts a compressed matrix with `n_major` rows (or columns) and `n_minor` columns (or rows) to the other
+ * compression, which also transposes it: a counting sort of the stored elements by their minor index.
+ * Elements are visited in major order, so the minor-compressed result has sorted indices. */
+template <typename T>
+void transpose_compressed(
+    const size_t n_minor,
+    const std::vector<size_t>& indptr, const std::vector<size_t>& indices, const std::vector<T>& values,
+    std::vector<size_t>& out_indptr, std::vector<size_t>& out_indices, std::vector<T>& out_values
+) {
+    const size_t n_major = indptr.size() - 1;
+    const size_t nnz = indptr.back();
+    out_indptr.assign(n_minor + 1, 0);
+    for (size_t p = 0; p < nnz; p++) out_indptr[indices[p] + 1]++;
+    std::partial_sum(out_indptr.begin(), out_indptr.end(), out_indptr.begin());
+
+    out_indices.resize(nnz);
+    out_values.resize(nnz);
+    std::vector<size_t> next(out_indptr.begin(), out_indptr.end() - 1);
+    for (size_t r = 0; r < n_major; r++) {
+        for (size_t p = indptr[r]; p < indptr[r + 1]; p++) {
+            const size_t q = next[indices[p]]++;
+            out_indices[q] = r;
+            out_values[q] = values[p];
+        }
+    }
+}
+
+
+/* Compresses the (major, minor, value) triplets of a matrix with `n_major` rows (or columns) and `n_minor`
+ * columns (or rows), summing duplicates. Two stable counting sorts, by minor index and then by major index,
+ * leave the indices sorted within every row, where duplicates are adjacent and merged in one pass. */
+template <typename T>
+void compress_triplets(
+    const size_t n_major, const size_t n_minor,
+    const std::vector<size_t>& major, const std::vector<size_t>& minor, const std::vector<T>& values,
+    std::vector<size_t>& indptr, std::vector<size_t>& indices, std::vector<T>& out_values
+) {
+    const size_t nnz = values.size();
+
+    // Minor-compressed form first, then transposed into major-compressed form with sorted indices
+    std::vector<size_t> minor_ptr(n_minor + 1, 0), minor_idx(nnz);
+    std::vector<T> minor_vals(nnz);
+    for (size_t p = 0; p < nnz; p++) minor_ptr[minor[p] + 1]++;
+    std::partial_sum(minor_ptr.begin(), minor_ptr.end(), minor_ptr.begin());
+    std::vector<size_t> next(minor_ptr.begin(), minor_ptr.end() - 1);
+    for (size_t p = 0; p < nnz; p++) {
+        const size_t q = next[minor[p]]++;
+        minor_idx[q] = major[p];
+        minor_vals[q] = values[p];
+    }
+    transpose_compressed(n_major, minor_ptr, minor_idx, minor_vals, indptr, indices, out_values);
+
+    // Sum duplicates in place
+    size_t out = 0;
+    for (size_t r = 0; r < n_major; r++) {
+        const size_t begin = indptr[r], end = indptr[r + 1];
+        indptr[r] = out;
+        for (size_t p = begin; p < end; p++) {
+            if (out > indptr[r] && indices[out - 1] == indices[p]) {
+                out_values[out - 1] += out_values[p];
+            } else {
+                indices[out] = indices[p];
+                out_values[out] = out_values[p];
+                out++;
+            }
+        }
+    }
+    indptr[n_major] = out;
+    indices.resize(out);
+    out_values.resize(out);
+}
+
+} // namespace numxx::util
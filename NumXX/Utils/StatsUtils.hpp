@@ -0,0 +1,135 @@
+/* StatsUtils.hpp */
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+#include "Parallel.hpp"
+
+
+namespace numxx::util {
+
+// Type used to accumulate statistics of type `R` (single precision is accumulated in double)
+template <typename R>
+using accumulator_t = std::conditional_t<std::is_same_v<R, float>, double, R>;
+
+
+// Count, mean and sum of squared deviations (M2) of a set of samples
+template <typename R>
+struct Moments {
+    size_t count = 0;
+    R mean = 0;
+    R m2 = 0;
+
+    // Combines the moments of two disjoint sets of samples (Chan et al.)
+    void merge(const Moments& other) {
+        if (other.count == 0) return;
+        if (count == 0) { *this = other; return; }
+
+        const size_t n = count + other.count;
+        const R delta = other.mean - mean;
+        const R weight = static_cast<R>(other.count) / static_cast<R>(n);
+
+        mean += delta * weight;
+        m2 += other.m2 + delta * delta * static_cast<R>(count) * weight;
+        count = n;
+    }
+};
+
+
+// Computes the moments of a contiguous run of samples in a single sweep over memory
+// The run is processed in cache-sized blocks: each block is summed, then its deviations are summed
+// while it is still in cache, and the block moments are merged into the running result
+template <typename R, typename T>
+Moments<R> contiguous_moments(const T* data, const size_t len) {
+    constexpr size_t block = 2048;
+    Moments<R> total;
+
+    for (size_t start = 0; start < len; start += block) {
+        const size_t n = std::min(block, len - start);
+        const T* x = data + start;
+
+        R s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            s0 += static_cast<R>(x[i]);
+            s1 += static_cast<R>(x[i + 1]);
+            s2 += static_cast<R>(x[i + 2]);
+            s3 += static_cast<R>(x[i + 3]);
+        }
+        for (; i < n; i++) s0 += static_cast<R>(x[i]);
+        const R block_mean = ((s0 + s1) + (s2 + s3)) / static_cast<R>(n);
+
+        R m0 = 0, m1 = 0;
+        i = 0;
+        for (; i + 2 <= n; i += 2) {
+            const R d0 = static_cast<R>(x[i]) - block_mean;
+            const R d1 = static_cast<R>(x[i + 1]) - block_mean;
+            m0 += d0 * d0;
+            m1 += d1 * d1;
+        }
+        for (; i < n; i++) {
+            const R d = static_cast<R>(x[i]) - block_mean;
+            m0 += d * d;
+        }
+
+        total.merge(Moments<R>{n, block_mean, m0 + m1});
+    }
+    return total;
+}
+
+
+// Computes the moments of a contiguous run, splitting it across threads and merging the partial results
+template <typename R, typename T>
+Moments<R> parallel_moments(const T* data, const size_t len) {
+    constexpr size_t grain = 1 << 16;
+    std::vector<Moments<R>> parts(get_num_chunks(len, grain));
+
+    parallel_for(len, grain, [&] (const size_t begin, const size_t end, const size_t chunk) {
+        parts[chunk] = contiguous_moments<R>(data + begin, end - begin);
+    });
+
+    Moments<R> total;
+    for (const auto& part : parts) total.merge(part);
+    return total;
+}
+
+
+// Welford update of `width` independent features with one new sample each
+// `count` is the number of samples each feature holds after the update
+template <typename R, typename T>
+void welford_row(const T* row, const size_t width, const size_t count, R* mean, R* m2) {
+    const R inv_n = R(1) / static_cast<R>(count);
+    for (size_t j = 0; j < width; j++) {
+        const R x = static_cast<R>(row[j]);
+        const R delta = x - mean[j];
+        mean[j] += delta * inv_n;
+        m2[j] += delta * (x - mean[j]);
+    }
+}
+
+
+// Merges the moments of `width` features from (count_b, mean_b, m2_b) into (count_a, mean_a, m2_a)
+// `count_a` is left untouched, since it is shared by every feature
+template <typename R>
+void merge_moments(
+    const size_t count_a, R* mean_a, R* m2_a,
+    const size_t count_b, const R* mean_b, const R* m2_b,
+    const size_t width
+) {
+    if (count_b == 0) return;
+
+    const size_t n = count_a + count_b;
+    const R weight = static_cast<R>(count_b) / static_cast<R>(n);
+    const R scale = static_cast<R>(count_a) * weight;
+
+    for (size_t j = 0; j < width; j++) {
+        const R delta = mean_b[j] - mean_a[j];
+        mean_a[j] += delta * weight;
+        m2_a[j] += m2_b[j] + delta * delta * scale;
+    }
+}
+
+} // namespace numxx::util
@@ -0,0 +1,159 @@
+/* Strassen.hpp */
+#pragma once
+
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+#include "../Complex.hpp"
+#include "Gemm.hpp"
+#include "Parallel.hpp"
+
+
+namespace numxx {
+
+/* How numxx::matmul multiplies two matrices.
+ * Standard is the blocked gemm kernel. Strassen uses the Strassen-Winograd recursion (for floating-point and
+ * complex elements), which does 7 half-size products instead of 8 at every level, at the cost of a larger
+ * rounding error: it grows with the depth of the recursion, rather than only with the inner dimension.
+ * Auto picks Strassen only for products large enough for it to pay off, so the extra error is opt-in. */
+enum class MatmulAlgo {
+    Standard,
+    Strassen,
+    Auto
+};
+
+
+namespace util {
+
+// Every dimension of a product must be at least this for MatmulAlgo::Auto to pick the Strassen recursion
+constexpr size_t strassen_crossover = 4096;
+
+// The recursion stops once a dimension falls below this, and the remaining products go to gemm
+constexpr size_t strassen_leaf = 1024;
+
+// Elements per thread below which a matrix addition is not split further
+constexpr size_t strassen_add_grain = 1 << 16;
+
+
+// Whether the Strassen recursion applies to elements of type T (integers could overflow in the sums)
+template <typename T>
+inline constexpr bool strassen_supported_v = std::is_floating_point_v<underlying_type_t<T>>;
+
+
+// Whether matmul should multiply an m x k matrix by a k x n matrix of element type T with the Strassen recursion
+template <typename T>
+bool use_strassen(const size_t m, const size_t k, const size_t n, const MatmulAlgo algo) {
+    if constexpr (strassen_supported_v<T>) {
+        const size_t min_dim = std::min({m, k, n});
+        if (algo == MatmulAlgo::Strassen) return min_dim >= strassen_leaf;
+        if (algo == MatmulAlgo::Auto) return min_dim >= strassen_crossover;
+    }
+    return false;
+}
+
+
+// Computes C = A + B (or A - B, if `subtract` is set) for row-major m x n matrices, split by rows across threads
+template <typename T>
+void matrix_add(
+    const size_t m, const size_t n, const T* a, const size_t lda, const T* b, const size_t ldb,
+    T* c, const size_t ldc, const bool subtract
+) {
+    parallel_for(m, std::max<size_t>(1, strassen_add_grain / std::max<size_t>(1, n)),
+        [&] (const size_t begin, const size_t end, size_t) {
+            for (size_t i = begin; i < end; i++) {
+                const T* a_row = a + i * lda;
+                const T* b_row = b + i * ldb;
+                T* c_row = c + i * ldc;
+                if (subtract) {
+                    for (size_t j = 0; j < n; j++) c_row[j] = a_row[j] - b_row[j];
+                } else {
+                    for (size_t j = 0; j < n; j++) c_row[j] = a_row[j] + b_row[j];
+                }
+            }
+        }
+    );
+}
+
+
+// Returns the number of elements of workspace strassen_recurse needs for an m x k times k x n product
+inline size_t get_strassen_workspace(size_t m, size_t k, size_t n) {
+    size_t size = 0;
+    while (std::min({m, k, n}) >= strassen_leaf) {
+        m /= 2; k /= 2; n /= 2;
+        size += m * std::max(k, n) + k * n;
+    }
+    return size;
+}
+
+
+/* Computes C = A * B for a row-major m x k matrix A and k x n matrix B with the Strassen-Winograd recursion,
+ * overwriting the m x n matrix C. Each level splits the even parts of the matrices into quadrants and forms
+ * the 7 products and 15 additions of Winograd's variant in the order of Boyer, Dumas, Pernet and Zhou, which
+ * needs only two temporaries, X and Y, besides C itself. They are taken from the front of `work`, and deeper
+ * levels use the rest (see get_strassen_workspace). An odd last row, column or inner index is peeled off and
+ * handled by gemm afterwards. */
+template <typename T>
+void strassen_recurse(
+    const size_t m, const size_t k, const size_t n,
+    const T* a, const size_t lda, const T* b, const size_t ldb, T* c, const size_t ldc, T* work
+) {
+    if (std::min({m, k, n}) < strassen_leaf) {
+        gemm(m, n, k, T(1), a, lda, b, ldb, T(0), c, ldc);
+        return;
+    }
+
+    const size_t hm = m / 2, hk = k / 2, hn = n / 2;
+    const T *a11 = a, *a12 = a + hk, *a21 = a + hm * lda, *a22 = a21 + hk;
+    const T *b11 = b, *b12 = b + hn, *b21 = b + hk * ldb, *b22 = b21 + hn;
+    T *c11 = c, *c12 = c + hn, *c21 = c + hm * ldc, *c22 = c21 + hn;
+
+    // X holds a quadrant of A and then one of C, Y a quadrant of B
+    const size_t ldx = std::max(hk, hn);
+    T* x = work;
+    T* y = x + hm * ldx;
+    T* rest = y + hk * hn;
+
+    matrix_add(hm, hk, a11, lda, a21, lda, x, ldx, true);           // S3 = A11 - A21
+    matrix_add(hk, hn, b22, ldb, b12, ldb, y, hn, true);            // T3 = B22 - B12
+    strassen_recurse(hm, hk, hn, x, ldx, y, hn, c21, ldc, rest);    // P7 = S3 * T3
+    matrix_add(hm, hk, a21, lda, a22, lda, x, ldx, false);          // S1 = A21 + A22
+    matrix_add(hk, hn, b12, ldb, b11, ldb, y, hn, true);            // T1 = B12 - B11
+    strassen_recurse(hm, hk, hn, x, ldx, y, hn, c22, ldc, rest);    // P5 = S1 * T1
+    matrix_add(hm, hk, x, ldx, a11, lda, x, ldx, true);             // S2 = S1 - A11
+    matrix_add(hk, hn, b22, ldb, y, hn, y, hn, true);               // T2 = B22 - T1
+    strassen_recurse(hm, hk, hn, x, ldx, y, hn, c12, ldc, rest);    // P6 = S2 * T2
+    matrix_add(hm, hk, a12, lda, x, ldx, x, ldx, true);             // S4 = A12 - S2
+    strassen_recurse(hm, hk, hn, x, ldx, b22, ldb, c11, ldc, rest); // P3 = S4 * B22
+    strassen_recurse(hm, hk, hn, a11, lda, b11, ldb, x, ldx, rest); // P1 = A11 * B11
+    matrix_add(hm, hn, x, ldx, c12, ldc, c12, ldc, false);          // U2 = P1 + P6
+    matrix_add(hm, hn, c12, ldc, c21, ldc, c21, ldc, false);        // U3 = U2 + P7
+    matrix_add(hm, hn, c12, ldc, c22, ldc, c12, ldc, false);        // U4 = U2 + P5
+    matrix_add(hm, hn, c21, ldc, c22, ldc, c22, ldc, false);        // U7 = U3 + P5
+    matrix_add(hm, hn, c12, ldc, c11, ldc, c12, ldc, false);        // U5 = U4 + P3
+    matrix_add(hk, hn, y, hn, b21, ldb, y, hn, true);               // T4 = T2 - B21
+    strassen_recurse(hm, hk, hn, a22, lda, y, hn, c11, ldc, rest);  // P4 = A22 * T4
+    matrix_add(hm, hn, c21, ldc, c11, ldc, c21, ldc, true);         // U6 = U3 - P4
+    strassen_recurse(hm, hk, hn, a12, lda, b21, ldb, c11, ldc, rest); // P2 = A12 * B21
+    matrix_add(hm, hn, x, ldx, c11, ldc, c11, ldc, false);          // U1 = P1 + P2
+
+    // Peeled edges: the odd inner index adds a rank-1 update, then the odd last column and row of C
+    const size_t em = 2 * hm, ek = 2 * hk, en = 2 * hn;
+    if (ek < k) gemm(em, en, k - ek, T(1), a + ek, lda, b + ek * ldb, ldb, T(1), c, ldc);
+    if (en < n) gemm(em, n - en, k, T(1), a, lda, b + en, ldb, T(0), c + en, ldc);
+    if (em < m) gemm(m - em, n, k, T(1), a + em * lda, lda, b, ldb, T(0), c + em * ldc, ldc);
+}
+
+
+// Computes C = A * B for row-major matrices with the Strassen-Winograd recursion, allocating its workspace once
+template <typename T>
+void strassen_gemm(
+    const size_t m, const size_t k, const size_t n,
+    const T* a, const size_t lda, const T* b, const size_t ldb, T* c, const size_t ldc
+) {
+    std::vector<T> work(get_strassen_workspace(m, k, n));
+    strassen_recurse(m, k, n, a, lda, b, ldb, c, ldc, work.data());
+}
+
+} // namespace util
+} // namespace numxx
@@ -75,7 +75,7 @@ int get_left_padding(T num) {
             return 1;
         return static_cast<int>(std::log10(integer_part) + 1);
     } else {
-        return static_cast<int>(std::log10(std::abs(num)) + 1);
+        return static_cast<int>(std::log10(std::abs(static_cast<double>(num))) + 1);
     }
 }
 
@@ -89,21 +89,22 @@ int get_left_padding(const complex<T>& num) {
 // Counts the number of digits to the right of the decimal point
 template <typename T>
 int get_right_padding(T num) {
-    if constexpr (std::is_integral_v<T>)
+    if constexpr (std::is_integral_v<T>) {
         return 0;
+    } else {
+        std::string s = toString(std::abs(num));
 
-    std::string s = toString(std::abs(num));
-
-    // Find the decimal point
-    const size_t dot = s.find('.');
-    if (dot == std::string::npos)
-        return 0;
+        // Find the decimal point
+        const size_t dot = s.find('.');
+        if (dot == std::string::npos)
+            return 0;
 
-    // If the last char is '.', remove it too
-    if (!s.empty() && s.back() == '.')
-        return 0;
+        // If the last char is '.', remove it too
+        if (!s.empty() && s.back() == '.')
+            return 0;
 
-    return static_cast<int>(s.size() - dot - 1);
+        return static_cast<int>(s.size() - dot - 1);
+    }
 }
 
 template <typename T>
@@ -147,6 +148,13 @@ PrintAttributes GetPrintAttributes(dtype* data_ptr, const size_t arrsize) {
             }
         }
 
+        // Infinities and NaNs are printed as they are and do not affect the layout
+        if (isinf(data_ptr[i]) || isnan(data_ptr[i])) {
+            if (is_negative(data_ptr[i]))
+                attributes.negative = true;
+            continue;
+        }
+
         // Check if number is to be printed in scientific notation
         if constexpr (std::is_floating_point_v<dtype> || is_complex_floating_point_v<dtype>) {
             if (is_scientific(data_ptr[i]))
@@ -180,7 +188,7 @@ PrintAttributes GetPrintAttributes(dtype* data_ptr, const size_t arrsize) {
 template <typename T>
 std::string num_to_scientific(T num, const int exponent_length) {
     
-    if(!isinf(num)) {
+    if(!isinf(num) && !isnan(num)) {
         std::string exp_sign;
         const int exponent = get_exponent(num);
         const double base = num * std::pow(10,-exponent);
@@ -194,12 +202,12 @@ std::string num_to_scientific(T num, const int exponent_length) {
 }
 
 inline void pad_left(std::string& str, const int pad_depth) {
-    if(pad_depth)
+    if(pad_depth > 0)
         str.insert(0, pad_depth, ' ');
 }
 
 inline void pad_right(std::string& str, const int pad_depth) {
-    if(pad_depth)
+    if(pad_depth > 0)
         str.append(pad_depth, ' ');
 }
 
@@ -209,13 +217,13 @@ template <typename T>
 std::string num_to_str_from_attributes(T num, const PrintAttributes& attributes) {
     // Add space in place of -ve sign if num >= 0
     std::string result;
-    if(attributes.negative && (num >= 0)) result += " ";
+    if(attributes.negative && !(num < 0)) result += " ";
 
     // `is_scientific` overrides all other print attributes
     if(attributes.is_scientific)
         result += num_to_scientific(num, get_left_padding(attributes.largest_exponent));
     else {
-        if(isinf(num)) {
+        if(isinf(num) || isnan(num)) {
             pad_left(result, attributes.left_padding + attributes.right_padding - 2);
             result += std::to_string(num);
         } else {
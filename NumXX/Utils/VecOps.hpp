@@ -1,23 +1,103 @@
 /* VecOps.hpp */
 #pragma once
 
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "../Core/Shape.hpp"
+#include "Gemm.hpp"
+#include "Parallel.hpp"
+#include "Strassen.hpp"
 
 namespace numxx::util {
 
-// Returns a vector containing the flattened matrix product
+// Multiplies an m x k matrix by a k x n matrix, writing the m x n product into `out`
+// Operands of the same type go through the packed gemm kernel, or the Strassen recursion if `algo` picks it;
+// mixed types (e.g. int times double) are multiplied row by row
+template <typename dtype, typename T, typename U>
+void matmul_2d(
+    const dtype* larr, const T* rarr, U* out, const size_t m, const size_t k, const size_t n,
+    const MatmulAlgo algo = MatmulAlgo::Standard
+) {
+    if constexpr (std::is_same_v<dtype, U> && std::is_same_v<T, U>) {
+        if (use_strassen<U>(m, k, n, algo)) strassen_gemm(m, k, n, larr, k, rarr, n, out, n);
+        else gemm(m, n, k, U(1), larr, k, rarr, n, U(0), out, n);
+    } else {
+        for (size_t i = 0; i < m; i++) {
+            U* row = out + i * n;
+            for (size_t j = 0; j < n; j++) row[j] = U(0);
+            for (size_t t = 0; t < k; t++) {
+                const dtype x = larr[i * k + t];
+                const T* r_row = rarr + t * n;
+                for (size_t j = 0; j < n; j++) row[j] += x * r_row[j];
+            }
+        }
+    }
+}
+
+
+// Returns the dot product of the vectors `larr` and `rarr` of length n
+// Operands of the same type go through the multi-accumulator kernel; mixed types are summed in order
 template <typename dtype, typename T>
-auto matmul(
-    const dtype* larr, const Shape& lshape,
-    const T* rarr, const Shape& rshape
-) -> std::vector<decltype(std::declval<dtype>() * std::declval<T>())>
-{
+auto dot_1d(const dtype* larr, const T* rarr, const size_t n) -> decltype(std::declval<dtype>() * std::declval<T>()) {
     using U = decltype(std::declval<dtype>() * std::declval<T>());
-    const auto out_shape = Shape::get_product_shape(lshape, rshape);
-    std::vector<U> out(out_shape.get_total_size());
-    
+    if constexpr (std::is_same_v<dtype, U> && std::is_same_v<T, U>) {
+        return dot(n, larr, rarr);
+    } else {
+        U sum(0);
+        for (size_t i = 0; i < n; i++) sum += larr[i] * rarr[i];
+        return sum;
+    }
+}
+
+
+/* Returns, for every matrix of a batched product (in the order of the broadcast batch dimensions
+ * `batch_dims`), the offset of the matching matrix of an operand with the shape `shape`.
+ * Batch dimensions the operand lacks or has as 1 are broadcast, so their stride is zero. */
+inline std::vector<size_t> get_batch_offsets(const Shape& shape, const std::vector<size_t>& batch_dims) {
+    const size_t ndim = shape.get_Ndim();
+    const size_t own = (ndim > 2) ? ndim - 2 : 0;
+    const size_t nb = batch_dims.size();
+
+    size_t stride = (ndim > 1) ? shape[-2] * shape[-1] : shape[0];
+    std::vector<size_t> strides(nb, 0);
+    for (size_t i = own; i-- > 0;) {
+        if (shape.dimensions[i] != 1) strides[nb - own + i] = stride;
+        stride *= shape.dimensions[i];
+    }
+
+    size_t count = 1;
+    for (const size_t d : batch_dims) count *= d;
+
+    std::vector<size_t> offsets(count), index(nb, 0);
+    size_t offset = 0;
+    for (size_t b = 0; b < count; b++) {
+        offsets[b] = offset;
+        for (size_t d = nb; d-- > 0;) {
+            offset += strides[d];
+            if (++index[d] < batch_dims[d]) break;
+            offset -= strides[d] * batch_dims[d];
+            index[d] = 0;
+        }
+    }
+    return offsets;
+}
+
+
+/* Writes the flattened matrix product into `out`, which must hold Shape::get_product_shape(lshape, rshape).
+ * Operands with more than two dimensions are stacks of matrices, multiplied pairwise with NumPy's
+ * broadcasting of the batch dimensions. The batch is split across threads when there are enough matrices
+ * to go around; otherwise the matrices are multiplied one after the other, each by the threaded gemm.
+ * `algo` chooses between gemm and the Strassen recursion for every matrix product (see MatmulAlgo). */
+template <typename dtype, typename T, typename U>
+void matmul(
+    const dtype* larr, const Shape& lshape,
+    const T* rarr, const Shape& rshape, U* out,
+    const MatmulAlgo algo = MatmulAlgo::Standard
+) {
     size_t m,k,n;
 
     switch(Shape::get_matmul_type(lshape, rshape)) {
@@ -33,57 +113,150 @@ auto matmul(
         case MatmulType::MatMat:
             m = lshape[0]; k = lshape[1]; n = rshape[1];
             break;
+        case MatmulType::Batched: {
+            m = (lshape.get_Ndim() > 1) ? lshape[-2] : 1;
+            k = lshape[-1];
+            n = (rshape.get_Ndim() > 1) ? rshape[-1] : 1;
+
+            std::vector<size_t> batch_dims;
+            Shape::broadcast_batch_dims(lshape, rshape, &batch_dims);
+            const std::vector<size_t> l_offsets = get_batch_offsets(lshape, batch_dims);
+            const std::vector<size_t> r_offsets = get_batch_offsets(rshape, batch_dims);
+
+            const size_t grain = std::max<size_t>(1, gemm_parallel_grain / std::max<size_t>(1, m * n * k));
+            parallel_for(l_offsets.size(), grain, [&] (const size_t begin, const size_t end, size_t) {
+                for (size_t b = begin; b < end; b++)
+                    matmul_2d(larr + l_offsets[b], rarr + r_offsets[b], out + b * m * n, m, k, n, algo);
+            });
+            return;
+        }
         default:
             throw std::runtime_error("Unhandled MatmulType");
     }
 
-    for (int i = 0; i < m; i++) {
-        for (int t = 0; t < k; t++) {
-            for (int j = 0; j < n; j++) {
-                out[i * n + j] += larr[i * k + t] * rarr[t * n + j];
+    matmul_2d(larr, rarr, out, m, k, n, algo);
+}
+
+
+// Side of the tiles a transpose works through, so that a tile of the input and one of the output stay in cache
+constexpr size_t transpose_tile = 64;
+// Side of the small blocks within a tile that are transposed through a local buffer
+constexpr size_t transpose_block = 8;
+
+
+/* Transposes the block of rows [r0, r1) and columns [c0, c1) of the row-major rows x cols matrix `in` into
+ * the cols x rows matrix `out`. Full 8x8 blocks are read row by row into a local buffer and written out row
+ * by row, so every access is a contiguous run of 8 elements and the compiler can do the exchange in registers. */
+template <typename dtype>
+void transpose_tile_block(
+    const dtype* in, dtype* out, const size_t rows, const size_t cols,
+    const size_t r0, const size_t r1, const size_t c0, const size_t c1
+) {
+    constexpr size_t B = transpose_block;
+    for (size_t i0 = r0; i0 < r1; i0 += B) {
+        for (size_t j0 = c0; j0 < c1; j0 += B) {
+            if (i0 + B <= r1 && j0 + B <= c1) {
+                dtype block[B][B];
+                for (size_t i = 0; i < B; i++)
+                    for (size_t j = 0; j < B; j++) block[j][i] = in[(i0 + i) * cols + j0 + j];
+                for (size_t j = 0; j < B; j++)
+                    for (size_t i = 0; i < B; i++) out[(j0 + j) * rows + i0 + i] = block[j][i];
+            } else {
+                for (size_t j = j0; j < std::min(j0 + B, c1); j++)
+                    for (size_t i = i0; i < std::min(i0 + B, r1); i++) out[j * rows + i] = in[i * cols + j];
             }
         }
     }
+}
+
+
+/* Transposes the row-major rows x cols matrix `in` into `out`, tile by tile.
+ * Threads take contiguous ranges of tile columns of the input, which are tile rows of the output. */
+template <typename dtype>
+void transpose_tiled(const dtype* in, dtype* out, const size_t rows, const size_t cols) {
+    constexpr size_t T = transpose_tile;
+    const size_t col_tiles = (cols + T - 1) / T;
+    parallel_for(col_tiles, std::max<size_t>(1, (1 << 16) / (T * std::max<size_t>(1, rows))),
+        [&] (const size_t begin, const size_t end, size_t) {
+            for (size_t c0 = begin * T; c0 < std::min(end * T, cols); c0 += T)
+                for (size_t r0 = 0; r0 < rows; r0 += T)
+                    transpose_tile_block(in, out, rows, cols, r0, std::min(r0 + T, rows), c0, std::min(c0 + T, cols));
+        }
+    );
+}
+
+
+/* Transposes the square n x n matrix `arr` in place. The tiles on and above the diagonal are numbered row by
+ * row and split evenly across threads: a diagonal tile is transposed within itself, and any other tile swaps
+ * its elements with the mirrored tile below the diagonal. */
+template <typename dtype>
+void transpose_square(dtype* arr, const size_t n) {
+    constexpr size_t T = transpose_tile;
+    const size_t n_tiles = (n + T - 1) / T;
+    const size_t n_pairs = n_tiles * (n_tiles + 1) / 2;
+
+    parallel_for(n_pairs, std::max<size_t>(1, (1 << 16) / (T * T)), [&] (const size_t begin, const size_t end, size_t) {
+        // Find the tile (bi, bj), bj >= bi, numbered `begin`
+        size_t bi = 0, first = 0;
+        while (first + (n_tiles - bi) <= begin) first += n_tiles - bi++;
+        size_t bj = bi + (begin - first);
+
+        for (size_t t = begin; t < end; t++) {
+            const size_t i1 = std::min((bi + 1) * T, n), j1 = std::min((bj + 1) * T, n);
+            for (size_t i = bi * T; i < i1; i++)
+                for (size_t j = (bi == bj) ? i + 1 : bj * T; j < j1; j++) std::swap(arr[i * n + j], arr[j * n + i]);
+
+            if (++bj == n_tiles) bj = ++bi;
+        }
+    });
+}
 
-    return out;
+
+/* Transposes the non-square row-major rows x cols matrix `arr` in place by following the cycles of the
+ * permutation: the element at flat index p (other than the first and last) moves to p * rows mod (size - 1).
+ * Each cycle is walked once, with a bitmap recording the elements already moved. */
+template <typename dtype>
+void transpose_cycles(dtype* arr, const size_t rows, const size_t cols) {
+    const size_t size = rows * cols;
+    if (size < 3) return;
+
+    const size_t last = size - 1;
+    std::vector<bool> moved(size, false);
+    for (size_t start = 1; start < last; start++) {
+        if (moved[start]) continue;
+        dtype carried = arr[start];
+        size_t pos = start;
+        do {
+            pos = pos * rows % last;
+            std::swap(carried, arr[pos]);
+            moved[pos] = true;
+        } while (pos != start);
+    }
 }
 
 
 // Takes in an array, transposes it in place
+// Square matrices swap mirrored tiles; other shapes follow the cycles of the permutation
 template <typename dtype>
 void transpose(dtype* arr, const Shape& shape) {
     if(shape.get_Ndim() == 1) return;
-    
-    std::vector<dtype> temp(arr, arr + shape.get_total_size());
-    
+
     const size_t rows = shape[0];
     const size_t cols = shape[1];
 
-    for (int i = 0; i < rows; i++) {
-        for (int j = 0; j < cols; j++) {
-            arr[j * rows + i] = temp[i * cols + j];
-        }
-    }
+    if (rows == cols) transpose_square(arr, rows);
+    else if (rows != 1 && cols != 1) transpose_cycles(arr, rows, cols);
 }
 
 // Takes in the array where the transpose result will be stored, the data, and transposes the array using the data 
 template <typename dtype>
-void transpose(dtype* arr, dtype* data_in, const Shape& shape) {
+void transpose(dtype* arr, const dtype* data_in, const Shape& shape) {
     if (shape.get_Ndim() == 1) {
-        const size_t n = shape[0];
-        for (int i = 0; i < n; i++)
-            arr[i] = data_in[i];
+        std::copy(data_in, data_in + shape[0], arr);
         return;
     }
 
-    const size_t rows = shape[0];
-    const size_t cols = shape[1];
-
-    for (int i = 0; i < rows; i++) {
-        for (int j = 0; j < cols; j++) {
-            arr[j * rows + i] = data_in[i * cols + j];
-        }
-    }
+    transpose_tiled(data_in, arr, shape[0], shape[1]);
 }
 
 
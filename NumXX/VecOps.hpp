@@ -7,9 +7,10 @@
 
 namespace numxx {
 
-// Matrix-multiplication of two matrices
+// Matrix-multiplication of two matrices, or of stacks of matrices with broadcast batch dimensions
+// `algo` trades accuracy for speed on very large products (see MatmulAlgo)
 template <typename dtype, typename T>
-auto matmul(const NArray<dtype>& lmat, const NArray<T>& rmat)
+auto matmul(const NArray<dtype>& lmat, const NArray<T>& rmat, const MatmulAlgo algo = MatmulAlgo::Standard)
     -> NArray<decltype(std::declval<dtype>() * std::declval<T>())>
 {
     using U = decltype(std::declval<dtype>() * std::declval<T>());
@@ -18,13 +19,12 @@ auto matmul(const NArray<dtype>& lmat, const NArray<T>& rmat)
     if(!static_cast<bool>(Shape::get_matmul_type(lmat.get_shape(), rmat.get_shape()))) {
         throw error::ShapeError(lmat.get_shape(), rmat.get_shape(), "multiply");
     }
-    std::vector<U> out_data = util::matmul<dtype, T>(
+    NArray<U> out(Shape::get_product_shape(lmat.get_shape(), rmat.get_shape()));
+    util::matmul(
         lmat.get_data(), lmat.get_shape(),
-        rmat.get_data(), rmat.get_shape()
+        rmat.get_data(), rmat.get_shape(), out.get_data(), algo
     );
-    auto out_shape = Shape::get_product_shape(lmat.get_shape(), rmat.get_shape());
-
-    return NArray<U>(std::move(out_data), out_shape);
+    return out;
 }
 
 
@@ -41,12 +41,8 @@ auto dot(const NArray<A>& a, const NArray<B>& b)
         case MatmulType::Invalid:
             throw error::ShapeError(a.get_shape(), b.get_shape(), "dot");
 
-        case MatmulType::Dot: {
-            U sum = 0;
-            for(size_t i = 0; i < a.get_total_size(); i++)
-                sum += (a.get_data()[i] * b.get_data()[i]);
-            return NArray<U>(sum);
-        }
+        case MatmulType::Dot:
+            return NArray<U>(util::dot_1d(a.get_data(), b.get_data(), a.get_total_size()));
 
         case MatmulType::MatCol:
             return matmul(a,b);
@@ -0,0 +1,75 @@
+/* digitize.cpp */
+// digitize and bucketize over increasing, decreasing and single-edge bins
+#include <iostream>
+#include <limits>
+
+#include "NumXX.hpp"
+
+namespace nx = numxx;
+
+static int failures = 0;
+
+#define CHECK(cond) \
+    do { if (!(cond)) { std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #cond "\n"; failures++; } } while (0)
+
+
+bool equals(const nx::NArray<size_t>& arr, const std::vector<size_t>& expected) {
+    if (arr.get_total_size() != expected.size()) return false;
+    for (size_t i = 0; i < expected.size(); i++)
+        if (arr.get_data()[i] != expected[i]) return false;
+    return true;
+}
+
+template <typename F>
+bool throws_value_error(F f) {
+    try { f(); } catch (const nx::error::ValueError&) { return true; }
+    return false;
+}
+
+
+int main() {
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const nx::NArray<double> x(std::vector<double>{-1, 0, 0.5, 1, 2, 3, nan});
+
+    // Increasing bins
+    const nx::NArray<double> up(std::vector<double>{0, 1, 2});
+    CHECK(equals(nx::digitize(x, up), {0, 1, 1, 2, 3, 3, 3}));
+    CHECK(equals(nx::digitize(x, up, true), {0, 0, 1, 1, 2, 3, 3}));
+
+    // Decreasing bins are counted from the other end, and NaNs go to 0
+    const nx::NArray<double> down(std::vector<double>{2, 1, 0});
+    CHECK(equals(nx::digitize(x, down), {3, 2, 2, 1, 0, 0, 0}));
+    CHECK(equals(nx::digitize(x, down, true), {3, 3, 2, 2, 1, 0, 0}));
+
+    // A single edge, and repeated edges
+    const nx::NArray<double> y(std::vector<double>{0, 1, 2});
+    CHECK(equals(nx::digitize(y, nx::NArray<double>(std::vector<double>{1})), {0, 1, 1}));
+    CHECK(equals(nx::digitize(y, nx::NArray<double>(std::vector<double>{1}), true), {0, 0, 1}));
+    CHECK(equals(nx::digitize(y, nx::NArray<double>(std::vector<double>{1, 1})), {0, 2, 2}));
+
+    // The output keeps the shape of the input, across the parallel chunks
+    nx::NArray<int> big(nx::Shape{300, 200});
+    for (size_t i = 0; i < big.get_total_size(); i++) big.get_data()[i] = static_cast<int>(i % 7);
+    const auto bins = nx::digitize(big, nx::NArray<int>(std::vector<int>{5, 3, 1}));
+    CHECK(bins.get_shape() == big.get_shape());
+    bool all_match = true;
+    for (size_t i = 0; i < big.get_total_size(); i++) {
+        const int v = big.get_data()[i];
+        const size_t expected = v >= 5 ? 0 : v >= 3 ? 1 : v >= 1 ? 2 : 3;
+        all_match &= bins.get_data()[i] == expected;
+    }
+    CHECK(all_match);
+
+    // bucketize follows the torch convention
+    CHECK(equals(nx::bucketize(nx::NArray<double>(std::vector<double>{1, 2, 3, 6}),
+                               nx::NArray<double>(std::vector<double>{1, 3, 5})), {0, 1, 1, 3}));
+
+    // Bins that are empty or not monotonic are rejected, and histogram still needs two increasing edges
+    CHECK(throws_value_error([&] { nx::digitize(y, nx::NArray<double>(nx::Shape{0})); }));
+    CHECK(throws_value_error([&] { nx::digitize(y, nx::NArray<double>(std::vector<double>{0, 2, 1})); }));
+    CHECK(throws_value_error([&] { nx::histogram(y, nx::NArray<double>(std::vector<double>{1})); }));
+    CHECK(throws_value_error([&] { nx::histogram(y, down); }));
+
+    if (failures) std::cerr << failures << " check(s) failed\n";
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,168 @@
+/* einsum.cpp */
+// einsum and tensordot against a naive loop over every combination of the labels, on paths chosen by the
+// optimal search (up to einsum_optimal_limit operands) and by the greedy one (beyond it)
+#include <iostream>
+#include <map>
+#include <string>
+
+#include "NumXX.hpp"
+
+namespace nx = numxx;
+
+static int failures = 0;
+
+#define CHECK(cond) \
+    do { if (!(cond)) { std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #cond "\n"; failures++; } } while (0)
+
+
+// Small integers, so that every sum is exact whatever order the contraction takes
+nx::NArray<double> filled(const nx::Shape& shape, const int seed) {
+    nx::NArray<double> out(shape);
+    for (size_t i = 0; i < out.get_total_size(); i++)
+        out.get_data()[i] = static_cast<double>(static_cast<int>((i * 7 + seed * 3) % 5) - 2);
+    return out;
+}
+
+// Evaluates an explicit "in,in->out" expression by visiting every combination of the labels
+nx::NArray<double> naive_einsum(const std::string& subscripts, const std::vector<const nx::NArray<double>*>& ops) {
+    const size_t arrow = subscripts.find("->");
+    const std::string output = subscripts.substr(arrow + 2);
+    std::vector<std::string> inputs(1);
+    for (const char c : subscripts.substr(0, arrow)) {
+        if (c == ',') inputs.emplace_back();
+        else inputs.back() += c;
+    }
+
+    std::string labels;
+    std::map<char, size_t> sizes;
+    for (size_t i = 0; i < inputs.size(); i++)
+        for (size_t d = 0; d < inputs[i].size(); d++) {
+            if (!sizes.count(inputs[i][d])) labels += inputs[i][d];
+            sizes[inputs[i][d]] = ops[i]->get_shape()[d];
+        }
+
+    std::vector<size_t> out_dims;
+    for (const char c : output) out_dims.push_back(sizes[c]);
+    nx::NArray<double> out(out_dims.empty() ? nx::Shape({1}) : nx::Shape(out_dims), 0.0);
+
+    std::map<char, size_t> index;
+    for (const char c : labels) index[c] = 0;
+    while (true) {
+        double product = 1;
+        for (size_t i = 0; i < inputs.size(); i++) {
+            size_t offset = 0;
+            for (size_t d = 0; d < inputs[i].size(); d++) offset = offset * sizes[inputs[i][d]] + index[inputs[i][d]];
+            product *= ops[i]->get_data()[offset];
+        }
+        size_t offset = 0;
+        for (const char c : output) offset = offset * sizes[c] + index[c];
+        out.get_data()[offset] += product;
+
+        size_t l = labels.size();
+        while (l > 0 && ++index[labels[l - 1]] == sizes[labels[l - 1]]) index[labels[--l]] = 0;
+        if (l == 0) break;
+    }
+    return out;
+}
+
+bool same_values(const nx::NArray<double>& a, const nx::NArray<double>& b) {
+    if (a.get_total_size() != b.get_total_size()) return false;
+    for (size_t i = 0; i < a.get_total_size(); i++)
+        if (a.get_data()[i] != b.get_data()[i]) return false;
+    return true;
+}
+
+// einsum on `subscripts` matches the naive evaluation of `explicit_subscripts` in values and, if it has any axes,
+// in shape
+bool matches(const std::string& subscripts, const std::string& explicit_subscripts,
+             const std::vector<nx::NArray<double>>& operands) {
+    std::vector<const nx::NArray<double>*> pointers;
+    for (const auto& op : operands) pointers.push_back(&op);
+    const auto result = nx::einsum(subscripts, operands);
+    const auto expected = naive_einsum(explicit_subscripts, pointers);
+    const bool scalar = explicit_subscripts.substr(explicit_subscripts.find("->") + 2).empty();
+    return same_values(result, expected) && (scalar || result.get_shape() == expected.get_shape());
+}
+
+bool matches(const std::string& subscripts, const std::vector<nx::NArray<double>>& operands) {
+    return matches(subscripts, subscripts, operands);
+}
+
+
+int main() {
+    const auto a = filled(nx::Shape({4, 5}), 1), b = filled(nx::Shape({5, 3}), 2), c = filled(nx::Shape({3, 6}), 3);
+    const auto sq = filled(nx::Shape({5, 5}), 4), v = filled(nx::Shape({5}), 5), w = filled(nx::Shape({4}), 6);
+    const auto a2 = filled(nx::Shape({4, 5}), 7);
+
+    // Matrix product, also against matmul, and with the output left implicit
+    CHECK(matches("ij,jk->ik", {a, b}));
+    CHECK(same_values(nx::einsum("ij,jk->ik", a, b), nx::matmul(a, b)));
+    CHECK(matches("ij,jk", "ij,jk->ik", {a, b}));
+    CHECK(matches("ji,jk", "ji,jk->ik", {b, filled(nx::Shape({5, 2}), 8)}));
+
+    // Diagonals: the trace and the diagonal itself
+    CHECK(matches("ii->", {sq}));
+    CHECK(matches("ii->i", {sq}));
+    CHECK(matches("ii", "ii->", {sq}));
+    CHECK(matches("iij->j", {filled(nx::Shape({3, 3, 4}), 9)}));
+
+    // Transpose, outer, Hadamard and matrix-vector products
+    CHECK(matches("ij->ji", {a}));
+    CHECK(matches("i,j->ij", {w, v}));
+    CHECK(matches("ij,ij->ij", {a, a2}));
+    CHECK(matches("ij,j->i", {a, v}));
+    CHECK(matches("i,ij->j", {w, a}));
+
+    // Full reductions
+    CHECK(matches("ij->", {a}));
+    CHECK(matches("ij,ij->", {a, a2}));
+    CHECK(matches("i,i", "i,i->", {v, v}));
+
+    // Batched products, with the batch label kept or summed
+    const auto x = filled(nx::Shape({3, 4, 5}), 1), y = filled(nx::Shape({3, 5, 2}), 2);
+    CHECK(matches("bij,bjk->bik", {x, y}));
+    CHECK(matches("bij,bjk->ik", {x, y}));
+    CHECK(matches("bij,bjk->kbi", {x, y}));
+
+    // Three to eight operands take the optimal path
+    CHECK(matches("ij,jk,kl->il", {a, b, c}));
+    CHECK(matches("ij,jk,kl", "ij,jk,kl->il", {a, b, c}));
+    CHECK(matches("ij,jk,ki->", {a, b, filled(nx::Shape({3, 4}), 4)}));
+    CHECK(matches("ab,bc,cd,de,ef,fg,gh,hi->ai", {
+        filled(nx::Shape({2, 3}), 1), filled(nx::Shape({3, 4}), 2), filled(nx::Shape({4, 2}), 3),
+        filled(nx::Shape({2, 3}), 4), filled(nx::Shape({3, 3}), 5), filled(nx::Shape({3, 2}), 6),
+        filled(nx::Shape({2, 4}), 7), filled(nx::Shape({4, 3}), 8)}));
+
+    // Ten operands take the greedy path: a chain, and a chain with a shared batch label and an outer factor
+    std::vector<nx::NArray<double>> chain;
+    const size_t dims[] = {2, 3, 4, 3, 2, 3, 2, 4, 3, 2, 3};
+    for (int i = 0; i < 10; i++) chain.push_back(filled(nx::Shape({dims[i], dims[i + 1]}), i));
+    CHECK(matches("ab,bc,cd,de,ef,fg,gh,hi,ij,jk->ak", chain));
+    CHECK(matches("ab,bc,cd,de,ef,fg,gh,hi,ij,jk", "ab,bc,cd,de,ef,fg,gh,hi,ij,jk->ak", chain));
+    CHECK(matches("ab,bc,cd,de,ef,fg,gh,hi,ij,jk->", chain));
+
+    std::vector<nx::NArray<double>> batched;
+    for (int i = 0; i < 9; i++) batched.push_back(filled(nx::Shape({2, dims[i], dims[i + 1]}), i));
+    batched.push_back(filled(nx::Shape({3}), 10));
+    CHECK(matches("zab,zbc,zcd,zde,zef,zfg,zgh,zhi,zij,y->zajy", batched));
+
+    // tensordot: over the last two axes of a and the first two of b, over chosen axes, and as an outer product
+    const auto t = filled(nx::Shape({3, 4, 5}), 1), u = filled(nx::Shape({4, 5, 2}), 2);
+    const auto t2 = filled(nx::Shape({5, 3, 4}), 3);
+    CHECK(same_values(nx::tensordot(t, u, 2), naive_einsum("ijk,jkl->il", {&t, &u})));
+    CHECK((nx::tensordot(t, u, 2).get_shape() == nx::Shape({3, 2})));
+    CHECK(same_values(nx::tensordot(t, t2, {0, 2}, {1, 0}), naive_einsum("ijk,kil->jl", {&t, &t2})));
+    CHECK(same_values(nx::tensordot(w, v, 0), naive_einsum("i,j->ij", {&w, &v})));
+
+    // Mismatched dimensions for a label, and the wrong number of operands
+    bool threw = false;
+    try { (void) nx::einsum("ij,jk->ik", a, c); } catch (const nx::error::ValueError&) { threw = true; }
+    catch (const nx::error::ShapeError&) { threw = true; }
+    CHECK(threw);
+    threw = false;
+    try { (void) nx::einsum("ij,jk->ik", a); } catch (const nx::error::ValueError&) { threw = true; }
+    CHECK(threw);
+
+    if (failures) std::cerr << failures << " check(s) failed\n";
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,157 @@
+/* iterative.cpp */
+// cg, bicgstab and gmres on sparse, dense and matrix-free operators, with and without preconditioners, for real
+// and complex systems. Every result must report the true relative residual ||b - A * x|| / ||b||
+#include <iostream>
+
+#include "NumXX.hpp"
+
+namespace nx = numxx;
+namespace la = numxx::linalg;
+using cd = nx::complex<double>;
+
+static int failures = 0;
+
+#define CHECK(cond) \
+    do { if (!(cond)) { std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #cond "\n"; failures++; } } while (0)
+
+
+// A tridiagonal n x n matrix with `diag` on the diagonal, `lower` below it and `upper` above it
+template <typename T>
+nx::sparse::CSR<T> tridiagonal(const size_t n, const T diag, const T lower, const T upper) {
+    nx::sparse::COO<T> coo(n, n);
+    for (size_t i = 0; i < n; i++) {
+        coo.insert(i, i, diag);
+        if (i > 0) coo.insert(i, i - 1, lower);
+        if (i + 1 < n) coo.insert(i, i + 1, upper);
+    }
+    return coo.to_csr();
+}
+
+template <typename T>
+nx::NArray<T> right_hand_side(const size_t n) {
+    nx::NArray<T> b(nx::Shape({n}));
+    for (size_t i = 0; i < n; i++) {
+        if constexpr (nx::is_complex_v<T>) b.get_data()[i] = T(std::sin(0.1 * i) + 1.0, std::cos(0.3 * i));
+        else b.get_data()[i] = T(std::sin(0.1 * static_cast<double>(i)) + 1.0);
+    }
+    return b;
+}
+
+// ||b - A * x|| / ||b||, with A applied by op(x, y)
+template <typename T, typename Op>
+double true_residual(const Op& op, const nx::NArray<T>& b, const nx::NArray<T>& x) {
+    const size_t n = b.get_total_size();
+    std::vector<T> ax(n);
+    op(x.get_data(), ax.data());
+    double r = 0, norm_b = 0;
+    for (size_t i = 0; i < n; i++) {
+        r += std::pow(static_cast<double>(nx::abs(b.get_data()[i] - ax[i])), 2);
+        norm_b += std::pow(static_cast<double>(nx::abs(b.get_data()[i])), 2);
+    }
+    return std::sqrt(r / norm_b);
+}
+
+// The result converged to `tol` and reports its true residual
+template <typename T, typename Op>
+bool solved(const la::IterativeResult<T>& result, const Op& op, const nx::NArray<T>& b, const double tol) {
+    const double truth = true_residual(op, b, result.x);
+    const double reported = static_cast<double>(result.residual);
+    return result.converged && reported <= tol && std::abs(reported - truth) <= 1e-6 * truth + 1e-15;
+}
+
+
+int main() {
+    constexpr double tol = 1e-8;
+
+    // Sparse SPD tridiagonal system by cg: from the CSR and CSC matrices, and as a user callable with ILU(0)
+    {
+        const size_t n = 2000;
+        const auto a = tridiagonal<double>(n, 2.5, -1.0, -1.0);
+        const auto b = right_hand_side<double>(n);
+        const auto op = [&a] (const double* x, double* y) { a.spmv(x, y); };
+
+        const auto plain = la::cg(a, b, la::IdentityPreconditioner(), tol);
+        CHECK(solved(plain, op, b, tol));
+        CHECK(solved(la::cg(a.to_csc(), b, la::IdentityPreconditioner(), tol), op, b, tol));
+
+        // ILU(0) of a tridiagonal matrix is its exact LU, so a single iteration is enough
+        const la::ILU0Preconditioner<double> ilu(a);
+        const auto preconditioned = la::cg(op, b, ilu, tol);
+        CHECK(solved(preconditioned, op, b, tol));
+        CHECK(preconditioned.iterations <= 2);
+        CHECK(preconditioned.iterations < plain.iterations);
+
+        // Too few iterations: not converged, but the residual is still the true one
+        const auto stopped = la::cg(a, b, la::IdentityPreconditioner(), tol, 3);
+        CHECK(!stopped.converged);
+        CHECK(stopped.iterations == 3);
+        CHECK(std::abs(stopped.residual - true_residual(op, b, stopped.x)) <= 1e-6 * stopped.residual);
+
+        // A starting guess that already solves the system
+        const auto restarted = la::cg(a, b, la::IdentityPreconditioner(), tol, 0, plain.x);
+        CHECK(solved(restarted, op, b, tol));
+        CHECK(restarted.iterations <= 1);
+    }
+
+    // Nonsymmetric sparse system with badly scaled rows by bicgstab, with a Jacobi preconditioner
+    {
+        const size_t n = 1500;
+        auto a = tridiagonal<double>(n, 4.0, -1.5, -0.5);
+        nx::NArray<double> scale(nx::Shape({n}));
+        for (size_t i = 0; i < n; i++) scale.get_data()[i] = (i % 3 == 0) ? 1000.0 : 1.0;
+        a.scale_rows(scale);
+        const auto b = right_hand_side<double>(n);
+        const auto op = [&a] (const double* x, double* y) { a.spmv(x, y); };
+
+        const auto result = la::bicgstab(a, b, la::JacobiPreconditioner<double>(a), tol);
+        CHECK(solved(result, op, b, tol));
+        CHECK(solved(la::gmres(a, b, la::JacobiPreconditioner<double>(a), tol), op, b, tol));
+    }
+
+    // Dense nonsymmetric system by gmres with a restart much smaller than n
+    {
+        const size_t n = 150;
+        nx::NArray<double> a(nx::Shape({n, n}));
+        for (size_t i = 0; i < n; i++)
+            for (size_t j = 0; j < n; j++)
+                a.get_data()[i * n + j] = (i == j) ? 3.0 : std::sin(static_cast<double>(i * n + 3 * j)) / std::sqrt(n);
+        const auto b = right_hand_side<double>(n);
+        const auto op = [&a, n] (const double* x, double* y) {
+            for (size_t i = 0; i < n; i++) {
+                y[i] = 0;
+                for (size_t j = 0; j < n; j++) y[i] += a.get_data()[i * n + j] * x[j];
+            }
+        };
+
+        const auto restarted = la::gmres(a, b, la::IdentityPreconditioner(), tol, 0, nx::NArray<double>(), 5);
+        CHECK(solved(restarted, op, b, tol));
+        CHECK(solved(la::gmres(a, b, la::JacobiPreconditioner<double>(a), tol, 0, nx::NArray<double>(), 8), op, b, tol));
+        CHECK(solved(la::bicgstab(a, b, la::IdentityPreconditioner(), tol), op, b, tol));
+    }
+
+    // Complex systems: a non-Hermitian sparse one by gmres and bicgstab, a Hermitian one by cg
+    {
+        const size_t n = 800;
+        const auto a = tridiagonal<cd>(n, cd(4.0, 1.0), cd(-1.0, 0.5), cd(-0.5, -1.0));
+        const auto b = right_hand_side<cd>(n);
+        const auto op = [&a] (const cd* x, cd* y) { a.spmv(x, y); };
+
+        CHECK(solved(la::gmres(a, b, la::IdentityPreconditioner(), tol, 0, nx::NArray<cd>(), 20), op, b, tol));
+        CHECK(solved(la::bicgstab(a, b, la::IdentityPreconditioner(), tol), op, b, tol));
+        CHECK(solved(la::bicgstab(op, b, la::JacobiPreconditioner<cd>(a), tol), op, b, tol));
+
+        const auto h = tridiagonal<cd>(n, cd(3.0, 0.0), cd(-1.0, 0.5), cd(-1.0, -0.5));
+        const auto h_op = [&h] (const cd* x, cd* y) { h.spmv(x, y); };
+        CHECK(solved(la::cg(h, b, la::IdentityPreconditioner(), tol), h_op, b, tol));
+        CHECK(solved(la::cg(h, b, la::ILU0Preconditioner<cd>(h), tol), h_op, b, tol));
+    }
+
+    // The right-hand side is checked against the operator
+    bool threw = false;
+    try { (void) la::cg(tridiagonal<double>(4, 2.0, -1.0, -1.0), nx::NArray<double>(nx::Shape({5}), 1.0)); }
+    catch (const nx::error::ShapeError&) { threw = true; }
+    CHECK(threw);
+
+    if (failures) std::cerr << failures << " check(s) failed\n";
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,178 @@
+/* linalg_eigen.cpp */
+// eigh, eigvalsh, svd and svdvals on real and complex matrices, checked through their defining identities
+#include <iostream>
+
+#include "NumXX.hpp"
+
+namespace nx = numxx;
+using cd = nx::complex<double>;
+
+static int failures = 0;
+
+#define CHECK(cond) \
+    do { if (!(cond)) { std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #cond "\n"; failures++; } } while (0)
+
+
+// Deterministic values in [-1, 1)
+struct Lcg {
+    unsigned long long state;
+    double next() {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return static_cast<double>(state >> 11) / static_cast<double>(1ULL << 52) - 1.0;
+    }
+};
+
+template <typename T>
+T random_value(Lcg& rng) {
+    if constexpr (nx::is_complex_v<T>) {
+        const double re = rng.next();
+        return T(re, rng.next());
+    } else {
+        return T(rng.next());
+    }
+}
+
+template <typename T>
+nx::NArray<T> random_matrix(const size_t m, const size_t n, Lcg& rng) {
+    nx::NArray<T> out(nx::Shape({m, n}));
+    for (size_t i = 0; i < m * n; i++) out.get_data()[i] = random_value<T>(rng);
+    return out;
+}
+
+// A random n x n Hermitian (symmetric, if real) matrix
+template <typename T>
+nx::NArray<T> random_hermitian(const size_t n, Lcg& rng) {
+    nx::NArray<T> out(nx::Shape({n, n}));
+    T* a = out.get_data();
+    for (size_t i = 0; i < n; i++) {
+        a[i * n + i] = T(rng.next());
+        for (size_t j = 0; j < i; j++) {
+            a[i * n + j] = random_value<T>(rng);
+            a[j * n + i] = nx::conj(a[i * n + j]);
+        }
+    }
+    return out;
+}
+
+template <typename T>
+double magnitude(const T& x) { return static_cast<double>(nx::abs(x)); }
+
+// Largest |A^H * A - I| over the columns of a row-major m x n matrix A
+template <typename T>
+double orthonormality_error(const T* a, const size_t m, const size_t n) {
+    double err = 0;
+    for (size_t p = 0; p < n; p++)
+        for (size_t q = 0; q < n; q++) {
+            T s(0);
+            for (size_t i = 0; i < m; i++) s += nx::conj(a[i * n + p]) * a[i * n + q];
+            err = std::max(err, magnitude(s - T(p == q ? 1 : 0)));
+        }
+    return err;
+}
+
+
+// A * V = V * diag(w), V^H * V = I, w ascending and eigvalsh(A) = w
+template <typename T>
+void check_eigh(const nx::NArray<T>& mat) {
+    const size_t n = mat.get_shape()[0];
+    const double tol = 1e-12 * static_cast<double>(n + 1);
+    const auto [w, v] = nx::linalg::eigh(mat);
+    const T* a = mat.get_data();
+    const T* vec = v.get_data();
+
+    double residual = 0;
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = 0; j < n; j++) {
+            T av(0);
+            for (size_t t = 0; t < n; t++) av += a[i * n + t] * vec[t * n + j];
+            residual = std::max(residual, magnitude(av - vec[i * n + j] * T(w.get_data()[j])));
+        }
+    CHECK(residual < tol * 10);
+    CHECK(orthonormality_error(vec, n, n) < tol);
+
+    bool ascending = true;
+    for (size_t i = 1; i < n; i++) ascending &= w.get_data()[i - 1] <= w.get_data()[i];
+    CHECK(ascending);
+
+    const auto values = nx::linalg::eigvalsh(mat);
+    double diff = 0;
+    for (size_t i = 0; i < n; i++) diff = std::max(diff, std::abs(values.get_data()[i] - w.get_data()[i]));
+    CHECK(diff < tol * 10);
+}
+
+
+// U * diag(S) * Vh = A, U and Vh^H orthonormal, S descending and non-negative, and svdvals(A) = S
+template <typename T>
+void check_svd(const nx::NArray<T>& mat) {
+    const size_t m = mat.get_shape()[0], n = mat.get_shape()[1], k = std::min(m, n);
+    const double tol = 1e-12 * static_cast<double>(m + n);
+
+    for (const bool full : {false, true}) {
+        const auto [u, s, vh] = nx::linalg::svd(mat, full);
+        const size_t u_cols = full ? m : k, vh_rows = full ? n : k;
+        CHECK(u.get_shape() == nx::Shape({m, u_cols}));
+        CHECK(s.get_shape() == nx::Shape({k}));
+        CHECK(vh.get_shape() == nx::Shape({vh_rows, n}));
+
+        double residual = 0;
+        for (size_t i = 0; i < m; i++)
+            for (size_t j = 0; j < n; j++) {
+                T usv(0);
+                for (size_t t = 0; t < k; t++)
+                    usv += u.get_data()[i * u_cols + t] * T(s.get_data()[t]) * vh.get_data()[t * n + j];
+                residual = std::max(residual, magnitude(usv - mat.get_data()[i * n + j]));
+            }
+        CHECK(residual < tol * 10);
+        CHECK(orthonormality_error(u.get_data(), m, u_cols) < tol);
+
+        // The rows of Vh are orthonormal: check the columns of its conjugate transpose
+        std::vector<T> v(n * vh_rows);
+        for (size_t i = 0; i < vh_rows; i++)
+            for (size_t j = 0; j < n; j++) v[j * vh_rows + i] = nx::conj(vh.get_data()[i * n + j]);
+        CHECK(orthonormality_error(v.data(), n, vh_rows) < tol);
+
+        bool descending = s.get_data()[k - 1] >= 0;
+        for (size_t i = 1; i < k; i++) descending &= s.get_data()[i - 1] >= s.get_data()[i];
+        CHECK(descending);
+
+        const auto values = nx::linalg::svdvals(mat);
+        double diff = 0;
+        for (size_t i = 0; i < k; i++) diff = std::max(diff, std::abs(values.get_data()[i] - s.get_data()[i]));
+        CHECK(diff < tol * 10);
+    }
+}
+
+
+int main() {
+    Lcg rng{42};
+
+    for (const size_t n : {1, 2, 5, 33, 70, 150}) check_eigh(random_hermitian<double>(n, rng));
+    for (const size_t n : {1, 4, 40, 90}) check_eigh(random_hermitian<cd>(n, rng));
+
+    // Repeated eigenvalues: the identity scaled, and a diagonal matrix with a double eigenvalue
+    nx::NArray<double> scaled(nx::Shape({10, 10}), 0.0);
+    for (size_t i = 0; i < 10; i++) scaled.get_data()[i * 10 + i] = 3.0;
+    check_eigh(scaled);
+    const auto [w, v] = nx::linalg::eigh(scaled);
+    for (size_t i = 0; i < 10; i++) CHECK(std::abs(w.get_data()[i] - 3.0) < 1e-14);
+    check_eigh(nx::NArray<double>(std::vector<double>{2, 0, 0, 0, -1, 0, 0, 0, 2}, nx::Shape({3, 3})));
+
+    // Integer matrices are decomposed in double precision
+    const auto int_eigvals = nx::linalg::eigvalsh(nx::NArray<int>(std::vector<int>{2, 1, 1, 2}, nx::Shape({2, 2})));
+    CHECK(std::abs(int_eigvals.get_data()[0] - 1.0) < 1e-14 && std::abs(int_eigvals.get_data()[1] - 3.0) < 1e-14);
+
+    const std::vector<std::pair<size_t, size_t>> shapes{{5, 3}, {3, 5}, {40, 17}, {17, 40}, {130, 60}, {1, 1}, {6, 6}};
+    for (const auto& [m, n] : shapes) check_svd(random_matrix<double>(m, n, rng));
+    for (const auto& [m, n] : {std::pair<size_t, size_t>{30, 20}, {20, 30}, {8, 8}}) check_svd(random_matrix<cd>(m, n, rng));
+
+    // A rank-deficient matrix has zero singular values
+    nx::NArray<double> rank_one(nx::Shape({6, 4}));
+    for (size_t i = 0; i < 6; i++)
+        for (size_t j = 0; j < 4; j++) rank_one.get_data()[i * 4 + j] = static_cast<double>((i + 1) * (j + 2));
+    check_svd(rank_one);
+    const auto rank_one_s = nx::linalg::svdvals(rank_one);
+    for (size_t i = 1; i < 4; i++) CHECK(rank_one_s.get_data()[i] < 1e-12 * rank_one_s.get_data()[0]);
+
+    if (failures) std::cerr << failures << " check(s) failed\n";
+    return failures ? 1 : 0;
+}
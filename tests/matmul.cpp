@@ -0,0 +1,131 @@
+/* matmul.cpp */
+// Matrix products against naive loops: the packed gemm with edge tiles and its 2D thread grid, gemv, gemv_t,
+// dot, broadcast batched matmul, and the in-place transpose of a non-square array
+#include <iostream>
+
+#include "NumXX.hpp"
+
+namespace nx = numxx;
+using cd = nx::complex<double>;
+
+static int failures = 0;
+
+#define CHECK(cond) \
+    do { if (!(cond)) { std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #cond "\n"; failures++; } } while (0)
+
+
+// Small integers, so that every product below is exact and the order of the sums does not matter
+template <typename T>
+nx::NArray<T> filled(const nx::Shape& shape, const int seed) {
+    nx::NArray<T> out(shape);
+    for (size_t i = 0; i < out.get_total_size(); i++)
+        out.get_data()[i] = T(static_cast<int>((i * 7 + seed) % 11) - 5);
+    return out;
+}
+
+template <>
+nx::NArray<cd> filled(const nx::Shape& shape, const int seed) {
+    nx::NArray<cd> out(shape);
+    for (size_t i = 0; i < out.get_total_size(); i++)
+        out.get_data()[i] = cd(static_cast<int>((i * 7 + seed) % 11) - 5, static_cast<int>((i * 3 + seed) % 5) - 2);
+    return out;
+}
+
+// The m x n product of the row-major m x k matrix a and k x n matrix b
+template <typename T>
+std::vector<T> naive_matmul(const T* a, const T* b, const size_t m, const size_t k, const size_t n) {
+    std::vector<T> out(m * n, T(0));
+    for (size_t i = 0; i < m; i++)
+        for (size_t t = 0; t < k; t++)
+            for (size_t j = 0; j < n; j++) out[i * n + j] += a[i * k + t] * b[t * n + j];
+    return out;
+}
+
+template <typename T>
+bool equals(const T* data, const std::vector<T>& expected) {
+    for (size_t i = 0; i < expected.size(); i++)
+        if (!(data[i] == expected[i])) return false;
+    return true;
+}
+
+// Checks matmul of an m x k by a k x n matrix against the naive product
+template <typename T>
+bool matmul_matches(const size_t m, const size_t k, const size_t n) {
+    const auto a = filled<T>(nx::Shape{m, k}, 1), b = filled<T>(nx::Shape{k, n}, 4);
+    const auto c = nx::matmul(a, b);
+    return c.get_shape() == nx::Shape({m, n}) && equals(c.get_data(), naive_matmul(a.get_data(), b.get_data(), m, k, n));
+}
+
+
+int main() {
+    for (const size_t threads : {1, 4}) {
+        // With four threads the larger products are split over a 2 x 2 grid of C
+        nx::set_num_threads(threads);
+
+        // Packed gemm, with edge tiles in every dimension, and with several kc and nc blocks
+        CHECK(matmul_matches<double>(300, 257, 311));
+        CHECK(matmul_matches<float>(300, 257, 311));
+        CHECK(matmul_matches<cd>(67, 131, 45));
+        CHECK(matmul_matches<int>(129, 65, 97));
+        CHECK(matmul_matches<double>(40, 600, 2100));
+
+        // Unpacked small products, and products with a single row or column of C (gemv_t and gemv)
+        CHECK(matmul_matches<double>(5, 7, 3));
+        CHECK(matmul_matches<double>(1, 300, 200));
+        CHECK(matmul_matches<double>(200, 300, 1));
+        CHECK(matmul_matches<cd>(1, 70, 90));
+
+        // Matrix times vector and vector times matrix
+        const auto mat = filled<double>(nx::Shape{300, 250}, 2);
+        const auto col = filled<double>(nx::Shape{250}, 5), row = filled<double>(nx::Shape{300}, 6);
+        const auto mv = nx::matmul(mat, col), vm = nx::matmul(row, mat);
+        CHECK(mv.get_shape() == nx::Shape({300}));
+        CHECK(vm.get_shape() == nx::Shape({250}));
+        CHECK(equals(mv.get_data(), naive_matmul(mat.get_data(), col.get_data(), 300, 250, 1)));
+        CHECK(equals(vm.get_data(), naive_matmul(row.get_data(), mat.get_data(), 1, 300, 250)));
+
+        // Dot product long enough to be split into partial sums
+        const auto x = filled<double>(nx::Shape{200003}, 3), y = filled<double>(nx::Shape{200003}, 8);
+        double expected = 0;
+        for (size_t i = 0; i < x.get_total_size(); i++) expected += x.get_data()[i] * y.get_data()[i];
+        CHECK(nx::dot(x, y).get_data()[0] == expected);
+
+        // Batched matmul with a broadcast batch dimension: (2, 3, 4, 5) @ (3, 5, 6) -> (2, 3, 4, 6)
+        const auto l = filled<double>(nx::Shape{2, 3, 4, 5}, 1), r = filled<double>(nx::Shape{3, 5, 6}, 2);
+        const auto batched = nx::matmul(l, r);
+        CHECK(batched.get_shape() == nx::Shape({2, 3, 4, 6}));
+        for (size_t i = 0; i < 2; i++) {
+            for (size_t j = 0; j < 3; j++) {
+                const auto c = naive_matmul(l.get_data() + (i * 3 + j) * 20, r.get_data() + j * 30, 4, 5, 6);
+                CHECK(equals(batched.get_data() + (i * 3 + j) * 24, c));
+            }
+        }
+
+        // Batch dimension of 1 broadcast against the other operand: (1, 4, 5) @ (3, 5, 6) -> (3, 4, 6)
+        const auto single = filled<double>(nx::Shape{1, 4, 5}, 7);
+        const auto broadcast = nx::matmul(single, r);
+        CHECK(broadcast.get_shape() == nx::Shape({3, 4, 6}));
+        for (size_t j = 0; j < 3; j++)
+            CHECK(equals(broadcast.get_data() + j * 24, naive_matmul(single.get_data(), r.get_data() + j * 30, 4, 5, 6)));
+
+        // In-place transpose of non-square arrays, small and tiled
+        for (const auto& shape : {nx::Shape{3, 5}, nx::Shape{37, 53}, nx::Shape{300, 170}}) {
+            const auto original = filled<double>(shape, 9);
+            const auto expected_t = original.transpose();
+            auto t = filled<double>(shape, 9);
+            t.transpose_inplace();
+            CHECK(t.get_shape() == nx::Shape({shape[1], shape[0]}));
+            bool ok = true;
+            for (size_t i = 0; i < shape[0]; i++)
+                for (size_t j = 0; j < shape[1]; j++) {
+                    ok &= t.get_data()[j * shape[0] + i] == original.get_data()[i * shape[1] + j];
+                    ok &= t.get_data()[j * shape[0] + i] == expected_t.get_data()[j * shape[0] + i];
+                }
+            CHECK(ok);
+        }
+    }
+    nx::set_num_threads(0);
+
+    if (failures) std::cerr << failures << " check(s) failed\n";
+    return failures ? 1 : 0;
+}
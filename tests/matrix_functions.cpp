@@ -0,0 +1,146 @@
+/* matrix_functions.cpp */
+// expm against the eigendecomposition of symmetric matrices, at norms that select every Padé degree and that
+// need scaling and squaring, and matrix_power against repeated products
+#include <iostream>
+
+#include "NumXX.hpp"
+
+namespace nx = numxx;
+namespace la = numxx::linalg;
+using cd = nx::complex<double>;
+
+static int failures = 0;
+
+#define CHECK(cond) \
+    do { if (!(cond)) { std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #cond "\n"; failures++; } } while (0)
+
+
+// Largest |a - b| relative to the largest |b|
+template <typename T>
+double relative_error(const nx::NArray<T>& a, const nx::NArray<T>& b) {
+    double err = 0, scale = 0;
+    for (size_t i = 0; i < b.get_total_size(); i++) {
+        err = std::max(err, static_cast<double>(nx::abs(a.get_data()[i] - b.get_data()[i])));
+        scale = std::max(scale, static_cast<double>(nx::abs(b.get_data()[i])));
+    }
+    return err / scale;
+}
+
+template <typename T>
+nx::NArray<T> naive_product(const nx::NArray<T>& a, const nx::NArray<T>& b) {
+    const size_t n = a.get_shape()[0];
+    nx::NArray<T> out(a.get_shape(), T(0));
+    for (size_t i = 0; i < n; i++)
+        for (size_t t = 0; t < n; t++)
+            for (size_t j = 0; j < n; j++) out.get_data()[i * n + j] += a.get_data()[i * n + t] * b.get_data()[t * n + j];
+    return out;
+}
+
+template <typename T>
+nx::NArray<T> identity(const size_t n) {
+    nx::NArray<T> out(nx::Shape({n, n}), T(0));
+    for (size_t i = 0; i < n; i++) out.get_data()[i * n + i] = T(1);
+    return out;
+}
+
+// The p-th power of a matrix by p - 1 products, for p >= 1
+template <typename T>
+nx::NArray<T> naive_power(const nx::NArray<T>& a, const int p) {
+    return (p == 1) ? naive_product(a, identity<T>(a.get_shape()[0])) : naive_product(naive_power(a, p - 1), a);
+}
+
+
+// A symmetric n x n matrix with 1-norm `norm`
+nx::NArray<double> symmetric_with_norm(const size_t n, const double norm) {
+    nx::NArray<double> a(nx::Shape({n, n}));
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = 0; j <= i; j++) {
+            const double v = std::sin(static_cast<double>(3 * i + 7 * j + 1));
+            a.get_data()[i * n + j] = a.get_data()[j * n + i] = v;
+        }
+    double current = 0;
+    for (size_t j = 0; j < n; j++) {
+        double column = 0;
+        for (size_t i = 0; i < n; i++) column += std::abs(a.get_data()[i * n + j]);
+        current = std::max(current, column);
+    }
+    for (auto& x : a) x *= norm / current;
+    return a;
+}
+
+// V * exp(diag(w)) * V^T, from the eigendecomposition of a symmetric matrix
+nx::NArray<double> exp_by_eigh(const nx::NArray<double>& a) {
+    const size_t n = a.get_shape()[0];
+    const auto [w, v] = la::eigh(a);
+    nx::NArray<double> out(a.get_shape(), 0.0);
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = 0; j < n; j++)
+            for (size_t k = 0; k < n; k++)
+                out.get_data()[i * n + j] += v.get_data()[i * n + k] * std::exp(w.get_data()[k]) * v.get_data()[j * n + k];
+    return out;
+}
+
+
+int main() {
+    // Norms just below the bounds for degrees 3, 5, 7, 9 and 13, and far above the last, which needs squaring
+    for (const double norm : {0.01, 0.2, 0.9, 2.0, 5.0, 40.0, 300.0}) {
+        for (const size_t n : {1, 6, 40}) {
+            const auto a = symmetric_with_norm(n, norm);
+            CHECK(relative_error(la::expm(a), exp_by_eigh(a)) < 1e-11 * std::max(1.0, norm));
+        }
+    }
+
+    // Exact cases: zero, a diagonal matrix, a nilpotent one, and an integer one computed in double precision
+    CHECK(relative_error(la::expm(nx::NArray<double>(nx::Shape({4, 4}), 0.0)), identity<double>(4)) == 0);
+    const auto diag = la::expm(nx::NArray<double>(std::vector<double>{1, 0, 0, -2}, nx::Shape({2, 2})));
+    CHECK(relative_error(diag, nx::NArray<double>(std::vector<double>{std::exp(1.0), 0, 0, std::exp(-2.0)}, nx::Shape({2, 2}))) < 1e-15);
+    const auto nilpotent = la::expm(nx::NArray<double>(std::vector<double>{0, 3, 0, 0}, nx::Shape({2, 2})));
+    CHECK(relative_error(nilpotent, nx::NArray<double>(std::vector<double>{1, 3, 0, 1}, nx::Shape({2, 2}))) < 1e-15);
+    const nx::NArray<double> int_expected = exp_by_eigh(nx::NArray<double>(std::vector<double>{2, 1, 1, 3}, nx::Shape({2, 2})));
+    CHECK(relative_error(la::expm(nx::NArray<int>(std::vector<int>{2, 1, 1, 3}, nx::Shape({2, 2}))), int_expected) < 1e-13);
+
+    // Complex: the exponential of a skew-Hermitian generator is a rotation
+    const double angle = 7.5;
+    const auto rotation = la::expm(nx::NArray<cd>(std::vector<cd>{0, -angle, angle, 0}, nx::Shape({2, 2})));
+    const nx::NArray<cd> expected_rotation(std::vector<cd>{std::cos(angle), -std::sin(angle), std::sin(angle), std::cos(angle)}, nx::Shape({2, 2}));
+    CHECK(relative_error(rotation, expected_rotation) < 1e-13);
+
+    // Single precision uses degrees up to 7 before scaling
+    for (const double norm : {0.3, 1.5, 3.0, 20.0}) {
+        const auto a = symmetric_with_norm(12, norm);
+        nx::NArray<float> af(a.get_shape());
+        for (size_t i = 0; i < a.get_total_size(); i++) af.get_data()[i] = static_cast<float>(a.get_data()[i]);
+        const auto result = la::expm(af);
+        const auto expected = exp_by_eigh(a);
+        double err = 0, scale = 0;
+        for (size_t i = 0; i < a.get_total_size(); i++) {
+            err = std::max(err, std::abs(static_cast<double>(result.get_data()[i]) - expected.get_data()[i]));
+            scale = std::max(scale, std::abs(expected.get_data()[i]));
+        }
+        CHECK(err / scale < 1e-5 * std::max(1.0, norm));
+    }
+
+    // matrix_power: p = 0 and 1, and positive powers of an integer matrix, which are exact
+    nx::NArray<long long> m(nx::Shape({5, 5}));
+    for (size_t i = 0; i < 25; i++) m.get_data()[i] = static_cast<long long>(i * i % 7) - 3;
+    CHECK(relative_error(la::matrix_power(m, 0), identity<long long>(5)) == 0);
+    CHECK(relative_error(la::matrix_power(m, 1), m) == 0);
+    for (const int p : {2, 5, 8, 13}) CHECK(relative_error(la::matrix_power(m, p), naive_power(m, p)) == 0);
+
+    // Negative powers: A^-2 * A^2 = I
+    const auto a = symmetric_with_norm(30, 5.0) + identity<double>(30) * 3.0;
+    const auto inverse_squared = la::matrix_power(a, -2);
+    CHECK(relative_error(naive_product(inverse_squared, la::matrix_power(a, 2)), identity<double>(30)) < 1e-12);
+    CHECK(relative_error(la::matrix_power(a, -1), la::inv(a)) < 1e-13);
+
+    // Negative powers need an invertible floating-point matrix
+    bool threw = false;
+    try { (void) la::matrix_power(m, -2); } catch (const nx::error::ValueError&) { threw = true; }
+    CHECK(threw);
+    threw = false;
+    try { (void) la::matrix_power(nx::NArray<double>(nx::Shape({3, 3}), 1.0), -1); } catch (const nx::error::LinAlgError&) { threw = true; }
+    CHECK(threw);
+
+    if (failures) std::cerr << failures << " check(s) failed\n";
+    return failures ? 1 : 0;
+}
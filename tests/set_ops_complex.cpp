@@ -0,0 +1,67 @@
+/* set_ops_complex.cpp */
+// Set operations on complex arrays must tell apart distinct values of the same magnitude
+#include <iostream>
+
+#include "NumXX.hpp"
+
+namespace nx = numxx;
+using cd = nx::complex<double>;
+
+static int failures = 0;
+
+#define CHECK(cond) \
+    do { if (!(cond)) { std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #cond "\n"; failures++; } } while (0)
+
+
+template <typename T>
+bool equals(const nx::NArray<T>& arr, const std::vector<T>& expected) {
+    if (arr.get_total_size() != expected.size()) return false;
+    for (size_t i = 0; i < expected.size(); i++)
+        if (!(arr.get_data()[i] == expected[i])) return false;
+    return true;
+}
+
+
+int main() {
+    const cd one(1, 0), minus_one(-1, 0), j(0, 1), minus_j(0, -1), two(2, 0);
+
+    // unique and unique_all: 1, -1, 1j and -1j share |z| but are four values
+    const nx::NArray<cd> a(std::vector<cd>{one, j, minus_one, one, minus_j, j});
+    CHECK(nx::unique(a).get_total_size() == 4);
+    const auto all = nx::unique_all(a);
+    CHECK(all.values.get_total_size() == 4);
+    CHECK(all.counts.get_total_size() == 4);
+    for (size_t i = 0; i < a.get_total_size(); i++)
+        CHECK(all.values.get_data()[all.inverse_indices.get_data()[i]] == a.get_data()[i]);
+    for (size_t i = 0; i < all.values.get_total_size(); i++) {
+        const cd v = all.values.get_data()[i];
+        const size_t expected = (v == one || v == j) ? 2 : 1;
+        CHECK(all.counts.get_data()[i] == expected);
+    }
+
+    // isin and in1d: equal magnitude is not membership
+    const nx::NArray<cd> only_one(std::vector<cd>{one});
+    CHECK(equals(nx::isin(nx::NArray<cd>(std::vector<cd>{j, one, minus_one}), only_one), {false, true, false}));
+    CHECK(equals(nx::isin(nx::NArray<cd>(std::vector<cd>{j}), only_one, true), {true}));
+    CHECK(equals(nx::in1d(a, nx::NArray<cd>(std::vector<cd>{minus_j, two})), {false, false, false, false, true, false}));
+
+    // isin through the sorted binary search path (unsorted operands)
+    const nx::NArray<cd> unsorted(std::vector<cd>{two, minus_one, j});
+    CHECK(equals(nx::isin(nx::NArray<cd>(std::vector<cd>{one, j, minus_j}), unsorted), {false, true, false}));
+
+    // intersect1d, setdiff1d and union1d
+    CHECK(nx::intersect1d(nx::NArray<cd>(std::vector<cd>{j}), only_one).get_total_size() == 0);
+    CHECK(equals(nx::intersect1d(a, nx::NArray<cd>(std::vector<cd>{minus_one, two})), {minus_one}));
+    CHECK(equals(nx::setdiff1d(nx::NArray<cd>(std::vector<cd>{j, one}), only_one), {j}));
+    CHECK(nx::setdiff1d(a, only_one).get_total_size() == 3);
+    CHECK(nx::union1d(only_one, nx::NArray<cd>(std::vector<cd>{j, minus_one, one})).get_total_size() == 3);
+
+    // NaNs: one value in unique, never a member
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const nx::NArray<cd> with_nan(std::vector<cd>{cd(nan, 0), one, cd(0, nan)});
+    CHECK(nx::unique(with_nan).get_total_size() == 2);
+    CHECK(equals(nx::isin(with_nan, with_nan), {false, true, false}));
+
+    if (failures) std::cerr << failures << " check(s) failed\n";
+    return failures ? 1 : 0;
+}
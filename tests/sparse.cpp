@@ -0,0 +1,182 @@
+/* sparse.cpp */
+// COO, CSR and CSC conversions, duplicate summing, transposes and products against dense arrays, on matrices
+// small enough to check by hand and large enough for the products to be split across threads
+#include <iostream>
+
+#include "NumXX.hpp"
+
+namespace nx = numxx;
+namespace sp = numxx::sparse;
+
+static int failures = 0;
+
+#define CHECK(cond) \
+    do { if (!(cond)) { std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #cond "\n"; failures++; } } while (0)
+
+
+// Deterministic integers in [0, bound)
+struct Lcg {
+    unsigned long long state;
+    size_t next(const size_t bound) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return static_cast<size_t>(state >> 33) % bound;
+    }
+};
+
+template <typename T>
+bool equals(const nx::NArray<T>& a, const nx::NArray<T>& b) {
+    if (!(a.get_shape() == b.get_shape())) return false;
+    for (size_t i = 0; i < a.get_total_size(); i++)
+        if (!(a.get_data()[i] == b.get_data()[i])) return false;
+    return true;
+}
+
+template <typename T>
+nx::NArray<T> dense_transpose(const nx::NArray<T>& a) {
+    const size_t m = a.get_shape()[0], n = a.get_shape()[1];
+    nx::NArray<T> out(nx::Shape({n, m}));
+    for (size_t i = 0; i < m; i++)
+        for (size_t j = 0; j < n; j++) out.get_data()[j * m + i] = a.get_data()[i * n + j];
+    return out;
+}
+
+// The product of the m x k matrix a and the k x n matrix b (n = 1 for a vector, whose shape is kept)
+template <typename T>
+nx::NArray<T> dense_product(const nx::NArray<T>& a, const nx::NArray<T>& b) {
+    const size_t m = a.get_shape()[0], k = a.get_shape()[1];
+    const size_t n = (b.get_shape().get_Ndim() == 1) ? 1 : b.get_shape()[1];
+    nx::NArray<T> out((n == 1 && b.get_shape().get_Ndim() == 1) ? nx::Shape({m}) : nx::Shape({m, n}), T(0));
+    for (size_t i = 0; i < m; i++)
+        for (size_t t = 0; t < k; t++)
+            for (size_t j = 0; j < n; j++) out.get_data()[i * n + j] += a.get_data()[i * k + t] * b.get_data()[t * n + j];
+    return out;
+}
+
+template <typename F>
+bool throws_value_error(F f) {
+    try { f(); } catch (const nx::error::ValueError&) { return true; }
+    return false;
+}
+
+template <typename F>
+bool throws_shape_error(F f) {
+    try { f(); } catch (const nx::error::ShapeError&) { return true; }
+    return false;
+}
+
+
+// A random rows x cols COO matrix with about `per_row` integer entries per row, some of them repeated, and the
+// dense matrix it sums to
+std::pair<sp::COO<double>, nx::NArray<double>> random_coo(
+    const size_t rows, const size_t cols, const size_t per_row, Lcg& rng
+) {
+    sp::COO<double> coo(rows, cols);
+    nx::NArray<double> dense(nx::Shape({rows, cols}), 0.0);
+    for (size_t p = 0; p < rows * per_row; p++) {
+        const size_t i = rng.next(rows), j = rng.next(cols);
+        const double v = static_cast<double>(rng.next(9)) - 4.0;
+        coo.insert(i, j, v);
+        dense.get_data()[i * cols + j] += v;
+        if (p % 5 == 0) {
+            coo.insert(i, j, 1.0);
+            dense.get_data()[i * cols + j] += 1.0;
+        }
+    }
+    return {std::move(coo), std::move(dense)};
+}
+
+void check_matrix(const sp::COO<double>& coo, const nx::NArray<double>& dense, Lcg& rng) {
+    const size_t rows = dense.get_shape()[0], cols = dense.get_shape()[1];
+    const auto csr = coo.to_csr();
+    const auto csc = coo.to_csc();
+
+    // Every format, and every conversion between them, holds the summed matrix
+    CHECK(equals(coo.to_dense(), dense));
+    CHECK(equals(csr.to_dense(), dense));
+    CHECK(equals(csc.to_dense(), dense));
+    CHECK(equals(csr.to_csc().to_dense(), dense));
+    CHECK(equals(csc.to_csr().to_dense(), dense));
+    CHECK(equals(csr.to_coo().to_dense(), dense));
+    CHECK(equals(csc.to_coo().to_dense(), dense));
+    CHECK(equals(sp::CSR<double>(dense).to_dense(), dense));
+    CHECK(equals(sp::CSC<double>(dense).to_dense(), dense));
+
+    // Duplicates are merged, so the compressed forms hold one entry per distinct position, sorted within a row
+    CHECK(csr.get_nnz() == csc.get_nnz());
+    CHECK(csr.get_nnz() <= coo.get_nnz());
+    bool sorted = true;
+    const auto& indptr = csr.get_indptr();
+    const auto& indices = csr.get_indices();
+    for (size_t r = 0; r < rows; r++)
+        for (size_t p = indptr[r] + 1; p < indptr[r + 1]; p++) sorted &= indices[p - 1] < indices[p];
+    CHECK(sorted);
+
+    // Transposes
+    const auto dense_t = dense_transpose(dense);
+    CHECK(equals(coo.transpose().to_dense(), dense_t));
+    CHECK(equals(csr.transpose().to_dense(), dense_t));
+    CHECK(equals(csc.transpose().to_dense(), dense_t));
+
+    // SpMV and SpMM, with integer entries so that every sum is exact
+    nx::NArray<double> x(nx::Shape({cols})), b(nx::Shape({cols, 5}));
+    for (size_t i = 0; i < x.get_total_size(); i++) x.get_data()[i] = static_cast<double>(rng.next(7)) - 3.0;
+    for (size_t i = 0; i < b.get_total_size(); i++) b.get_data()[i] = static_cast<double>(rng.next(7)) - 3.0;
+    const auto ax = dense_product(dense, x), ab = dense_product(dense, b);
+    CHECK(equals(csr.dot(x), ax));
+    CHECK(equals(csc.dot(x), ax));
+    CHECK(equals(csr.dot(b), ab));
+    CHECK(equals(csc.dot(b), ab));
+}
+
+
+int main() {
+    Lcg rng{7};
+
+    // A small matrix by hand: (0, 1) is stored three times and sums to 6
+    sp::COO<double> coo(3, 4);
+    coo.insert(0, 1, 1.0);
+    coo.insert(2, 3, 5.0);
+    coo.insert(0, 1, 2.0);
+    coo.insert(1, 0, -1.0);
+    coo.insert(0, 1, 3.0);
+    const auto csr = coo.to_csr();
+    CHECK(coo.get_nnz() == 5);
+    CHECK(csr.get_nnz() == 3);
+    CHECK((csr.get_indptr() == std::vector<size_t>{0, 1, 2, 3}));
+    CHECK((csr.get_indices() == std::vector<size_t>{1, 0, 3}));
+    CHECK((csr.get_values() == std::vector<double>{6.0, -1.0, 5.0}));
+    const auto csc = coo.to_csc();
+    CHECK((csc.get_indptr() == std::vector<size_t>{0, 1, 2, 2, 3}));
+    CHECK((csc.get_indices() == std::vector<size_t>{1, 0, 2}));
+
+    // Errors: out-of-range indices, inconsistent arrays and mismatched products
+    CHECK(throws_value_error([&] { coo.insert(3, 0, 1.0); }));
+    CHECK(throws_value_error([] { sp::COO<double>(2, 2, {0, 2}, {0, 0}, {1.0, 1.0}); }));
+    CHECK(throws_value_error([] { sp::COO<double>(2, 2, {0}, {0, 1}, {1.0}); }));
+    CHECK(throws_value_error([] { sp::CSR<double>(2, 2, {0, 2, 1}, {0, 1}, {1.0, 1.0}); }));
+    CHECK(throws_value_error([] { sp::CSC<double>(2, 2, {0, 1, 2}, {0, 2}, {1.0, 1.0}); }));
+    CHECK(throws_shape_error([&] { (void) csr.dot(nx::NArray<double>(nx::Shape({3}), 1.0)); }));
+    CHECK(throws_shape_error([&] { (void) csc.dot(nx::NArray<double>(nx::Shape({3, 2}), 1.0)); }));
+
+    for (const size_t threads : {1, 4}) {
+        // With four threads the large products go through parallel_for_rows and the partial sums of csc_spmv
+        nx::set_num_threads(threads);
+
+        const auto [small, small_dense] = random_coo(7, 5, 3, rng);
+        check_matrix(small, small_dense, rng);
+
+        // Empty rows and columns
+        const auto [empty, empty_dense] = random_coo(60, 40, 0, rng);
+        check_matrix(empty, empty_dense, rng);
+        const auto [wide, wide_dense] = random_coo(60, 400, 1, rng);
+        check_matrix(wide, wide_dense, rng);
+
+        // Above sparse_parallel_grain: about 100000 stored entries
+        const auto [large, large_dense] = random_coo(1500, 1000, 60, rng);
+        check_matrix(large, large_dense, rng);
+    }
+    nx::set_num_threads(0);
+
+    if (failures) std::cerr << failures << " check(s) failed\n";
+    return failures ? 1 : 0;
+}
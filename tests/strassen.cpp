@@ -0,0 +1,60 @@
+/* strassen.cpp */
+// MatmulAlgo::Strassen against MatmulAlgo::Standard: below the leaf size, and above it with odd dimensions
+// that the recursion has to peel off
+#include <iostream>
+
+#include "NumXX.hpp"
+
+namespace nx = numxx;
+
+static int failures = 0;
+
+#define CHECK(cond) \
+    do { if (!(cond)) { std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #cond "\n"; failures++; } } while (0)
+
+
+// Small integers: the sums and differences of the recursion stay exact, so it must match gemm exactly
+template <typename T>
+nx::NArray<T> filled(const size_t m, const size_t n, const int seed) {
+    nx::NArray<T> out(nx::Shape({m, n}));
+    for (size_t i = 0; i < m * n; i++) out.get_data()[i] = T(static_cast<int>((i * 7 + seed) % 9) - 4);
+    return out;
+}
+
+template <typename T>
+bool same_product(const size_t m, const size_t k, const size_t n, const nx::MatmulAlgo algo) {
+    const auto a = filled<T>(m, k, 1), b = filled<T>(k, n, 5);
+    const auto standard = nx::matmul(a, b, nx::MatmulAlgo::Standard);
+    const auto other = nx::matmul(a, b, algo);
+    if (!(standard.get_shape() == other.get_shape())) return false;
+    for (size_t i = 0; i < standard.get_total_size(); i++)
+        if (!(standard.get_data()[i] == other.get_data()[i])) return false;
+    return true;
+}
+
+
+int main() {
+    // Below the leaf size the Strassen option goes straight to gemm
+    CHECK(same_product<double>(301, 257, 199, nx::MatmulAlgo::Strassen));
+    CHECK(same_product<double>(301, 257, 199, nx::MatmulAlgo::Auto));
+
+    // One level of recursion, with an odd last row, column and inner index peeled off
+    CHECK(same_product<double>(1031, 1027, 1025, nx::MatmulAlgo::Strassen));
+
+    // Integers never take the recursion
+    CHECK(same_product<long long>(1025, 64, 1026, nx::MatmulAlgo::Strassen));
+
+    // Single precision is not exact here, so compare within the rounding error instead
+    const auto a = nx::random::rand(nx::Shape({1029, 1031})), b = nx::random::rand(nx::Shape({1031, 1027}));
+    nx::NArray<float> af(a.get_shape()), bf(b.get_shape());
+    for (size_t i = 0; i < a.get_total_size(); i++) af.get_data()[i] = static_cast<float>(a.get_data()[i]);
+    for (size_t i = 0; i < b.get_total_size(); i++) bf.get_data()[i] = static_cast<float>(b.get_data()[i]);
+    const auto standard = nx::matmul(af, bf), strassen = nx::matmul(af, bf, nx::MatmulAlgo::Strassen);
+    float err = 0;
+    for (size_t i = 0; i < standard.get_total_size(); i++)
+        err = std::max(err, std::abs(standard.get_data()[i] - strassen.get_data()[i]));
+    CHECK(err < 1e-2f);
+
+    if (failures) std::cerr << failures << " check(s) failed\n";
+    return failures ? 1 : 0;
+}